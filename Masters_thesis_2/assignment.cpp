@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <bit>
+#include <climits>
+#include <vector>
+
+#include "assignment.h"
+
+int MinCostAssignment(const int* pCost_, size_t countRows_, size_t countColumns_)
+{
+   if (countRows_ == 0)
+      return 0;
+
+   if (countColumns_ > ASSIGNMENT_MAX_COLUMNS_DP)
+      return MinCostAssignmentHungarian(pCost_, countRows_, countColumns_);
+
+   // dp[mask] - наименьшая стоимость назначения первых popcount(mask) строк столбцам mask.
+   thread_local std::vector<int> dp;
+   const size_t countMasks = size_t(1) << countColumns_;
+   dp.assign(countMasks, INT_MAX);
+   dp[0] = 0;
+
+   int best = INT_MAX;
+   for (size_t mask = 0; mask < countMasks; ++mask)
+   {
+      if (dp[mask] == INT_MAX)
+         continue;
+
+      const size_t iRow = std::popcount(mask);
+      if (iRow == countRows_)
+      {
+         best = std::min(best, dp[mask]);
+         continue;
+      }
+
+      const int* pRow = pCost_ + iRow * countColumns_;
+      for (size_t iColumn = 0; iColumn < countColumns_; ++iColumn)
+      {
+         const size_t bit = size_t(1) << iColumn;
+         if (!(mask & bit))
+            dp[mask | bit] = std::min(dp[mask | bit], dp[mask] + pRow[iColumn]);
+      }
+   }
+
+   return best;
+}
+
+int MinCostAssignmentHungarian(const int* pCost_, size_t countRows_, size_t countColumns_)
+{
+   if (countRows_ == 0)
+      return 0;
+
+   // Потенциалы строк u и столбцов v, p[j] - строка, назначенная столбцу j (нумерация с 1, 0 - нет).
+   thread_local std::vector<int> u, v, minv;
+   thread_local std::vector<size_t> p, way;
+   thread_local std::vector<char> used;
+
+   u.assign(countRows_ + 1, 0);
+   v.assign(countColumns_ + 1, 0);
+   p.assign(countColumns_ + 1, 0);
+   way.assign(countColumns_ + 1, 0);
+
+   auto cost = [pCost_, countColumns_](size_t iRow_, size_t iColumn_)
+   {
+      return pCost_[(iRow_ - 1) * countColumns_ + iColumn_ - 1];
+   };
+
+   for (size_t iRow = 1; iRow <= countRows_; ++iRow)
+   {
+      p[0] = iRow;
+      size_t j0 = 0;
+      minv.assign(countColumns_ + 1, INT_MAX);
+      used.assign(countColumns_ + 1, 0);
+
+      do
+      {
+         used[j0] = 1;
+         const size_t i0 = p[j0];
+         int delta = INT_MAX;
+         size_t j1 = 0;
+
+         for (size_t j = 1; j <= countColumns_; ++j)
+         {
+            if (used[j])
+               continue;
+
+            const int current = cost(i0, j) - u[i0] - v[j];
+            if (current < minv[j])
+            {
+               minv[j] = current;
+               way[j] = j0;
+            }
+
+            if (minv[j] < delta)
+            {
+               delta = minv[j];
+               j1 = j;
+            }
+         }
+
+         for (size_t j = 0; j <= countColumns_; ++j)
+         {
+            if (used[j])
+            {
+               u[p[j]] += delta;
+               v[j] -= delta;
+            }
+            else
+            {
+               minv[j] -= delta;
+            }
+         }
+
+         j0 = j1;
+      } while (p[j0] != 0);
+
+      do
+      {
+         const size_t j1 = way[j0];
+         p[j0] = p[j1];
+         j0 = j1;
+      } while (j0 != 0);
+   }
+
+   int total = 0;
+   for (size_t j = 1; j <= countColumns_; ++j)
+      if (p[j] != 0)
+         total += cost(p[j], j);
+
+   return total;
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <cstddef>
+
+// Наибольшее количество столбцов, при котором задача о назначениях решается перебором подмножеств (bitmask DP).
+constexpr size_t ASSIGNMENT_MAX_COLUMNS_DP = 10;
+
+// Возвращает наименьшую сумму стоимостей назначения каждой строки своему столбцу (столбцы не повторяются).
+// pCost_ - матрица countRows_ x countColumns_ по строкам, countRows_ <= countColumns_, стоимости неотрицательны.
+// До ASSIGNMENT_MAX_COLUMNS_DP столбцов - перебор подмножеств столбцов, больше - венгерский алгоритм.
+// Рабочие буферы - thread_local, после первых вызовов память не выделяется.
+int MinCostAssignment(const int* pCost_, size_t countRows_, size_t countColumns_);
+
+// То же венгерским алгоритмом при любом количестве столбцов.
+int MinCostAssignmentHungarian(const int* pCost_, size_t countRows_, size_t countColumns_);
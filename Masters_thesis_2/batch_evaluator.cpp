@@ -0,0 +1,543 @@
+#include <algorithm>
+#include <bit>
+#include <iterator>
+#include <map>
+
+#include <QElapsedTimer>
+
+#include "batch_evaluator.h"
+#include "predicate.h"
+#include "counter.h"
+#include "exception.h"
+
+// Возвращает countVariables_ в степени power_ (SIZE_MAX при переполнении).
+static size_t power(size_t countVariables_, size_t power_)
+{
+   size_t result = 1;
+   for (size_t i = 0; i < power_; ++i)
+   {
+      if (WillMultiplyOverflow(result, countVariables_))
+         return SIZE_MAX;
+
+      result *= countVariables_;
+   }
+
+   return result;
+}
+
+// Есть ли в условии предикат, все аргументы которого '~' (такое условие ложно).
+static bool hasOnlyAnyPredicate(const SCondition& condition_)
+{
+   bool bResult = false;
+   condition_.ForEachPredicate([&bResult](const SPredicateTemplate& predTempl_)
+      {
+         if (!predTempl_.arguments.empty() && std::all_of(predTempl_.arguments.begin(), predTempl_.arguments.end(), [](int arg_) { return arg_ == -1; }))
+            bResult = true;
+      });
+
+   return bResult;
+}
+
+// Узел префиксного дерева левых частей.
+struct CBatchEvaluator::SPrefixNode
+{
+   size_t idxLiteral = SIZE_MAX;      // литерал узла (у корня нет)
+   size_t idxParent = SIZE_MAX;       // родитель (у корня нет)
+   std::vector<size_t> vNewVariables; // переменные шаблона, впервые встречающиеся на пути в литерале узла
+   std::map<SPredicateTemplate, size_t> mapChildren; // дети по литералу
+   std::vector<size_t> vConditions;   // условия, левая часть которых заканчивается в узле
+   size_t countLive = 0;              // нерешенных условий в поддереве
+};
+
+// Условие блока EvaluatePrefixes.
+struct CBatchEvaluator::SPrefixCondition
+{
+   size_t idxNode = SIZE_MAX;         // узел конца левой части
+   std::vector<size_t> vRight;        // литералы правой части
+   std::vector<size_t> vNewVariables; // переменные шаблона, которых нет в левой части
+   bool bLive = false;                // нарушающая подстановка еще не найдена (у ложного по '~' - false сразу)
+};
+
+// Состояние обхода префиксного дерева.
+struct CBatchEvaluator::SPrefixState
+{
+   SEvaluationCounts& counts;
+   const std::function<void()>& checkStop;
+   std::vector<SLiteral> vLiterals;
+   std::vector<SPrefixNode> vNodes;
+   std::vector<SPrefixCondition> vConditions;
+   std::vector<size_t> vSubstitution; // значения переменных шаблона на текущем пути
+   std::vector<char> vUsed;           // занятые значения (подстановки без повторений)
+   size_t steps = 0;
+
+   void CheckStop()
+   {
+      if (checkStop && ++steps % STOP_CHECK_PERIOD == 0)
+         checkStop();
+   }
+};
+
+CBatchEvaluator::CBatchEvaluator(const CPredicatesStorage& storage_) :
+   m_storage(storage_), m_countVariables(storage_.CountVariables())
+{
+}
+
+bool CBatchEvaluator::IsSupported(const SCondition& condition_) const
+{
+   if (condition_.maxArgument + 1 > static_cast<int>(m_countVariables))
+      return false;
+
+   if (hasOnlyAnyPredicate(condition_))
+      return true;
+
+   bool bSupported = true;
+   condition_.ForEachPredicate([this, &bSupported](const SPredicateTemplate& predTempl_)
+      {
+         if (!bSupported)
+            return;
+
+         if (predTempl_.idxPredicate >= m_storage.CountPredicates())
+         {
+            bSupported = false;
+            return;
+         }
+
+         const size_t arity = predTempl_.arguments.size();
+         if (m_storage.GetPredicate(predTempl_.idxPredicate).table.size() != power(m_countVariables, arity))
+         {
+            bSupported = false;
+            return;
+         }
+
+         // IsTrueCondition хранит таблицу для '~' размером в количество размещений аргументов,
+         // а обращается к ней по индексу закрепленных аргументов.
+         const size_t countAny = std::count(predTempl_.arguments.begin(), predTempl_.arguments.end(), -1);
+         if (countAny != 0 && power(m_countVariables, arity - countAny) > NumberOfPlacements(m_countVariables, arity))
+            bSupported = false;
+      });
+
+   return bSupported;
+}
+
+quint64 CBatchEvaluator::Evaluate(const std::vector<const SCondition*>& vConditions_, SEvaluationCounts& counts_, const std::function<void()>& checkStop_) const
+{
+   if (vConditions_.empty())
+      return 0;
+
+   if (vConditions_.size() > MAX_CONDITIONS)
+      throw CException("Слишком много условий в блоке. Обратитесь к разработчику.", "Непредвиденная ошибка.", "CBatchEvaluator::Evaluate");
+
+   const int maxArgument = vConditions_.front()->maxArgument;
+   counts_.evaluations += vConditions_.size();
+
+   // Литералы блока, одинаковые литералы разных условий - один литерал.
+   std::vector<SLiteral> vLiterals;
+   std::map<SPredicateTemplate, size_t> mapLiterals;
+   std::vector<size_t> vLeft, vRight; // литералы левых и правых частей
+   quint64 live = 0;                  // условия, истинность которых еще не определена
+
+   QElapsedTimer timerAnyMap;
+   timerAnyMap.start();
+   bool bHasAny = false;
+
+   for (size_t iCond = 0; iCond < vConditions_.size(); ++iCond)
+   {
+      const SCondition& condition = *vConditions_[iCond];
+      if (condition.maxArgument != maxArgument)
+         throw CException("Условия блока с разным количеством переменных шаблона. Обратитесь к разработчику.", "Непредвиденная ошибка.", "CBatchEvaluator::Evaluate");
+
+      if (hasOnlyAnyPredicate(condition))
+         continue;
+
+      const quint64 lane = quint64(1) << iCond;
+      live |= lane;
+
+      auto addLiteral = [&](const SPredicateTemplate& predTempl_, bool bLeft_)
+         {
+            auto [it, bInserted] = mapLiterals.emplace(predTempl_, vLiterals.size());
+            if (bInserted)
+            {
+               bHasAny = bHasAny || std::find(predTempl_.arguments.begin(), predTempl_.arguments.end(), -1) != predTempl_.arguments.end();
+               vLiterals.push_back(compileLiteral(predTempl_, checkStop_));
+            }
+
+            SLiteral& literal = vLiterals[it->second];
+            quint64& lanes = bLeft_ ? literal.leftLanes : literal.rightLanes;
+            if (lanes == 0)
+               (bLeft_ ? vLeft : vRight).push_back(it->second);
+
+            lanes |= lane;
+         };
+
+      for (const auto& predTempl : condition.left)
+         addLiteral(predTempl, true);
+
+      for (const auto& predTempl : condition.right)
+         addLiteral(predTempl, false);
+   }
+
+   if (bHasAny)
+   {
+      ++counts_.anyMapBuilds;
+      counts_.anyMapTime += static_cast<quint64>(timerAnyMap.nsecsElapsed());
+   }
+
+   // Значение литерала на подстановке вычисляется один раз, даже если он стоит в обеих частях.
+   std::vector<size_t> vStamp(vLiterals.size(), SIZE_MAX);
+   std::vector<char> vValue(vLiterals.size(), 0);
+
+   CCounterWithoutRepeat<size_t> argCounter(0, m_countVariables, maxArgument + 1);
+   const size_t countIteration = argCounter.countIterations();
+   for (size_t iteration = 0; iteration < countIteration && live != 0; ++iteration, ++argCounter)
+   {
+      if (checkStop_ && iteration % STOP_CHECK_PERIOD == STOP_CHECK_PERIOD - 1)
+         checkStop_();
+
+      counts_.placements += std::popcount(live);
+      const std::vector<size_t>& vSubstitution = argCounter.get();
+
+      auto valueOnce = [&](size_t idxLiteral_)
+         {
+            if (vStamp[idxLiteral_] != iteration)
+            {
+               vValue[idxLiteral_] = value(vLiterals[idxLiteral_], vSubstitution, counts_);
+               vStamp[idxLiteral_] = iteration;
+            }
+
+            return vValue[idxLiteral_] != 0;
+         };
+
+      // Левая часть: условия, у которых нашелся ложный литерал, на этой подстановке выполнены (0->X = 1).
+      quint64 leftFalse = 0;
+      for (size_t idxLiteral : vLeft)
+      {
+         const quint64 lanes = vLiterals[idxLiteral].leftLanes;
+         if ((lanes & live & ~leftFalse) != 0 && !valueOnce(idxLiteral))
+            leftFalse |= lanes;
+      }
+
+      const quint64 pending = live & ~leftFalse;
+      counts_.leftFalseExits += std::popcount(live & leftFalse);
+      if (pending == 0)
+         continue;
+
+      // Правая часть: остальным нужен истинный литерал (X->1 = 1).
+      quint64 rightTrue = 0;
+      for (size_t idxLiteral : vRight)
+      {
+         const quint64 lanes = vLiterals[idxLiteral].rightLanes;
+         if ((lanes & pending & ~rightTrue) != 0 && valueOnce(idxLiteral))
+            rightTrue |= lanes;
+      }
+
+      counts_.rightTrueExits += std::popcount(pending & rightTrue);
+
+      // Условия без истинного литерала правой части ложны и выбывают из блока.
+      live &= ~(pending & ~rightTrue);
+   }
+
+   counts_.falseResults += vConditions_.size() - std::popcount(live);
+   return live;
+}
+
+std::vector<bool> CBatchEvaluator::EvaluatePrefixes(const std::vector<const SCondition*>& vConditions_, SEvaluationCounts& counts_, const std::function<void()>& checkStop_) const
+{
+   std::vector<bool> vResults(vConditions_.size(), false);
+   if (vConditions_.empty())
+      return vResults;
+
+   const int maxArgument = vConditions_.front()->maxArgument;
+   counts_.evaluations += vConditions_.size();
+
+   SPrefixState state{ counts_, checkStop_ };
+   state.vNodes.emplace_back(); // корень - пустая левая часть
+   state.vConditions.resize(vConditions_.size());
+
+   std::map<SPredicateTemplate, size_t> mapLiterals;
+   QElapsedTimer timerAnyMap;
+   timerAnyMap.start();
+   bool bHasAny = false;
+
+   auto literalIndex = [&](const SPredicateTemplate& predTempl_)
+      {
+         auto [it, bInserted] = mapLiterals.emplace(predTempl_, state.vLiterals.size());
+         if (bInserted)
+         {
+            bHasAny = bHasAny || std::find(predTempl_.arguments.begin(), predTempl_.arguments.end(), -1) != predTempl_.arguments.end();
+            state.vLiterals.push_back(compileLiteral(predTempl_, checkStop_));
+         }
+
+         return it->second;
+      };
+
+   for (size_t iCond = 0; iCond < vConditions_.size(); ++iCond)
+   {
+      const SCondition& condition = *vConditions_[iCond];
+      if (condition.maxArgument != maxArgument)
+         throw CException("Условия блока с разным количеством переменных шаблона. Обратитесь к разработчику.", "Непредвиденная ошибка.", "CBatchEvaluator::EvaluatePrefixes");
+
+      if (hasOnlyAnyPredicate(condition))
+         continue;
+
+      // Литералы левой части - конъюнкция, поэтому их порядок канонический (по возрастанию):
+      // условия с одинаковыми литералами левой части проходят по одним узлам.
+      TPartCondition left = condition.left;
+      std::sort(left.begin(), left.end());
+
+      std::vector<char> vBound(static_cast<size_t>(maxArgument + 1), 0);
+      size_t idxNode = 0;
+      for (const auto& predTempl : left)
+      {
+         auto [it, bInserted] = state.vNodes[idxNode].mapChildren.emplace(predTempl, state.vNodes.size());
+         const size_t idxChild = it->second;
+         if (bInserted)
+         {
+            SPrefixNode child;
+            child.idxLiteral = literalIndex(predTempl);
+            child.idxParent = idxNode;
+            for (int arg : predTempl.arguments)
+               if (arg != -1 && !vBound[arg] && std::find(child.vNewVariables.begin(), child.vNewVariables.end(), static_cast<size_t>(arg)) == child.vNewVariables.end())
+                  child.vNewVariables.push_back(static_cast<size_t>(arg));
+
+            state.vNodes.push_back(std::move(child));
+         }
+
+         for (int arg : predTempl.arguments)
+            if (arg != -1)
+               vBound[arg] = 1;
+
+         idxNode = idxChild;
+      }
+
+      SPrefixCondition& prefixCondition = state.vConditions[iCond];
+      prefixCondition.idxNode = idxNode;
+      prefixCondition.bLive = true;
+      for (const auto& predTempl : condition.right)
+      {
+         prefixCondition.vRight.push_back(literalIndex(predTempl));
+         for (int arg : predTempl.arguments)
+            if (arg != -1 && !vBound[arg])
+            {
+               vBound[arg] = 1;
+               prefixCondition.vNewVariables.push_back(static_cast<size_t>(arg));
+            }
+      }
+
+      state.vNodes[idxNode].vConditions.push_back(iCond);
+      for (size_t idx = idxNode; idx != SIZE_MAX; idx = state.vNodes[idx].idxParent)
+         ++state.vNodes[idx].countLive;
+   }
+
+   if (bHasAny)
+   {
+      ++counts_.anyMapBuilds;
+      counts_.anyMapTime += static_cast<quint64>(timerAnyMap.nsecsElapsed());
+   }
+
+   // Переменные шаблона, не встречающиеся в условии, значений не получают: их хватает, так как
+   // переменных шаблона не больше, чем переменных (IsSupported).
+   state.vSubstitution.assign(static_cast<size_t>(maxArgument + 1), SIZE_MAX);
+   state.vUsed.assign(m_countVariables, 0);
+   visitNode(state, 0);
+
+   for (size_t iCond = 0; iCond < vConditions_.size(); ++iCond)
+   {
+      vResults[iCond] = state.vConditions[iCond].bLive;
+      if (!vResults[iCond])
+         ++counts_.falseResults;
+   }
+
+   return vResults;
+}
+
+void CBatchEvaluator::visitNode(SPrefixState& state_, size_t idxNode_) const
+{
+   const SPrefixNode& node = state_.vNodes[idxNode_];
+
+   // Левая часть этих условий выполнена.
+   for (size_t idxCondition : node.vConditions)
+      if (state_.vConditions[idxCondition].bLive)
+         checkRight(state_, idxCondition);
+
+   for (const auto& [predTempl, idxChild] : node.mapChildren)
+   {
+      const SPrefixNode& child = state_.vNodes[idxChild];
+      if (child.countLive == 0)
+         continue;
+
+      auto onAssigned = [&]()
+         {
+            state_.CheckStop();
+            if (value(state_.vLiterals[child.idxLiteral], state_.vSubstitution, state_.counts))
+               visitNode(state_, idxChild);
+            else
+               ++state_.counts.leftFalseExits;
+
+            return child.countLive != 0;
+         };
+
+      assign(state_, child.vNewVariables, 0, onAssigned);
+   }
+}
+
+void CBatchEvaluator::checkRight(SPrefixState& state_, size_t idxCondition_) const
+{
+   SPrefixCondition& condition = state_.vConditions[idxCondition_];
+
+   auto onAssigned = [&]()
+      {
+         state_.CheckStop();
+         ++state_.counts.placements;
+         for (size_t idxLiteral : condition.vRight)
+            if (value(state_.vLiterals[idxLiteral], state_.vSubstitution, state_.counts))
+            {
+               ++state_.counts.rightTrueExits;
+               return true;
+            }
+
+         // Нашлась нарушающая подстановка - условие ложно.
+         condition.bLive = false;
+         for (size_t idx = condition.idxNode; idx != SIZE_MAX; idx = state_.vNodes[idx].idxParent)
+            --state_.vNodes[idx].countLive;
+
+         return false;
+      };
+
+   assign(state_, condition.vNewVariables, 0, onAssigned);
+}
+
+template<class TCallback>
+bool CBatchEvaluator::assign(SPrefixState& state_, const std::vector<size_t>& vVariables_, size_t iVariable_, TCallback& onAssigned_) const
+{
+   if (iVariable_ == vVariables_.size())
+      return onAssigned_();
+
+   const size_t variable = vVariables_[iVariable_];
+   bool bContinue = true;
+   for (size_t val = 0; val < m_countVariables && bContinue; ++val)
+   {
+      if (state_.vUsed[val])
+         continue;
+
+      state_.vUsed[val] = 1;
+      state_.vSubstitution[variable] = val;
+      bContinue = assign(state_, vVariables_, iVariable_ + 1, onAssigned_);
+      state_.vUsed[val] = 0;
+   }
+
+   state_.vSubstitution[variable] = SIZE_MAX;
+   return bContinue;
+}
+
+CBatchEvaluator::SLiteral CBatchEvaluator::compileLiteral(const SPredicateTemplate& predTempl_, const std::function<void()>& checkStop_) const
+{
+   SLiteral literal;
+   std::vector<int> vFixed; // аргументы, участвующие в индексе таблицы
+   if (std::find(predTempl_.arguments.begin(), predTempl_.arguments.end(), -1) != predTempl_.arguments.end())
+   {
+      buildExists(predTempl_, literal.vExists, checkStop_);
+      std::copy_if(predTempl_.arguments.begin(), predTempl_.arguments.end(), std::back_inserter(vFixed), [](int arg_) { return arg_ != -1; });
+   }
+   else
+   {
+      literal.pTable = &m_storage.GetPredicate(predTempl_.idxPredicate).table;
+      vFixed = predTempl_.arguments;
+   }
+
+   // Индекс = сумма переменная * множитель, повторяющиеся переменные объединяются.
+   size_t multiplier = 1;
+   for (auto itArg = vFixed.rbegin(); itArg != vFixed.rend(); ++itArg, multiplier *= m_countVariables)
+   {
+      const size_t variable = static_cast<size_t>(*itArg);
+      auto itTerm = std::find_if(literal.vTerms.begin(), literal.vTerms.end(), [variable](const auto& term_) { return term_.first == variable; });
+      if (itTerm == literal.vTerms.end())
+         literal.vTerms.emplace_back(variable, multiplier);
+      else
+         itTerm->second += multiplier;
+   }
+
+   return literal;
+}
+
+bool CBatchEvaluator::value(const SLiteral& literal_, const std::vector<size_t>& vSubstitution_, SEvaluationCounts& counts_)
+{
+   size_t index = 0;
+   for (const auto& [variable, multiplier] : literal_.vTerms)
+      index += vSubstitution_[variable] * multiplier;
+
+   if (literal_.pTable)
+   {
+      ++counts_.tableLookups;
+      return (*literal_.pTable)[index];
+   }
+
+   ++counts_.anyMapLookups;
+   return literal_.vExists[index] != 0;
+}
+
+void CBatchEvaluator::buildExists(const SPredicateTemplate& predTempl_, std::vector<char>& vExists_, const std::function<void()>& checkStop_) const
+{
+   const std::vector<int>& vArguments = predTempl_.arguments;
+   const size_t countAnyArg = std::count(vArguments.begin(), vArguments.end(), -1);
+   const std::vector<bool>& table = m_storage.GetPredicate(predTempl_.idxPredicate).table;
+
+   vExists_.assign(power(m_countVariables, vArguments.size() - countAnyArg), 0);
+
+   // Переменные шаблона нумеруются по порядку появления, '~' остается -1.
+   std::vector<int> vNewArg(vArguments.size(), -1);
+   std::map<int, int> mapReplace;
+   int maxArg = -1;
+   for (size_t iArg = 0; iArg < vArguments.size(); ++iArg)
+   {
+      if (vArguments[iArg] == -1)
+         continue;
+
+      auto itReplace = mapReplace.find(vArguments[iArg]);
+      if (itReplace == mapReplace.end())
+         itReplace = mapReplace.emplace(vArguments[iArg], ++maxArg).first;
+
+      vNewArg[iArg] = itReplace->second;
+   }
+
+   // Перебор тот же, что в IsTrueCondition: закрепленные аргументы - размещения без повторений,
+   // значения '~' - тоже, но независимо от закрепленных.
+   CCounterWithoutRepeat<size_t> counterArg(0, m_countVariables, vArguments.size() - countAnyArg);
+   const size_t countIteration = counterArg.countIterations();
+   const size_t countAnyIter = CCounterWithoutRepeat<size_t>(0, m_countVariables, countAnyArg).countIterations();
+   std::vector<size_t> vInstance(vArguments.size());
+   for (size_t iteration = 0; iteration < countIteration; ++iteration, ++counterArg)
+   {
+      if (checkStop_ && iteration % STOP_CHECK_PERIOD == STOP_CHECK_PERIOD - 1)
+         checkStop_();
+
+      const std::vector<size_t>& vSubstitution = counterArg.get();
+
+      size_t idxFixed = 0;
+      for (size_t iArg = 0; iArg < vNewArg.size(); ++iArg)
+         if (vNewArg[iArg] != -1)
+         {
+            vInstance[iArg] = vSubstitution[static_cast<size_t>(vNewArg[iArg])];
+            idxFixed = idxFixed * m_countVariables + vInstance[iArg];
+         }
+
+      if (vExists_[idxFixed])
+         continue;
+
+      CCounterWithoutRepeat<size_t> counterAnyArg(0, m_countVariables, countAnyArg);
+      for (size_t iterAny = 0; iterAny < countAnyIter; ++iterAny, ++counterAnyArg)
+      {
+         const std::vector<size_t>& vSubstAny = counterAnyArg.get();
+         size_t currentIdxSubst = 0;
+         size_t index = 0;
+         for (size_t iArg = 0; iArg < vNewArg.size(); ++iArg)
+            index = index * m_countVariables + (vNewArg[iArg] == -1 ? vSubstAny[currentIdxSubst++] : vInstance[iArg]);
+
+         if (table[index])
+         {
+            // Нашли хотя бы один экземпляр.
+            vExists_[idxFixed] = 1;
+            break;
+         }
+      }
+   }
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <functional>
+#include <vector>
+
+#include <QtGlobal>
+
+#include "parser_template_predicates.h"
+#include "evaluation_counters.h"
+
+class CPredicatesStorage;
+
+// Проверка истинности блока условий с общей работой для всего блока.
+// Результат для каждого условия тот же, что у CGeneticAlgorithm::IsTrueCondition.
+//
+// Evaluate перебирает подстановки переменных шаблона один раз на весь блок: на каждой подстановке литерал
+// (предикат с аргументами) вычисляется один раз для всех условий, в которых он встречается. Условия блока -
+// биты маски (дорожки): у литерала свои маски условий, в левой и правой частях которых он стоит. Условие выбывает
+// из блока, как только нашлась нарушающая его подстановка; перебор заканчивается, когда в блоке не осталось условий.
+//
+// EvaluatePrefixes строит префиксное дерево левых частей (литералы в каноническом порядке) и обходит его в глубину:
+// значения переменных литерала узла перебираются только для значений, при которых выполнены литералы предков,
+// поэтому общее начало левых частей разных условий вычисляется один раз. В узле конца левой части условия
+// проверяется его правая часть при всех значениях оставшихся переменных.
+class CBatchEvaluator
+{
+public:
+
+   // Наибольшее количество условий в блоке Evaluate (разрядность маски).
+   static constexpr size_t MAX_CONDITIONS = 64;
+
+   // Через сколько подстановок вызывается проверка остановки (степень двойки).
+   static constexpr size_t STOP_CHECK_PERIOD = 4096;
+
+   explicit CBatchEvaluator(const CPredicatesStorage& storage_);
+
+   // Можно ли проверить условие в блоке. Иначе (некорректные размеры таблиц, переменных шаблона больше,
+   // чем переменных) условие проверяется IsTrueCondition, в том числе с ее ошибками.
+   bool IsSupported(const SCondition& condition_) const;
+
+   // Проверяет условия vConditions_: не больше MAX_CONDITIONS поддерживаемых условий с одинаковым
+   // количеством переменных шаблона. Возвращает маску истинных условий (бит i - условие vConditions_[i]).
+   // Счетчики проверки всего блока добавляются к counts_.
+   // checkStop_ вызывается каждые STOP_CHECK_PERIOD подстановок и может бросить исключение.
+   quint64 Evaluate(const std::vector<const SCondition*>& vConditions_, SEvaluationCounts& counts_, const std::function<void()>& checkStop_ = {}) const;
+
+   // То же по префиксному дереву левых частей, количество условий не ограничено.
+   // Возвращает истинность условий. В счетчиках подстановки - проверки правой части, ложная левая часть -
+   // отброшенные значения переменных литерала левой части.
+   std::vector<bool> EvaluatePrefixes(const std::vector<const SCondition*>& vConditions_, SEvaluationCounts& counts_, const std::function<void()>& checkStop_ = {}) const;
+
+private:
+
+   const CPredicatesStorage& m_storage;
+   const size_t m_countVariables;
+
+   // Литерал блока.
+   struct SLiteral
+   {
+      const std::vector<bool>* pTable = nullptr; // таблица истинности предиката (для литерала без '~')
+      std::vector<char> vExists;                 // для литерала с '~': есть ли значение '~' при закрепленных аргументах
+      std::vector<std::pair<size_t, size_t>> vTerms; // переменная шаблона и ее множитель в индексе таблицы
+      quint64 leftLanes = 0;                     // условия, в левой части которых стоит литерал
+      quint64 rightLanes = 0;                    // условия, в правой части которых стоит литерал
+   };
+
+   struct SPrefixNode;
+   struct SPrefixCondition;
+   struct SPrefixState;
+
+   // Возвращает литерал для predTempl_ (для литерала с '~' строится таблица vExists).
+   SLiteral compileLiteral(const SPredicateTemplate& predTempl_, const std::function<void()>& checkStop_) const;
+
+   // Возвращает значение литерала при значениях переменных шаблона vSubstitution_.
+   static bool value(const SLiteral& literal_, const std::vector<size_t>& vSubstitution_, SEvaluationCounts& counts_);
+
+   // Заполняет для литерала predTempl_ с '~' таблицу vExists_ так же, как IsTrueCondition (mapPredAnyArg).
+   void buildExists(const SPredicateTemplate& predTempl_, std::vector<char>& vExists_, const std::function<void()>& checkStop_) const;
+
+   // Обходит поддерево узла idxNode_ префиксного дерева (литералы пути до узла выполнены).
+   void visitNode(SPrefixState& state_, size_t idxNode_) const;
+
+   // Проверяет правую часть условия idxCondition_ при всех значениях ее несвязанных переменных.
+   void checkRight(SPrefixState& state_, size_t idxCondition_) const;
+
+   // Перебирает значения переменных vVariables_ начиная с iVariable_ без повторений с уже связанными
+   // и для каждого набора вызывает onAssigned_. Перебор прекращается, если onAssigned_ вернул false.
+   template<class TCallback>
+   bool assign(SPrefixState& state_, const std::vector<size_t>& vVariables_, size_t iVariable_, TCallback& onAssigned_) const;
+};
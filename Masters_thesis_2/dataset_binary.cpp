@@ -0,0 +1,158 @@
+#include <QDataStream>
+#include <QIODevice>
+
+#include "dataset_binary.h"
+#include "predicate.h"
+#include "exception.h"
+
+// Сообщение о некорректном файле.
+static const QString INVALID_DATA("Некорректный двоичный файл данных: %1");
+
+// Настраивает поток под параметры формата.
+static void setupStream(QDataStream& stream_)
+{
+   stream_.setByteOrder(QDataStream::LittleEndian);
+   stream_.setVersion(QDataStream::Qt_6_0);
+}
+
+// Проверяет состояние потока после чтения.
+// !> exception при ошибке чтения.
+static void checkRead(const QDataStream& stream_, const QString& what_)
+{
+   if (stream_.status() != QDataStream::Ok)
+      throw CException(INVALID_DATA.arg(what_), "Ошибка загрузки данных", "ReadBinaryDataset");
+}
+
+bool IsBinaryDataset(QIODevice* device_)
+{
+   const QByteArray head = device_->peek(sizeof(quint32));
+   if (head.size() != sizeof(quint32))
+      return false;
+
+   quint32 magic = 0;
+   QDataStream stream(head);
+   setupStream(stream);
+   stream >> magic;
+
+   return magic == DATASET_BINARY_MAGIC;
+}
+
+void WriteBinaryDataset(QIODevice* device_, const CPredicatesStorage& storage_, const QString& conditions_)
+{
+   QDataStream stream(device_);
+   setupStream(stream);
+
+   stream << DATASET_BINARY_MAGIC << DATASET_BINARY_VERSION;
+
+   const CSymbolTable& variables = storage_.GetVariables();
+   stream << static_cast<quint32>(variables.Size());
+   for (size_t iVar = 0; iVar < variables.Size(); ++iVar)
+      stream << variables.Name(iVar).toString();
+
+   stream << static_cast<quint32>(storage_.CountPredicates());
+
+   QByteArray bits;
+   for (size_t iPred = 0; iPred < storage_.CountPredicates(); ++iPred)
+   {
+      const std::vector<bool>& table = storage_.GetPredicate(iPred).table;
+
+      stream << storage_.GetPredicateName(iPred) << static_cast<quint8>(storage_.CountArguments(iPred));
+
+      bits.fill('\0', static_cast<qsizetype>((table.size() + 7) / 8));
+      for (size_t iArg = 0; iArg < table.size(); ++iArg)
+         if (table[iArg])
+            bits[iArg / 8] = static_cast<char>(bits[iArg / 8] | (1 << (iArg % 8)));
+
+      stream.writeRawData(bits.constData(), static_cast<int>(bits.size()));
+   }
+
+   stream << conditions_;
+
+   if (stream.status() != QDataStream::Ok)
+      throw CException("Ошибка записи двоичного файла данных.", "Ошибка сохранения данных", "WriteBinaryDataset");
+}
+
+QString ReadBinaryDataset(QIODevice* device_, CPredicatesStorage& storage_)
+{
+   if (!storage_.IsEmpty())
+      throw CException("Хранилище предикатов должно быть пустым.", "Ошибка загрузки данных", "ReadBinaryDataset");
+
+   QDataStream stream(device_);
+   setupStream(stream);
+
+   quint32 magic = 0, version = 0;
+   stream >> magic >> version;
+   checkRead(stream, "нет заголовка.");
+
+   if (magic != DATASET_BINARY_MAGIC)
+      throw CException(INVALID_DATA.arg("неверная сигнатура."), "Ошибка загрузки данных", "ReadBinaryDataset");
+
+   if (version != DATASET_BINARY_VERSION)
+      throw CException(INVALID_DATA.arg(QString("неподдерживаемая версия %1.").arg(version)), "Ошибка загрузки данных", "ReadBinaryDataset");
+
+   // переменные
+
+   quint32 countVariables = 0;
+   stream >> countVariables;
+   checkRead(stream, "нет количества переменных.");
+
+   // Имя переменной занимает не менее 4 байт.
+   if (!device_->isSequential() && countVariables > device_->bytesAvailable() / 4)
+      throw CException(INVALID_DATA.arg("некорректное количество переменных."), "Ошибка загрузки данных", "ReadBinaryDataset");
+
+   std::vector<QString> vVariables(countVariables);
+   for (auto& var : vVariables)
+      stream >> var;
+
+   checkRead(stream, "не удалось считать имена переменных.");
+
+   if (!storage_.SetVariables(vVariables))
+      throw CException(INVALID_DATA.arg("повторяющиеся имена переменных."), "Ошибка загрузки данных", "ReadBinaryDataset");
+
+   // предикаты
+
+   quint32 countPredicates = 0;
+   stream >> countPredicates;
+   checkRead(stream, "нет количества предикатов.");
+
+   QByteArray bits;
+   for (quint32 iPred = 0; iPred < countPredicates; ++iPred)
+   {
+      QString name;
+      quint8 countArg = 0;
+      stream >> name >> countArg;
+      checkRead(stream, QString("не удалось считать заголовок предиката %1.").arg(iPred));
+
+      size_t tableSize = 1;
+      for (quint8 iArg = 0; iArg < countArg; ++iArg)
+      {
+         if (countVariables == 0 || tableSize > SIZE_MAX / countVariables)
+            throw CException(INVALID_DATA.arg(QString("слишком большая таблица истинности у предиката \"%1\".").arg(name)), "Ошибка загрузки данных", "ReadBinaryDataset");
+
+         tableSize *= countVariables;
+      }
+
+      const size_t countBytes = (tableSize + 7) / 8;
+      if (!device_->isSequential() && countBytes > static_cast<size_t>(device_->bytesAvailable()))
+         throw CException(INVALID_DATA.arg(QString("таблица истинности предиката \"%1\" обрезана.").arg(name)), "Ошибка загрузки данных", "ReadBinaryDataset");
+
+      bits.resize(static_cast<qsizetype>(countBytes));
+      if (stream.readRawData(bits.data(), static_cast<int>(countBytes)) != static_cast<int>(countBytes))
+         throw CException(INVALID_DATA.arg(QString("таблица истинности предиката \"%1\" обрезана.").arg(name)), "Ошибка загрузки данных", "ReadBinaryDataset");
+
+      SPredicate predicate;
+      predicate.table.resize(tableSize);
+      for (size_t iArg = 0; iArg < tableSize; ++iArg)
+         predicate.table[iArg] = (bits[iArg / 8] >> (iArg % 8)) & 1;
+
+      storage_.AddPredicate(name, std::move(predicate));
+   }
+
+   // условия
+
+   QString conditions;
+   stream >> conditions;
+   checkRead(stream, "нет раздела условий целостности.");
+
+   return conditions;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <QString>
+
+class QIODevice;
+class CPredicatesStorage;
+
+// Двоичный формат файла данных (для больших наборов, быстрее текстового).
+// Порядок байт - little-endian, строки - QDataStream (Qt_6_0).
+//
+// quint32 сигнатура (DATASET_BINARY_MAGIC), quint32 версия
+// quint32 количество переменных, имена переменных
+// quint32 количество предикатов, для каждого: имя, quint8 количество аргументов,
+//    таблица истинности по биту на значение (младший бит первый), размер - (N^M + 7) / 8 байт
+// Текст раздела условий целостности (как в текстовом формате).
+
+// Сигнатура двоичного файла данных ("MT2D").
+constexpr quint32 DATASET_BINARY_MAGIC = 0x4432544D;
+constexpr quint32 DATASET_BINARY_VERSION = 1;
+
+// Возвращает true, если данные device_ начинаются с сигнатуры двоичного формата.
+// Позиция чтения не изменяется.
+bool IsBinaryDataset(QIODevice* device_);
+
+// Записывает переменные и предикаты storage_ и текст условий conditions_ в device_.
+// !> exception при ошибке записи.
+void WriteBinaryDataset(QIODevice* device_, const CPredicatesStorage& storage_, const QString& conditions_);
+
+// Считывает переменные и предикаты из device_ в storage_ (storage_ должно быть пустым).
+// Возвращает текст раздела условий целостности.
+// !> exception при некорректных данных или ошибке чтения.
+QString ReadBinaryDataset(QIODevice* device_, CPredicatesStorage& storage_);
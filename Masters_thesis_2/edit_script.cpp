@@ -0,0 +1,403 @@
+#include <algorithm>
+#include <tuple>
+
+#include "edit_script.h"
+#include "exception.h"
+
+bool SEdit::operator<(const SEdit& edit_) const
+{
+   return std::tie(part, position, type, argument) < std::tie(edit_.part, edit_.position, edit_.type, edit_.argument);
+}
+
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-= Методы класса =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+CEditScript::TBase CEditScript::Describe(const SCondition& original_)
+{
+   TBase base;
+
+   for (int iPart = 0; iPart < 2; ++iPart)
+   {
+      const TPartCondition& part = iPart ? original_.right : original_.left;
+      SBasePart& basePart = base[iPart];
+
+      for (const auto& predTempl : part)
+      {
+         const size_t countVariables = std::count_if(predTempl.arguments.begin(), predTempl.arguments.end(), [](int arg_) { return arg_ != -1; });
+
+         basePart.totalArg += predTempl.arguments.size();
+         basePart.vVariables.push_back(countVariables);
+         basePart.vPredicates.push_back(predTempl.idxPredicate);
+         if (countVariables == 0)
+            ++basePart.countNoVariables;
+      }
+
+      std::sort(basePart.vPredicates.begin(), basePart.vPredicates.end());
+      basePart.bDistinct = std::adjacent_find(basePart.vPredicates.begin(), basePart.vPredicates.end()) == basePart.vPredicates.end();
+   }
+
+   return base;
+}
+
+const std::vector<SEdit>& CEditScript::Edits() const
+{
+   return m_vEdits;
+}
+
+const TPartCondition& CEditScript::Inserted(int part_) const
+{
+   return m_aInserted.at(part_);
+}
+
+size_t CEditScript::CountEdits() const
+{
+   return m_vEdits.size() + m_aInserted[0].size() + m_aInserted[1].size();
+}
+
+bool CEditScript::IsDeleted(int part_, size_t position_) const
+{
+   SEdit edit;
+   edit.type = eEditDelete;
+   edit.part = static_cast<quint8>(part_);
+   edit.position = static_cast<quint16>(position_);
+
+   return std::binary_search(m_vEdits.begin(), m_vEdits.end(), edit);
+}
+
+int CEditScript::Argument(const SCondition& original_, int part_, size_t position_, size_t argument_) const
+{
+   SEdit edit;
+   edit.part = static_cast<quint8>(part_);
+   edit.position = static_cast<quint16>(position_);
+   edit.argument = static_cast<quint16>(argument_);
+
+   auto it = std::lower_bound(m_vEdits.begin(), m_vEdits.end(), edit);
+   if (it != m_vEdits.end() && !(edit < *it))
+      return it->value;
+
+   return (part_ ? original_.right : original_.left).at(position_).arguments.at(argument_);
+}
+
+void CEditScript::SetArgument(const SCondition& original_, int part_, size_t position_, size_t argument_, int value_)
+{
+   const TPartCondition& part = part_ ? original_.right : original_.left;
+   if (position_ >= part.size() || argument_ >= part[position_].arguments.size() || IsDeleted(part_, position_))
+      throw CException("Замена несуществующего аргумента. Обратитесь к разработчику.", "Непредвиденная ошибка.", "CEditScript::SetArgument");
+
+   SEdit edit;
+   edit.part = static_cast<quint8>(part_);
+   edit.position = static_cast<quint16>(position_);
+   edit.argument = static_cast<quint16>(argument_);
+   edit.value = value_;
+
+   auto it = std::lower_bound(m_vEdits.begin(), m_vEdits.end(), edit);
+   const bool bFound = it != m_vEdits.end() && !(edit < *it);
+
+   if (value_ == part[position_].arguments[argument_])
+   {
+      if (bFound)
+         m_vEdits.erase(it);
+   }
+   else if (bFound)
+   {
+      it->value = value_;
+   }
+   else
+   {
+      m_vEdits.insert(it, edit);
+   }
+}
+
+void CEditScript::Delete(int part_, size_t position_)
+{
+   std::erase_if(m_vEdits, [part_, position_](const SEdit& edit_)
+      {
+         return edit_.part == part_ && edit_.position == position_;
+      });
+
+   SEdit edit;
+   edit.type = eEditDelete;
+   edit.part = static_cast<quint8>(part_);
+   edit.position = static_cast<quint16>(position_);
+
+   m_vEdits.insert(std::lower_bound(m_vEdits.begin(), m_vEdits.end(), edit), edit);
+}
+
+void CEditScript::Insert(int part_, const SPredicateTemplate& predTempl_)
+{
+   m_aInserted.at(part_).push_back(predTempl_);
+}
+
+void CEditScript::SetInsertedArgument(int part_, size_t index_, size_t argument_, int value_)
+{
+   m_aInserted.at(part_).at(index_).arguments.at(argument_) = value_;
+}
+
+void CEditScript::EraseInserted(int part_, size_t index_)
+{
+   TPartCondition& inserted = m_aInserted.at(part_);
+   inserted.erase(inserted.begin() + index_);
+}
+
+SCondition CEditScript::Materialize(const SCondition& original_) const
+{
+   SCondition condition;
+
+   auto itEdit = m_vEdits.begin();
+   for (int iPart = 0; iPart < 2; ++iPart)
+   {
+      const TPartCondition& part = iPart ? original_.right : original_.left;
+      TPartCondition& result = iPart ? condition.right : condition.left;
+      result.reserve(part.size() + m_aInserted[iPart].size());
+
+      // Правки упорядочены по части и предикату, поэтому проходятся один раз.
+      for (size_t iPred = 0; iPred < part.size(); ++iPred)
+      {
+         SPredicateTemplate predTempl = part[iPred];
+         bool bDeleted = false;
+
+         for (; itEdit != m_vEdits.end() && itEdit->part == iPart && itEdit->position == iPred; ++itEdit)
+         {
+            if (itEdit->type == eEditDelete)
+               bDeleted = true;
+            else
+               predTempl.arguments.at(itEdit->argument) = itEdit->value;
+         }
+
+         if (!bDeleted)
+            result.push_back(std::move(predTempl));
+      }
+
+      result.insert(result.end(), m_aInserted[iPart].begin(), m_aInserted[iPart].end());
+   }
+
+   condition.RecalculateMaximum();
+   return condition;
+}
+
+std::vector<int> CEditScript::Key() const
+{
+   std::vector<int> key;
+   key.reserve(1 + m_vEdits.size() * 5 + 2 + CountEdits() * 4);
+
+   key.push_back(static_cast<int>(m_vEdits.size()));
+   for (const auto& edit : m_vEdits)
+   {
+      key.push_back(edit.type);
+      key.push_back(edit.part);
+      key.push_back(edit.position);
+      key.push_back(edit.argument);
+      key.push_back(edit.value);
+   }
+
+   for (const auto& inserted : m_aInserted)
+   {
+      key.push_back(static_cast<int>(inserted.size()));
+      for (const auto& predTempl : inserted)
+      {
+         key.push_back(static_cast<int>(predTempl.idxPredicate));
+         key.push_back(static_cast<int>(predTempl.arguments.size()));
+         key.insert(key.end(), predTempl.arguments.begin(), predTempl.arguments.end());
+      }
+   }
+
+   return key;
+}
+
+CEditScript CEditScript::FromCondition(const SCondition& original_, const SCondition& condition_)
+{
+   CEditScript script;
+
+   for (int iPart = 0; iPart < 2; ++iPart)
+   {
+      const TPartCondition& part = iPart ? original_.right : original_.left;
+      std::vector<char> vMatched(part.size(), 0);
+
+      for (const auto& predTempl : iPart ? condition_.right : condition_.left)
+      {
+         size_t position = 0;
+         while (position < part.size() && (vMatched[position] || part[position].idxPredicate != predTempl.idxPredicate
+            || part[position].arguments.size() != predTempl.arguments.size()))
+            ++position;
+
+         if (position == part.size())
+         {
+            script.Insert(iPart, predTempl);
+            continue;
+         }
+
+         vMatched[position] = 1;
+         for (size_t iArg = 0; iArg < predTempl.arguments.size(); ++iArg)
+            if (predTempl.arguments[iArg] != part[position].arguments[iArg])
+               script.SetArgument(original_, iPart, position, iArg, predTempl.arguments[iArg]);
+      }
+
+      for (size_t position = 0; position < part.size(); ++position)
+         if (!vMatched[position])
+            script.Delete(iPart, position);
+   }
+
+   return script;
+}
+
+size_t CEditScript::CountPredicates(const SCondition& original_, int part_) const
+{
+   const size_t countDeleted = std::count_if(m_vEdits.begin(), m_vEdits.end(), [part_](const SEdit& edit_)
+      {
+         return edit_.part == part_ && edit_.type == eEditDelete;
+      });
+
+   return (part_ ? original_.right : original_.left).size() - countDeleted + m_aInserted.at(part_).size();
+}
+
+SPredicateTemplate CEditScript::Predicate(const SCondition& original_, int part_, size_t index_) const
+{
+   const auto [position, iInserted] = locate(original_, part_, index_);
+   if (position == SIZE_MAX)
+      return m_aInserted[part_][iInserted];
+
+   SPredicateTemplate predTempl = (part_ ? original_.right : original_.left)[position];
+   for (size_t iArg = 0; iArg < predTempl.arguments.size(); ++iArg)
+      predTempl.arguments[iArg] = Argument(original_, part_, position, iArg);
+
+   return predTempl;
+}
+
+void CEditScript::SetPredicateArgument(const SCondition& original_, int part_, size_t index_, size_t argument_, int value_)
+{
+   const auto [position, iInserted] = locate(original_, part_, index_);
+   if (position == SIZE_MAX)
+      SetInsertedArgument(part_, iInserted, argument_, value_);
+   else
+      SetArgument(original_, part_, position, argument_, value_);
+}
+
+void CEditScript::ReplacePredicate(const SCondition& original_, int part_, size_t index_, const SPredicateTemplate& predTempl_)
+{
+   const auto [position, iInserted] = locate(original_, part_, index_);
+   if (position == SIZE_MAX)
+   {
+      m_aInserted[part_][iInserted] = predTempl_;
+      return;
+   }
+
+   // Тот же предикат остается на месте, меняются только аргументы.
+   const SPredicateTemplate& originalPred = (part_ ? original_.right : original_.left)[position];
+   if (originalPred.idxPredicate == predTempl_.idxPredicate && originalPred.arguments.size() == predTempl_.arguments.size())
+   {
+      for (size_t iArg = 0; iArg < predTempl_.arguments.size(); ++iArg)
+         SetArgument(original_, part_, position, iArg, predTempl_.arguments[iArg]);
+
+      return;
+   }
+
+   Delete(part_, position);
+   Insert(part_, predTempl_);
+}
+
+void CEditScript::Restore(int part_, size_t position_)
+{
+   std::erase_if(m_vEdits, [part_, position_](const SEdit& edit_)
+      {
+         return edit_.part == part_ && edit_.position == position_;
+      });
+}
+
+void CEditScript::CopyPredicate(const CEditScript& source_, int part_, size_t position_)
+{
+   Restore(part_, position_);
+
+   auto isPredicate = [part_, position_](const SEdit& edit_) { return edit_.part == part_ && edit_.position == position_; };
+   auto itBegin = std::find_if(source_.m_vEdits.begin(), source_.m_vEdits.end(), isPredicate);
+   auto itEnd = std::find_if_not(itBegin, source_.m_vEdits.end(), isPredicate);
+   if (itBegin == itEnd)
+      return;
+
+   // Правки одного предиката идут подряд и на своем месте остаются упорядоченными.
+   m_vEdits.insert(std::lower_bound(m_vEdits.begin(), m_vEdits.end(), *itBegin), itBegin, itEnd);
+}
+
+int CEditScript::MaxArgument(const SCondition& original_) const
+{
+   int maxArgument = -1;
+
+   for (int iPart = 0; iPart < 2; ++iPart)
+   {
+      const TPartCondition& part = iPart ? original_.right : original_.left;
+      for (size_t iPred = 0; iPred < part.size(); ++iPred)
+      {
+         if (IsDeleted(iPart, iPred))
+            continue;
+
+         for (size_t iArg = 0; iArg < part[iPred].arguments.size(); ++iArg)
+            maxArgument = std::max(maxArgument, Argument(original_, iPart, iPred, iArg));
+      }
+
+      for (const auto& predTempl : m_aInserted[iPart])
+         for (int arg : predTempl.arguments)
+            maxArgument = std::max(maxArgument, arg);
+   }
+
+   return maxArgument;
+}
+
+void CEditScript::Normalize(const SCondition& original_)
+{
+   // Новые номера в порядке появления в материализованном условии (как у ForEachArgument).
+   std::vector<int> vNumbers;
+   int countNumbers = 0;
+   auto number = [&vNumbers, &countNumbers](int arg_)
+      {
+         if (arg_ == -1)
+            return -1;
+
+         if (static_cast<size_t>(arg_) >= vNumbers.size())
+            vNumbers.resize(static_cast<size_t>(arg_) + 1, -1);
+
+         if (vNumbers[arg_] == -1)
+            vNumbers[arg_] = countNumbers++;
+
+         return vNumbers[arg_];
+      };
+
+   for (int iPart = 0; iPart < 2; ++iPart)
+   {
+      const TPartCondition& part = iPart ? original_.right : original_.left;
+      for (size_t iPred = 0; iPred < part.size(); ++iPred)
+      {
+         if (IsDeleted(iPart, iPred))
+            continue;
+
+         for (size_t iArg = 0; iArg < part[iPred].arguments.size(); ++iArg)
+         {
+            const int arg = Argument(original_, iPart, iPred, iArg);
+            const int newArg = number(arg);
+            if (newArg != arg)
+               SetArgument(original_, iPart, iPred, iArg, newArg);
+         }
+      }
+
+      for (auto& predTempl : m_aInserted[iPart])
+         for (int& arg : predTempl.arguments)
+            arg = number(arg);
+   }
+}
+
+std::pair<size_t, size_t> CEditScript::locate(const SCondition& original_, int part_, size_t index_) const
+{
+   const TPartCondition& part = part_ ? original_.right : original_.left;
+   for (size_t position = 0; position < part.size(); ++position)
+   {
+      if (IsDeleted(part_, position))
+         continue;
+
+      if (index_ == 0)
+         return { position, 0 };
+
+      --index_;
+   }
+
+   if (index_ >= m_aInserted.at(part_).size())
+      throw CException("Обращение к несуществующему предикату. Обратитесь к разработчику.", "Непредвиденная ошибка.", "CEditScript::locate");
+
+   return { SIZE_MAX, index_ };
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include <array>
+#include <utility>
+#include <vector>
+
+#include "parser_template_predicates.h"
+
+// Вид правки предиката изначального условия.
+enum EEditType : quint8
+{
+   eEditArgument, // замена аргумента
+   eEditDelete,   // удаление предиката
+};
+
+// Правка предиката изначального условия.
+struct SEdit
+{
+   EEditType type = eEditArgument;
+   quint8 part = 0;      // 0 - левая часть, 1 - правая
+   quint16 position = 0; // номер предиката в части изначального условия
+   quint16 argument = 0; // номер аргумента (для замены)
+   int value = -1;       // новый аргумент (для замены)
+
+   // Порядок: часть, предикат, вид, аргумент.
+   bool operator<(const SEdit& edit_) const;
+};
+
+// Условие в виде правок изначального: замены аргументов и удаления его предикатов (упорядочены, без повторов)
+// и добавленные предикаты. Материализованное условие - оставшиеся предикаты изначального в прежнем порядке,
+// за ними добавленные. Изначальное условие не хранится и передается в методы.
+class CEditScript
+{
+   std::vector<SEdit> m_vEdits;
+   std::array<TPartCondition, 2> m_aInserted;
+
+public:
+
+   // Описание части изначального условия для подсчета по правкам.
+   struct SBasePart
+   {
+      size_t totalArg = 0;              // количество аргументов всех предикатов
+      size_t countNoVariables = 0;      // количество предикатов только с '~'
+      bool bDistinct = true;            // все предикаты части различны по индексу
+      std::vector<size_t> vPredicates;  // индексы предикатов (по возрастанию)
+      std::vector<size_t> vVariables;   // количество аргументов, отличных от '~', по предикатам части
+   };
+
+   using TBase = std::array<SBasePart, 2>;
+
+   // Возвращает описание изначального условия original_.
+   static TBase Describe(const SCondition& original_);
+
+   // Возвращает правки предикатов изначального условия (упорядочены).
+   const std::vector<SEdit>& Edits() const;
+
+   // Возвращает добавленные предикаты части part_.
+   const TPartCondition& Inserted(int part_) const;
+
+   // Возвращает общее количество правок (замены, удаления и добавления).
+   size_t CountEdits() const;
+
+   // Возвращает true, если предикат position_ части part_ изначального условия удален.
+   bool IsDeleted(int part_, size_t position_) const;
+
+   // Возвращает аргумент argument_ предиката position_ части part_ изначального условия original_ с учетом замен.
+   int Argument(const SCondition& original_, int part_, size_t position_, size_t argument_) const;
+
+   // Заменяет аргумент предиката изначального условия original_. Замена на изначальный аргумент удаляет правку.
+   // !> exception если предикат удален или номера невалидны.
+   void SetArgument(const SCondition& original_, int part_, size_t position_, size_t argument_, int value_);
+
+   // Удаляет предикат position_ части part_ изначального условия (вместе с заменами его аргументов).
+   void Delete(int part_, size_t position_);
+
+   // Добавляет предикат в часть part_.
+   void Insert(int part_, const SPredicateTemplate& predTempl_);
+
+   // Заменяет аргумент добавленного предиката index_ части part_.
+   void SetInsertedArgument(int part_, size_t index_, size_t argument_, int value_);
+
+   // Удаляет добавленный предикат index_ части part_.
+   void EraseInserted(int part_, size_t index_);
+
+   // Возвращает условие, полученное правками изначального условия original_.
+   SCondition Materialize(const SCondition& original_) const;
+
+   // Возвращает ключ правок (одинаковые правки - одинаковые ключи).
+   std::vector<int> Key() const;
+
+   // Возвращает правки изначального условия original_, дающие условие condition_ с точностью до порядка предикатов
+   // в частях: предикат condition_ сопоставляется первому еще не сопоставленному такому же предикату изначального
+   // условия (отличия в аргументах - замены), несопоставленные предикаты изначального условия удаляются,
+   // остальные предикаты condition_ добавляются.
+   static CEditScript FromCondition(const SCondition& original_, const SCondition& condition_);
+
+   // Далее index_ - номер предиката в части материализованного условия (оставшиеся изначальные, затем добавленные).
+
+   // Возвращает количество предикатов части part_ материализованного условия.
+   size_t CountPredicates(const SCondition& original_, int part_) const;
+
+   // Возвращает предикат index_ части part_ материализованного условия.
+   SPredicateTemplate Predicate(const SCondition& original_, int part_, size_t index_) const;
+
+   // Заменяет аргумент argument_ предиката index_ части part_ материализованного условия.
+   void SetPredicateArgument(const SCondition& original_, int part_, size_t index_, size_t argument_, int value_);
+
+   // Заменяет предикат index_ части part_ материализованного условия предикатом predTempl_
+   // (предикат изначального условия удаляется и predTempl_ добавляется, тот же предикат - замены аргументов).
+   void ReplacePredicate(const SCondition& original_, int part_, size_t index_, const SPredicateTemplate& predTempl_);
+
+   // Восстанавливает предикат position_ части part_ изначального условия: отменяет его удаление и замены аргументов.
+   void Restore(int part_, size_t position_);
+
+   // Заменяет правки предиката position_ части part_ изначального условия правками этого предиката в source_.
+   void CopyPredicate(const CEditScript& source_, int part_, size_t position_);
+
+   // Возвращает максимальный аргумент материализованного условия (-1 - аргументов-переменных нет).
+   int MaxArgument(const SCondition& original_) const;
+
+   // Перенумеровывает переменные шаблона материализованного условия по порядку появления (от 0 без пропусков).
+   void Normalize(const SCondition& original_);
+
+private:
+
+   // Возвращает номер предиката изначального условия (SIZE_MAX - добавленный) и номер среди добавленных
+   // для предиката index_ части part_ материализованного условия.
+   std::pair<size_t, size_t> locate(const SCondition& original_, int part_, size_t index_) const;
+};
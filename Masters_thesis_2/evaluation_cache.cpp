@@ -0,0 +1,537 @@
+#include <algorithm>
+
+#include <QFile>
+#include <QLockFile>
+#include <QSaveFile>
+
+#include "evaluation_cache.h"
+#include "exception.h"
+
+// Заголовок ошибок файла кэша.
+static const char* TITLE_FILE = "Ошибка файла кэша";
+
+// Время, после которого блокировка файла считается устаревшей (мс).
+static constexpr int STALE_LOCK_TIME = 30000;
+
+// Размер заголовка файла: сигнатура, версия, отпечаток, номер сжатия.
+static constexpr qsizetype HEADER_SIZE = 4 + 4 + 8 + 4;
+
+// Перенумеровывает переменные шаблона части part_ в порядке первого появления (vNumbers_ - новые номера,
+// -1 - переменная еще не встречалась, countNumbers_ - количество занятых номеров) и упорядочивает литералы.
+static void renumberPart(TPartCondition& part_, std::vector<int>& vNumbers_, int& countNumbers_)
+{
+   for (auto& predTempl : part_)
+      for (int& arg : predTempl.arguments)
+      {
+         if (arg == -1)
+            continue;
+
+         if (static_cast<size_t>(arg) >= vNumbers_.size())
+            vNumbers_.resize(static_cast<size_t>(arg) + 1, -1);
+
+         if (vNumbers_[arg] == -1)
+            vNumbers_[arg] = countNumbers_++;
+
+         arg = vNumbers_[arg];
+      }
+
+   std::sort(part_.begin(), part_.end());
+}
+
+// Дописывает в ключ key_ часть условия part_.
+static void appendPart(CEvaluationCache::TKey& key_, const TPartCondition& part_)
+{
+   key_.push_back(static_cast<int>(part_.size()));
+   for (const auto& predTempl : part_)
+   {
+      key_.push_back(static_cast<int>(predTempl.idxPredicate));
+      key_.push_back(static_cast<int>(predTempl.arguments.size()));
+      key_.insert(key_.end(), predTempl.arguments.begin(), predTempl.arguments.end());
+   }
+}
+
+// Дописывает в bytes_ значение value_ (little-endian).
+template <typename T>
+static void appendValue(QByteArray& bytes_, T value_)
+{
+   const quint64 value = static_cast<quint64>(value_);
+   for (size_t iByte = 0; iByte < sizeof(T); ++iByte)
+      bytes_.append(static_cast<char>((value >> (8 * iByte)) & 0xFF));
+}
+
+// Читает значение value_ (little-endian) из [pos_; end_) и сдвигает pos_. Возвращает false, если данных не хватает.
+template <typename T>
+static bool readValue(const char*& pos_, const char* end_, T& value_)
+{
+   if (end_ - pos_ < static_cast<qint64>(sizeof(T)))
+      return false;
+
+   quint64 value = 0;
+   for (size_t iByte = 0; iByte < sizeof(T); ++iByte)
+      value |= static_cast<quint64>(static_cast<quint8>(pos_[iByte])) << (8 * iByte);
+
+   value_ = static_cast<T>(value);
+   pos_ += sizeof(T);
+   return true;
+}
+
+// Контрольное значение записи.
+static quint32 checkValue(const CEvaluationCache::TKey& key_, bool bTrue_)
+{
+   return static_cast<quint32>(CEvaluationCache::SKeyHash()(key_)) ^ static_cast<quint32>(bTrue_);
+}
+
+// Дописывает в bytes_ запись условия.
+static void appendRecord(QByteArray& bytes_, const CEvaluationCache::TKey& key_, bool bTrue_)
+{
+   appendValue<quint32>(bytes_, static_cast<quint32>(key_.size()));
+   for (int value : key_)
+      appendValue<qint32>(bytes_, value);
+
+   appendValue<quint8>(bytes_, bTrue_);
+   appendValue<quint32>(bytes_, checkValue(key_, bTrue_));
+}
+
+// Дописывает в bytes_ заголовок файла.
+static void appendHeader(QByteArray& bytes_, quint64 fingerprint_, quint32 generation_)
+{
+   appendValue<quint32>(bytes_, EVALUATION_CACHE_MAGIC);
+   appendValue<quint32>(bytes_, EVALUATION_CACHE_VERSION);
+   appendValue<quint64>(bytes_, fingerprint_);
+   appendValue<quint32>(bytes_, generation_);
+}
+
+// Возвращает версию файла кэша fileName_ (0 - файла нет или это не файл кэша).
+static quint32 fileVersion(const QString& fileName_)
+{
+   QFile file(fileName_);
+   if (!file.open(QIODevice::ReadOnly))
+      return 0;
+
+   const QByteArray header = file.read(8);
+   const char* pos = header.constData();
+   const char* end = pos + header.size();
+
+   quint32 magic = 0, version = 0;
+   if (!readValue(pos, end, magic) || !readValue(pos, end, version) || magic != EVALUATION_CACHE_MAGIC)
+      return 0;
+
+   return version;
+}
+
+// Захватывает блокировку файла кэша fileName_ (блокировка упавшего процесса считается устаревшей).
+// !> exception если файл занят дольше CEvaluationCache::LOCK_TIMEOUT.
+static void acquireLock(QLockFile& lock_, const QString& fileName_)
+{
+   lock_.setStaleLockTime(STALE_LOCK_TIME);
+   if (!lock_.tryLock(CEvaluationCache::LOCK_TIMEOUT))
+      throw CException(QString("Файл кэша занят другим процессом: %1").arg(fileName_), TITLE_FILE, "CEvaluationCache");
+}
+
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-= Методы класса =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+size_t CEvaluationCache::SKeyHash::operator()(const TKey& key_) const
+{
+   size_t hash = key_.size();
+   for (int value : key_)
+      hash = hash * 31 + static_cast<size_t>(value + 1);
+
+   // Перемешивание, чтобы младшие биты (номер части) зависели от всего ключа.
+   hash ^= hash >> 33;
+   hash *= 0xff51afd7ed558ccdULL;
+   hash ^= hash >> 33;
+   return hash;
+}
+
+CEvaluationCache::TKey CEvaluationCache::Key(const SCondition& condition_)
+{
+   // Истинность не зависит от порядка литералов (левая часть - конъюнкция, правая - дизъюнкция) и от номеров
+   // переменных шаблона, поэтому ключ строится по канонической записи: литералы упорядочены, переменные
+   // перенумерованы в порядке первого появления (после упорядочивания по исходным номерам).
+   TPartCondition left = condition_.left;
+   TPartCondition right = condition_.right;
+   std::sort(left.begin(), left.end());
+   std::sort(right.begin(), right.end());
+
+   std::vector<int> vNumbers(static_cast<size_t>(condition_.maxArgument + 1), -1);
+   int countNumbers = 0;
+   renumberPart(left, vNumbers, countNumbers);
+   renumberPart(right, vNumbers, countNumbers);
+
+   TKey key;
+   key.reserve(3 + condition_.CountPredicates() * 4);
+   key.push_back(condition_.maxArgument + 1);
+   appendPart(key, left);
+   appendPart(key, right);
+   return key;
+}
+
+bool CEvaluationCache::Find(const TKey& key_, bool& bTrue_)
+{
+   SShard& shard = m_aShards[SKeyHash()(key_) % COUNT_SHARDS];
+
+   std::lock_guard<std::mutex> lock(shard.mutex);
+   auto it = shard.map.find(key_);
+   if (it == shard.map.end())
+   {
+      ++m_countMisses;
+      return false;
+   }
+
+   ++m_countHits;
+   bTrue_ = it->second;
+   return true;
+}
+
+bool CEvaluationCache::Contains(const TKey& key_) const
+{
+   const SShard& shard = m_aShards[SKeyHash()(key_) % COUNT_SHARDS];
+
+   std::lock_guard<std::mutex> lock(shard.mutex);
+   return shard.map.find(key_) != shard.map.end();
+}
+
+CEvaluationCache::~CEvaluationCache()
+{
+   try
+   {
+      Close();
+   }
+   catch (const CException&)
+   {
+   }
+}
+
+void CEvaluationCache::Insert(TKey key_, bool bTrue_)
+{
+   if (!m_bFile)
+   {
+      insertMemory(std::move(key_), bTrue_);
+      return;
+   }
+
+   QByteArray record;
+   appendRecord(record, key_, bTrue_);
+   if (!insertMemory(std::move(key_), bTrue_))
+      return;
+
+   {
+      std::lock_guard<std::mutex> lock(m_mutexPending);
+      m_pending.append(record);
+      if (m_pending.size() < FLUSH_SIZE)
+         return;
+   }
+
+   // Файл занят (дописывание, сжатие, другой процесс) - записи дописываются позже.
+   std::unique_lock<std::mutex> lock(m_mutexFile, std::try_to_lock);
+   if (!lock.owns_lock() || m_fileName.isEmpty() || m_bCompacting)
+      return;
+
+   QLockFile lockFile(m_fileName + ".lock");
+   lockFile.setStaleLockTime(STALE_LOCK_TIME);
+   if (!lockFile.tryLock(0))
+      return;
+
+   size_t countRecords = 0;
+   if (readFile(countRecords))
+      appendFile();
+   else
+      startCompaction();
+}
+
+void CEvaluationCache::Open(const QString& fileName_, quint64 fingerprint_)
+{
+   Close();
+
+   std::lock_guard<std::mutex> lock(m_mutexFile);
+
+   m_fileName = fileName_;
+   m_fingerprint = fingerprint_;
+   {
+      std::lock_guard<std::mutex> lockPending(m_mutexPending);
+      m_pending.clear();
+   }
+   m_fileOffset = 0;
+   m_fileGeneration = 0;
+   m_compactionError = nullptr;
+
+   size_t countRecords = 0;
+   bool bComplete = true;
+
+   try
+   {
+      QLockFile lockFile(m_fileName + ".lock");
+      acquireLock(lockFile, m_fileName);
+
+      // Нового файла нет или он записан другой версией (ключи несовместимы) - создается пустой.
+      const quint32 version = fileVersion(m_fileName);
+      if (!QFile::exists(m_fileName) || QFile(m_fileName).size() == 0 || (version != 0 && version != EVALUATION_CACHE_VERSION))
+         rewriteFile();
+
+      bComplete = readFile(countRecords);
+   }
+   catch (const CException&)
+   {
+      m_fileName.clear();
+      throw;
+   }
+
+   m_bFile = true;
+
+   if (!bComplete || countRecords > 2 * Size())
+      startCompaction();
+}
+
+void CEvaluationCache::Flush()
+{
+   std::lock_guard<std::mutex> lock(m_mutexFile);
+   if (m_fileName.isEmpty())
+      return;
+
+   QLockFile lockFile(m_fileName + ".lock");
+   acquireLock(lockFile, m_fileName);
+
+   size_t countRecords = 0;
+   if (readFile(countRecords))
+      appendFile();
+   else
+      rewriteFile();
+}
+
+void CEvaluationCache::Compact()
+{
+   std::lock_guard<std::mutex> lock(m_mutexFile);
+   if (m_fileName.isEmpty())
+      return;
+
+   QLockFile lockFile(m_fileName + ".lock");
+   acquireLock(lockFile, m_fileName);
+
+   size_t countRecords = 0;
+   readFile(countRecords);
+   rewriteFile();
+}
+
+void CEvaluationCache::Close()
+{
+   std::thread compaction;
+   {
+      std::lock_guard<std::mutex> lock(m_mutexFile);
+      std::swap(compaction, m_compaction);
+   }
+
+   if (compaction.joinable())
+      compaction.join();
+
+   std::exception_ptr error;
+   {
+      std::lock_guard<std::mutex> lock(m_mutexFile);
+      std::swap(error, m_compactionError);
+   }
+
+   if (!m_bFile)
+      return;
+
+   // Файл отключается и при ошибке, чтобы деструктор не повторял ее.
+   try
+   {
+      if (error)
+         std::rethrow_exception(error);
+
+      Flush();
+   }
+   catch (const CException&)
+   {
+      std::lock_guard<std::mutex> lock(m_mutexFile);
+      m_bFile = false;
+      m_fileName.clear();
+
+      std::lock_guard<std::mutex> lockPending(m_mutexPending);
+      m_pending.clear();
+      throw;
+   }
+
+   std::lock_guard<std::mutex> lock(m_mutexFile);
+   m_bFile = false;
+   m_fileName.clear();
+}
+
+bool CEvaluationCache::insertMemory(TKey&& key_, bool bTrue_)
+{
+   SShard& shard = m_aShards[SKeyHash()(key_) % COUNT_SHARDS];
+
+   std::lock_guard<std::mutex> lock(shard.mutex);
+   return shard.map.emplace(std::move(key_), bTrue_).second;
+}
+
+bool CEvaluationCache::readFile(size_t& countRecords_)
+{
+   QFile file(m_fileName);
+   if (!file.open(QIODevice::ReadOnly))
+      throw CException(QString("Не удалось открыть файл кэша: %1").arg(m_fileName), TITLE_FILE, "CEvaluationCache::readFile");
+
+   const QByteArray header = file.read(HEADER_SIZE);
+   const char* pos = header.constData();
+   const char* end = pos + header.size();
+
+   quint32 magic = 0, version = 0, generation = 0;
+   quint64 fingerprint = 0;
+   if (!readValue(pos, end, magic) || !readValue(pos, end, version) || !readValue(pos, end, fingerprint) || !readValue(pos, end, generation)
+      || magic != EVALUATION_CACHE_MAGIC || version != EVALUATION_CACHE_VERSION)
+      throw CException(QString("Некорректный файл кэша: %1").arg(m_fileName), TITLE_FILE, "CEvaluationCache::readFile");
+
+   if (fingerprint != m_fingerprint)
+      throw CException(QString("Файл кэша %1 записан для других данных.").arg(m_fileName), TITLE_FILE, "CEvaluationCache::readFile");
+
+   // Файл сжат другим процессом - читается заново (повторы в память не добавляются).
+   if (generation != m_fileGeneration || m_fileOffset < HEADER_SIZE)
+   {
+      m_fileGeneration = generation;
+      m_fileOffset = HEADER_SIZE;
+   }
+
+   file.seek(m_fileOffset);
+   const QByteArray data = file.readAll();
+   pos = data.constData();
+   end = pos + data.size();
+
+   countRecords_ = 0;
+   const char* posRecord = pos;
+   TKey key;
+   while (pos < end)
+   {
+      quint32 size = 0;
+      if (!readValue(pos, end, size) || static_cast<qint64>(size) * 4 > end - pos)
+         break;
+
+      key.resize(size);
+      for (int& value : key)
+         readValue<qint32>(pos, end, value);
+
+      quint8 value = 0;
+      quint32 check = 0;
+      if (!readValue(pos, end, value) || !readValue(pos, end, check) || value > 1 || check != checkValue(key, value))
+         break;
+
+      insertMemory(TKey(key), value);
+      ++countRecords_;
+      posRecord = pos;
+   }
+
+   m_fileOffset += posRecord - data.constData();
+   return posRecord == end;
+}
+
+void CEvaluationCache::appendFile()
+{
+   QByteArray pending;
+   {
+      std::lock_guard<std::mutex> lock(m_mutexPending);
+      pending.swap(m_pending);
+   }
+
+   if (pending.isEmpty())
+      return;
+
+   QFile file(m_fileName);
+   if (!file.open(QIODevice::WriteOnly | QIODevice::Append) || file.write(pending) != pending.size() || !file.flush())
+   {
+      std::lock_guard<std::mutex> lock(m_mutexPending);
+      m_pending.prepend(pending);
+      throw CException(QString("Не удалось дописать файл кэша: %1").arg(m_fileName), TITLE_FILE, "CEvaluationCache::appendFile");
+   }
+
+   m_fileOffset += pending.size();
+}
+
+void CEvaluationCache::rewriteFile()
+{
+   // Несохраненные записи забираются до снимка памяти: их условия уже в памяти и попадут в файл.
+   // Записи, добавленные после, остаются в m_pending (в файле возможен повтор).
+   QByteArray pending;
+   {
+      std::lock_guard<std::mutex> lock(m_mutexPending);
+      pending.swap(m_pending);
+   }
+
+   QByteArray bytes;
+   appendHeader(bytes, m_fingerprint, m_fileGeneration + 1);
+
+   for (auto& shard : m_aShards)
+   {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      for (const auto& [key, bTrue] : shard.map)
+         appendRecord(bytes, key, bTrue);
+   }
+
+   QSaveFile file(m_fileName);
+   if (!file.open(QIODevice::WriteOnly) || file.write(bytes) != bytes.size() || !file.commit())
+   {
+      std::lock_guard<std::mutex> lock(m_mutexPending);
+      m_pending.prepend(pending);
+      throw CException(QString("Не удалось записать файл кэша: %1").arg(m_fileName), TITLE_FILE, "CEvaluationCache::rewriteFile");
+   }
+
+   ++m_fileGeneration;
+   m_fileOffset = bytes.size();
+}
+
+void CEvaluationCache::startCompaction()
+{
+   if (m_bCompacting)
+      return;
+
+   // Предыдущее сжатие завершено (m_bCompacting сбрасывается последним действием потока).
+   if (m_compaction.joinable())
+      m_compaction.join();
+
+   m_bCompacting = true;
+   m_compaction = std::thread([this]()
+      {
+         try
+         {
+            Compact();
+         }
+         catch (const CException&)
+         {
+            std::lock_guard<std::mutex> lock(m_mutexFile);
+            m_compactionError = std::current_exception();
+         }
+
+         m_bCompacting = false;
+      });
+}
+
+size_t CEvaluationCache::Size() const
+{
+   size_t size = 0;
+   for (const auto& shard : m_aShards)
+   {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      size += shard.map.size();
+   }
+
+   return size;
+}
+
+quint64 CEvaluationCache::CountHits() const
+{
+   return m_countHits;
+}
+
+quint64 CEvaluationCache::CountMisses() const
+{
+   return m_countMisses;
+}
+
+void CEvaluationCache::Clear()
+{
+   for (auto& shard : m_aShards)
+   {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      shard.map.clear();
+   }
+
+   m_countHits = 0;
+   m_countMisses = 0;
+}
@@ -0,0 +1,152 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <QByteArray>
+#include <QString>
+#include <QtGlobal>
+
+#include "parser_template_predicates.h"
+
+// Кэш истинности условий (результатов CGeneticAlgorithm::IsTrueCondition).
+// Истинность зависит только от условия и данных, поэтому кэш можно разделять между запусками
+// на одних и тех же данных (портфель запусков). Обращения из нескольких потоков безопасны:
+// кэш разбит на части по хешу условия, у каждой части свой мьютекс.
+//
+// Кэш может храниться в файле (Open) и переживать запуски. Файл относится к одним данным (отпечаток
+// CPredicatesStorage::Fingerprint в заголовке), новые условия дописываются в его конец. Чтение и запись
+// файла выполняются под блокировкой "<файл>.lock" (QLockFile), поэтому файл могут использовать
+// несколько процессов одновременно: при дописывании загружаются и условия, дописанные другими.
+// Формат (little-endian): quint32 сигнатура (EVALUATION_CACHE_MAGIC), quint32 версия, quint64 отпечаток,
+// quint32 номер сжатия; записи: quint32 длина ключа, qint32 x длина, quint8 истинность, quint32 контроль.
+// Недописанная (оборванная) запись в конце файла пропускается, файл при этом сжимается.
+class CEvaluationCache
+{
+public:
+
+   // Ключ - условие, записанное последовательностью чисел (количество переменных шаблона; для каждой части -
+   // размер, затем предикаты и их аргументы).
+   using TKey = std::vector<int>;
+
+   // Хеш ключа (для своих множеств условий).
+   struct SKeyHash
+   {
+      size_t operator()(const TKey& key_) const;
+   };
+
+private:
+
+   // Часть кэша.
+   struct SShard
+   {
+      mutable std::mutex mutex;
+      std::unordered_map<TKey, bool, SKeyHash> map;
+   };
+
+   static constexpr size_t COUNT_SHARDS = 64;
+
+   // Размер несохраненных записей, после которого они дописываются в файл.
+   static constexpr qsizetype FLUSH_SIZE = 64 * 1024;
+
+   std::array<SShard, COUNT_SHARDS> m_aShards;
+   std::atomic<quint64> m_countHits = 0;
+   std::atomic<quint64> m_countMisses = 0;
+
+   // Записи, еще не дописанные в файл. Свой мьютекс: Insert не ждет чтения и записи файла.
+   std::mutex m_mutexPending;
+   QByteArray m_pending;
+
+   // Файл кэша (пусто - кэш только в памяти). Поля ниже защищены m_mutexFile.
+   std::atomic<bool> m_bFile = false;
+   std::mutex m_mutexFile;
+   QString m_fileName;
+   quint64 m_fingerprint = 0;
+   qint64 m_fileOffset = 0;      // прочитанная часть файла
+   quint32 m_fileGeneration = 0; // номер сжатия прочитанного файла
+   std::thread m_compaction;     // фоновое сжатие файла
+   std::atomic<bool> m_bCompacting = false; // идет фоновое сжатие
+   std::exception_ptr m_compactionError; // ошибка фонового сжатия
+
+public:
+
+   CEvaluationCache() = default;
+   CEvaluationCache(const CEvaluationCache&) = delete;
+   CEvaluationCache& operator=(const CEvaluationCache&) = delete;
+
+   // Дописывает условия в файл (ошибки не сообщаются, для них - Close).
+   ~CEvaluationCache();
+
+   // Возвращает ключ условия condition_. Ключ канонический: у условий, отличающихся только порядком литералов
+   // в частях или номерами переменных шаблона, ключи обычно совпадают (кроме повторов одного предиката в части).
+   static TKey Key(const SCondition& condition_);
+
+   // Ищет условие с ключом key_. Если найдено - записывает истинность в bTrue_ и возвращает true.
+   bool Find(const TKey& key_, bool& bTrue_);
+
+   // Есть ли условие с ключом key_ (не учитывается в количестве найденных и не найденных).
+   bool Contains(const TKey& key_) const;
+
+   // Добавляет истинность условия с ключом key_. При подключенном файле новое условие дописывается в файл
+   // пачками. Файл не ожидается: если он занят (дописыванием, сжатием или другим процессом) - запись дописывается
+   // позже, оборванная запись в конце файла исправляется фоновым сжатием.
+   // !> exception при ошибке записи файла.
+   void Insert(TKey key_, bool bTrue_);
+
+   // Подключает файл кэша fileName_ для данных с отпечатком fingerprint_ и загружает записанные условия
+   // (файла нет или он записан другой версией формата - создается). Если записей в файле больше чем вдвое против различных условий, файл сжимается в фоне.
+   // !> exception если файл не открывается, занят дольше LOCK_TIMEOUT или записан для других данных.
+   void Open(const QString& fileName_, quint64 fingerprint_);
+
+   // Дописывает новые условия в файл и загружает условия, дописанные другими процессами.
+   // !> exception при ошибке чтения или записи файла или если файл занят.
+   void Flush();
+
+   // Переписывает файл без повторов (через QSaveFile, под блокировкой).
+   // !> exception при ошибке чтения или записи файла или если файл занят.
+   void Compact();
+
+   // Дожидается фонового сжатия, дописывает новые условия и отключает файл.
+   // !> exception при ошибке сжатия или записи.
+   void Close();
+
+   // Возвращает количество условий в кэше.
+   size_t Size() const;
+
+   // Количество найденных и не найденных в кэше условий.
+   quint64 CountHits() const;
+   quint64 CountMisses() const;
+
+   // Очищает кэш и счетчики (файл не изменяется).
+   void Clear();
+
+   // Время ожидания блокировки файла (мс).
+   static constexpr int LOCK_TIMEOUT = 10000;
+
+private:
+
+   // Добавляет условие в память. Возвращает true, если его не было.
+   bool insertMemory(TKey&& key_, bool bTrue_);
+
+   // Читает файл начиная с m_fileOffset (с начала - если файл сжат другим процессом) и добавляет условия в память.
+   // Вызывается под m_mutexFile и блокировкой файла. Возвращает false, если в конце файла оборванная запись.
+   // countRecords_ - количество прочитанных записей.
+   bool readFile(size_t& countRecords_);
+
+   // Дописывает m_pending в файл. Вызывается под m_mutexFile и блокировкой файла.
+   void appendFile();
+
+   // Переписывает файл из памяти. Вызывается под m_mutexFile и блокировкой файла.
+   void rewriteFile();
+
+   // Запускает фоновое сжатие файла, если оно еще не идет. Вызывается под m_mutexFile.
+   void startCompaction();
+};
+
+// Сигнатура файла кэша ("MT2E").
+constexpr quint32 EVALUATION_CACHE_MAGIC = 0x4532544D;
+constexpr quint32 EVALUATION_CACHE_VERSION = 2;
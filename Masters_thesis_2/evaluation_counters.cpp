@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <atomic>
+
+#include "evaluation_counters.h"
+
+// Последняя часть счетчиков, к которой обращался поток (обычно поток работает с одним алгоритмом).
+struct SShardCache
+{
+   quint64 idCounters = 0;
+   void* shard = nullptr;
+};
+
+static thread_local SShardCache t_shardCache;
+
+// Возвращает новый уникальный номер набора счетчиков (0 не выдается).
+static quint64 nextCountersId()
+{
+   static std::atomic<quint64> lastId = 0;
+   return ++lastId;
+}
+
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-= SEvaluationCounts =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+SEvaluationCounts& SEvaluationCounts::operator+=(const SEvaluationCounts& other_)
+{
+   evaluations += other_.evaluations;
+   falseResults += other_.falseResults;
+   placements += other_.placements;
+   leftFalseExits += other_.leftFalseExits;
+   rightTrueExits += other_.rightTrueExits;
+   anyMapBuilds += other_.anyMapBuilds;
+   anyMapTime += other_.anyMapTime;
+   anyMapLookups += other_.anyMapLookups;
+   tableLookups += other_.tableLookups;
+   return *this;
+}
+
+SEvaluationCounts& SEvaluationCounts::operator-=(const SEvaluationCounts& other_)
+{
+   evaluations -= other_.evaluations;
+   falseResults -= other_.falseResults;
+   placements -= other_.placements;
+   leftFalseExits -= other_.leftFalseExits;
+   rightTrueExits -= other_.rightTrueExits;
+   anyMapBuilds -= other_.anyMapBuilds;
+   anyMapTime -= other_.anyMapTime;
+   anyMapLookups -= other_.anyMapLookups;
+   tableLookups -= other_.tableLookups;
+   return *this;
+}
+
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-= SEvaluationStats =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+SEvaluationCounts SEvaluationStats::Total() const
+{
+   SEvaluationCounts total;
+   for (const auto& counts : bySize)
+      total += counts;
+
+   return total;
+}
+
+SEvaluationStats& SEvaluationStats::operator-=(const SEvaluationStats& other_)
+{
+   bySize.resize(std::max(bySize.size(), other_.bySize.size()));
+   for (size_t i = 0; i < other_.bySize.size(); ++i)
+      bySize[i] -= other_.bySize[i];
+
+   return *this;
+}
+
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-= Методы класса =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+CEvaluationCounters::CEvaluationCounters()
+   : m_id(nextCountersId())
+{
+}
+
+void CEvaluationCounters::Add(size_t countTemplateVariables_, const SEvaluationCounts& counts_)
+{
+   SShard& part = shard();
+
+   std::lock_guard<std::mutex> lock(part.mutex);
+   part.vBySize[std::min(countTemplateVariables_, COUNT_SIZES - 1)] += counts_;
+}
+
+SEvaluationStats CEvaluationCounters::Collect() const
+{
+   SEvaluationStats result;
+   result.bySize.resize(COUNT_SIZES);
+
+   std::lock_guard<std::mutex> lock(m_mutex);
+   for (const auto& part : m_vShards)
+   {
+      std::lock_guard<std::mutex> lockShard(part->mutex);
+      for (size_t i = 0; i < COUNT_SIZES; ++i)
+         result.bySize[i] += part->vBySize[i];
+   }
+
+   return result;
+}
+
+void CEvaluationCounters::Reset()
+{
+   std::lock_guard<std::mutex> lock(m_mutex);
+   for (const auto& part : m_vShards)
+   {
+      std::lock_guard<std::mutex> lockShard(part->mutex);
+      part->vBySize.assign(COUNT_SIZES, SEvaluationCounts());
+   }
+}
+
+CEvaluationCounters::SShard& CEvaluationCounters::shard()
+{
+   if (t_shardCache.idCounters == m_id)
+      return *static_cast<SShard*>(t_shardCache.shard);
+
+   // Части не удаляются до уничтожения счетчиков, поэтому указатель в кэше остается действительным.
+   std::lock_guard<std::mutex> lock(m_mutex);
+
+   const std::thread::id thread = std::this_thread::get_id();
+   auto it = std::find_if(m_vShards.begin(), m_vShards.end(), [thread](const std::unique_ptr<SShard>& part_) { return part_->thread == thread; });
+   if (it == m_vShards.end())
+   {
+      auto part = std::make_unique<SShard>();
+      part->thread = thread;
+      part->vBySize.resize(COUNT_SIZES);
+      it = m_vShards.insert(m_vShards.end(), std::move(part));
+   }
+
+   t_shardCache.idCounters = m_id;
+   t_shardCache.shard = it->get();
+   return **it;
+}
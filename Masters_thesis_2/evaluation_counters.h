@@ -0,0 +1,77 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <QtGlobal>
+
+// Счетчики проверки условий (CGeneticAlgorithm::IsTrueCondition).
+struct SEvaluationCounts
+{
+   quint64 evaluations = 0;    // количество проверок условия
+   quint64 falseResults = 0;   // из них условие оказалось ложным
+   quint64 placements = 0;     // перебрано подстановок переменных шаблона
+   quint64 leftFalseExits = 0; // подстановок, на которых левая часть ложна (правая не проверялась)
+   quint64 rightTrueExits = 0; // подстановок, на которых нашелся истинный предикат правой части
+   quint64 anyMapBuilds = 0;   // построений таблиц для предикатов с '~' (mapPredAnyArg)
+   quint64 anyMapTime = 0;     // время этих построений (нс)
+   quint64 anyMapLookups = 0;  // обращений к этим таблицам
+   quint64 tableLookups = 0;   // обращений к таблицам истинности предикатов
+
+   SEvaluationCounts& operator+=(const SEvaluationCounts& other_);
+   SEvaluationCounts& operator-=(const SEvaluationCounts& other_);
+};
+
+// Счетчики проверки условий с разбивкой по количеству переменных шаблона (maxArgument + 1).
+struct SEvaluationStats
+{
+   // Индекс - количество переменных шаблона, последний элемент - и все большие количества.
+   std::vector<SEvaluationCounts> bySize;
+
+   // Возвращает сумму по всем количествам переменных.
+   SEvaluationCounts Total() const;
+
+   SEvaluationStats& operator-=(const SEvaluationStats& other_);
+};
+
+// Счетчики проверки условий, разделенные по потокам.
+// Каждый поток пишет в свою часть (ее мьютекс захватывается только владельцем и при сборке),
+// сборка суммирует части всех потоков.
+class CEvaluationCounters
+{
+   // Часть счетчиков одного потока.
+   struct SShard
+   {
+      std::thread::id thread;
+      std::mutex mutex;
+      std::vector<SEvaluationCounts> vBySize;
+   };
+
+   const quint64 m_id; // уникальный номер, по нему поток находит свою часть в кэше
+   mutable std::mutex m_mutex;
+   std::vector<std::unique_ptr<SShard>> m_vShards;
+
+public:
+
+   // Количество элементов разбивки (условия с большим количеством переменных попадают в последний).
+   static constexpr size_t COUNT_SIZES = 16;
+
+   CEvaluationCounters();
+   CEvaluationCounters(const CEvaluationCounters&) = delete;
+   CEvaluationCounters& operator=(const CEvaluationCounters&) = delete;
+
+   // Добавляет счетчики counts_ одной проверки условия с countTemplateVariables_ переменными шаблона.
+   void Add(size_t countTemplateVariables_, const SEvaluationCounts& counts_);
+
+   // Возвращает сумму счетчиков всех потоков.
+   SEvaluationStats Collect() const;
+
+   // Обнуляет счетчики всех потоков.
+   void Reset();
+
+private:
+
+   // Возвращает часть счетчиков текущего потока (создает при первом обращении).
+   SShard& shard();
+};
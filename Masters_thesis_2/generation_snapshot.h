@@ -0,0 +1,18 @@
+#pragma once
+#include <utility>
+#include <vector>
+
+#include "parser_template_predicates.h"
+
+// Неизменяемый снимок лучших особей поколения.
+// Публикуется алгоритмом во время работы, читатели (окно просмотра, запись в файл) работают только со снимком
+// и не обращаются к изменяемому поколению.
+struct SGenerationSnapshot
+{
+   size_t generation = 0;       // количество вычисленных поколений (0 - начальное случайное)
+   size_t countIndividuals = 0; // размер поколения
+   bool bFinal = false;         // снимок после окончания запуска (содержит все поколение)
+
+   // Лучшие особи (ограничение целостности и фитнес) в порядке убывания фитнеса.
+   std::vector<std::pair<std::vector<SCondition>, double>> best;
+};
@@ -0,0 +1,148 @@
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+#include <QFile>
+#include <QStringList>
+
+#include "generation_stats.h"
+#include "exception.h"
+
+// Заголовок CSV (порядок полей совпадает с порядком в строке).
+// Счетчики проверки условий в CSV - суммарные, разбивка по количеству переменных шаблона есть только в JSON lines.
+static const char CSV_HEADER[] = "generation,crossingNs,mutationNs,fitnessNs,selectionNs,evaluations,bestFitness,meanFitness,worstFitness,diversity,peakMemory,"
+   "conditionChecks,falseConditions,placements,leftFalseExits,rightTrueExits,anyMapBuilds,anyMapNs,localSearchNs,localSearchConditions,invalidChildren\n";
+
+// Возвращает счетчики проверки условий в виде полей JSON объекта (без скобок).
+static QString jsonEvaluationCounts(const SEvaluationCounts& counts_)
+{
+   return QString("\"conditionChecks\":%1,\"falseConditions\":%2,\"placements\":%3,\"leftFalseExits\":%4,\"rightTrueExits\":%5,"
+      "\"anyMapBuilds\":%6,\"anyMapNs\":%7,\"anyMapLookups\":%8,\"tableLookups\":%9")
+      .arg(counts_.evaluations)
+      .arg(counts_.falseResults)
+      .arg(counts_.placements)
+      .arg(counts_.leftFalseExits)
+      .arg(counts_.rightTrueExits)
+      .arg(counts_.anyMapBuilds)
+      .arg(counts_.anyMapTime)
+      .arg(counts_.anyMapLookups)
+      .arg(counts_.tableLookups);
+}
+
+// Возвращает разбивку счетчиков проверки условий в виде JSON массива (только непустые элементы).
+static QString jsonEvaluationBySize(const SEvaluationStats& stats_)
+{
+   QStringList items;
+   for (size_t i = 0; i < stats_.bySize.size(); ++i)
+      if (stats_.bySize[i].evaluations != 0)
+         items << QString("{\"variables\":%1,%2}").arg(i).arg(jsonEvaluationCounts(stats_.bySize[i]));
+
+   return "[" + items.join(',') + "]";
+}
+
+size_t PeakMemoryUsage()
+{
+#ifdef _WIN32
+   PROCESS_MEMORY_COUNTERS counters;
+   if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+      return counters.PeakWorkingSetSize;
+#else
+   rusage usage;
+   if (getrusage(RUSAGE_SELF, &usage) == 0)
+      return static_cast<size_t>(usage.ru_maxrss) * 1024; // в Linux - в килобайтах
+#endif
+
+   return 0;
+}
+
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-= Методы класса =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+CStatsWriter::CStatsWriter() = default;
+
+CStatsWriter::~CStatsWriter() = default;
+
+void CStatsWriter::Open(const QString& fileName_)
+{
+   Close();
+
+   m_bJson = fileName_.endsWith(".jsonl", Qt::CaseInsensitive);
+   m_file = std::make_unique<QFile>(fileName_);
+
+   if (!m_file->open(QIODevice::WriteOnly | QIODevice::Truncate))
+   {
+      m_file.reset();
+      throw CException("Не удалось открыть файл статистики: " + fileName_, "Ошибка записи статистики", "CStatsWriter::Open");
+   }
+
+   if (!m_bJson)
+   {
+      m_file->write(CSV_HEADER);
+      m_file->flush();
+   }
+}
+
+bool CStatsWriter::IsOpen() const
+{
+   return m_file != nullptr;
+}
+
+void CStatsWriter::Write(const SGenerationStats& stats_)
+{
+   if (!m_file)
+      return;
+
+   const QString format = m_bJson
+      ? "{\"generation\":%1,\"crossingNs\":%2,\"mutationNs\":%3,\"fitnessNs\":%4,\"selectionNs\":%5,\"evaluations\":%6,\"bestFitness\":%7,\"meanFitness\":%8,\"worstFitness\":%9,\"diversity\":%10,\"peakMemory\":%11,"
+      : "%1,%2,%3,%4,%5,%6,%7,%8,%9,%10,%11,";
+
+   QString line = format
+      .arg(stats_.generation)
+      .arg(stats_.crossingTime)
+      .arg(stats_.mutationTime)
+      .arg(stats_.fitnessTime)
+      .arg(stats_.selectionTime)
+      .arg(stats_.countEvaluations)
+      .arg(stats_.bestFitness, 0, 'g', 10)
+      .arg(stats_.meanFitness, 0, 'g', 10)
+      .arg(stats_.worstFitness, 0, 'g', 10)
+      .arg(stats_.diversity, 0, 'g', 6)
+      .arg(stats_.peakMemory);
+
+   const SEvaluationCounts total = stats_.evaluation.Total();
+   if (m_bJson)
+   {
+      line += QString("%1,\"conditionsBySize\":%2,\"localSearchNs\":%3,\"localSearchConditions\":%4,\"invalidChildren\":%5}\n")
+         .arg(jsonEvaluationCounts(total))
+         .arg(jsonEvaluationBySize(stats_.evaluation))
+         .arg(stats_.localSearchTime)
+         .arg(stats_.countLocalSearchConditions)
+         .arg(stats_.countInvalidChildren);
+   }
+   else
+   {
+      line += QString("%1,%2,%3,%4,%5,%6,%7,%8,%9,%10\n")
+         .arg(total.evaluations)
+         .arg(total.falseResults)
+         .arg(total.placements)
+         .arg(total.leftFalseExits)
+         .arg(total.rightTrueExits)
+         .arg(total.anyMapBuilds)
+         .arg(total.anyMapTime)
+         .arg(stats_.localSearchTime)
+         .arg(stats_.countLocalSearchConditions)
+         .arg(stats_.countInvalidChildren);
+   }
+
+   m_file->write(line.toUtf8());
+   m_file->flush();
+}
+
+void CStatsWriter::Close()
+{
+   m_file.reset();
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <memory>
+
+#include <QString>
+
+#include "evaluation_counters.h"
+
+class QFile;
+
+// Статистика одного поколения генетического алгоритма.
+struct SGenerationStats
+{
+   size_t generation = 0;       // номер поколения (с 0)
+   qint64 crossingTime = 0;     // время скрещивания (нс)
+   qint64 mutationTime = 0;     // время мутаций (нс)
+   qint64 fitnessTime = 0;      // время вычисления фитнес функции (нс)
+   qint64 selectionTime = 0;    // время селекции (нс)
+   qint64 localSearchTime = 0;  // время локального поиска (нс)
+   size_t countEvaluations = 0; // количество вычислений фитнес функции
+   size_t countLocalSearchConditions = 0; // количество вычислений фитнеса условий в локальном поиске
+   size_t countInvalidChildren = 0; // количество потомков с некорректным условием (IsCorrectCondition, фитнес -1)
+   double bestFitness = 0;
+   double meanFitness = 0;
+   double worstFitness = 0;
+   double diversity = 0;        // доля различных особей в поколении (0; 1]
+   size_t peakMemory = 0;       // пиковый объем памяти процесса (байт), 0 - неизвестен
+   SEvaluationStats evaluation; // счетчики проверки условий за поколение
+};
+
+// Возвращает пиковый объем памяти процесса (байт), 0 - если неизвестен.
+size_t PeakMemoryUsage();
+
+// Запись статистики поколений в файл по мере работы алгоритма (каждая строка сразу сбрасывается на диск).
+// Формат определяется по расширению: ".jsonl" - JSON lines, иначе CSV с заголовком.
+class CStatsWriter
+{
+   std::unique_ptr<QFile> m_file;
+   bool m_bJson = false;
+
+public:
+
+   CStatsWriter();
+   ~CStatsWriter();
+
+   // Открывает файл fileName_ (перезаписывает существующий).
+   // !> exception если не удалось открыть файл.
+   void Open(const QString& fileName_);
+
+   bool IsOpen() const;
+
+   // Записывает строку статистики (если файл открыт).
+   void Write(const SGenerationStats& stats_);
+
+   void Close();
+};
@@ -1,13 +1,25 @@
 #include <algorithm>
+#include <climits>
+#include <functional>
 #include <memory>
+#include <numeric>
+#include <unordered_set>
 
+#include <QElapsedTimer>
 #include <QFile>
 #include <QTextStream>
 
 #include "genetic_algorithm.h"
+#include "text_reader.h"
+#include "dataset_binary.h"
+#include "result_writer.h"
+#include "result_reader.h"
+#include "batch_evaluator.h"
 #include "exception.h"
 #include "global.h"
 #include "counter.h"
+#include "parallel.h"
+#include "assignment.h"
 
 #define SPLITTER "===================="
 
@@ -37,6 +49,14 @@ Q_EMIT signalEnd();\
 return;\
 }
 
+// Бросается при запросе остановки запуска (ловится в Start).
+struct SStopRequest
+{
+};
+
+// Через сколько подстановок IsTrueCondition проверяет запрос остановки (степень двойки).
+static constexpr size_t STOP_CHECK_PERIOD = 4096;
+
 // =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-= Статические функции =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 
 // Возвращает количество всех аргументов во всем условии.
@@ -74,30 +94,50 @@ static void bringArgumentsBackToNormal(SCondition& condition_)
    condition_.maxArgument = countDiffArg - 1;
 }
 
+// Возвращает true, если все аргументы предиката - '~'.
+static bool hasOnlyAnyArguments(const SPredicateTemplate& predTempl_)
+{
+   return std::all_of(predTempl_.arguments.begin(), predTempl_.arguments.end(), [](int arg_) { return arg_ == -1; });
+}
+
+// Возвращает хеш hash_, дополненный предикатами и аргументами части условия part_.
+static size_t hashPartCondition(size_t hash_, const TPartCondition& part_)
+{
+   for (const auto& predTempl : part_)
+   {
+      hash_ = hash_ * 31 + predTempl.idxPredicate;
+      for (int arg : predTempl.arguments)
+         hash_ = hash_ * 31 + static_cast<size_t>(arg + 1);
+   }
+
+   return hash_ * 31 + part_.size();
+}
+
 // =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-= Методы класса =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 
 CGeneticAlgorithm::CGeneticAlgorithm()
+   : m_storage(std::make_shared<CPredicatesStorage>())
 {
    m_rand.UseNewNumbers();
 }
 
-void CGeneticAlgorithm::SetConditionsFromString(const QString& str_)
+void CGeneticAlgorithm::SetConditions(CTextReader& reader_)
 {
-   qsizetype length = str_.length();
    try
    {
-      CParserTemplatePredicates parser(&m_storage);
-      for (const QString& condition : str_.split(SYMBOL_COMPLETION_CONDEITION))
-         if (!condition.isEmpty())
-            m_original.push_back(parser.Parse(condition));
+      CParserTemplatePredicates parser(m_storage.get());
+      while (!reader_.SkipSpace())
+         m_original.push_back(parser.Parse(reader_));
 
       if (m_original.empty())
          throw CException("Нет ограничения целостности!");
+
+      indexOriginal();
    }
    catch (CException& error)
    {
       error.title("Ошибка добавления условия целостности");
-      error.location("CGeneticAlgorithm::SetConditionFromString");
+      error.location("CGeneticAlgorithm::SetConditions");
       throw error;
    }
 }
@@ -105,21 +145,32 @@ void CGeneticAlgorithm::SetConditionsFromString(const QString& str_)
 void CGeneticAlgorithm::FillDataInFile(const QString& fileName_)
 {
    QFile file(fileName_);
-   if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
-      ERROR(QString("Не удалось открыть файл :").arg(fileName_), "Ошибка загрузки данных", "CGeneticAlgorithm::FillDataInFile")
+   if (!file.open(QIODevice::ReadOnly))
+      ERROR("Не удалось открыть файл: " + fileName_, "Ошибка загрузки данных", "CGeneticAlgorithm::FillDataInFile")
 
    Clear();
 
-   QTextStream in(&file);
-   QString str = in.readAll();
-
-   qsizetype i = 0;
-
    try
    {
-      m_storage.SetVariables(highlightBlock(str, i));
-      m_storage.AddPredicates(highlightBlock(str, ++i));
-      SetConditionsFromString(highlightBlock(str, ++i));
+      if (IsBinaryDataset(&file))
+      {
+         const QString conditions = ReadBinaryDataset(&file, *m_storage);
+         CTextReader reader(conditions);
+         SetConditions(reader);
+      }
+      else
+      {
+         file.setTextModeEnabled(true);
+
+         // Файл читается блоками, таблицы истинности заполняются по мере чтения.
+         CTextReader reader(&file);
+
+         m_storage->SetVariables(reader);
+         reader.NextSection();
+         m_storage->AddPredicates(reader);
+         reader.NextSection();
+         SetConditions(reader);
+      }
    }
    catch (CException& error)
    {
@@ -133,12 +184,12 @@ void CGeneticAlgorithm::FillDataInFile(const QString& fileName_)
 
 QString CGeneticAlgorithm::StringVariables() const
 {
-   return m_storage.StringVariables();
+   return m_storage->StringVariables();
 }
 
 QString CGeneticAlgorithm::StringPredicates() const
 {
-   return m_storage.StringPredicatesWithTable();
+   return m_storage->StringPredicatesWithTable();
 }
 
 QString CGeneticAlgorithm::StringIntegrityLimitation(bool bTrueCondition_) const
@@ -148,21 +199,23 @@ QString CGeneticAlgorithm::StringIntegrityLimitation(bool bTrueCondition_) const
 
 QString CGeneticAlgorithm::StringGeneration(bool bFitness_, size_t count_) const
 {
-   count_ = qMin(count_, m_generation.size());
-
    QString str;
 
-   TGeneration generation = m_generation;
-   SortGenerationDescendingOrder(generation);
+   // Поколение меняется во время запуска, поэтому выводится последний опубликованный снимок (уже отсортирован).
+   const std::shared_ptr<const SGenerationSnapshot> snapshot = Snapshot();
+   if (!snapshot)
+      return str;
+
+   const TGeneration& generation = snapshot->best;
+   count_ = qMin(count_, generation.size());
 
    if (bFitness_)
    {
       for (size_t iGen = 0; iGen < count_; ++iGen)
       {
          const TIntLimAndFitness& conds = generation.at(iGen);
-         double valFitness = conds.second == -999. ? FitnessFunction(conds.first) : conds.second;
 
-         str += QString("#%1 = %2%3").arg(iGen + 1).arg(valFitness).arg(NEW_LINE);
+         str += QString("#%1 = %2%3").arg(iGen + 1).arg(conds.second).arg(NEW_LINE);
          str += StringIntegrityLimitation(conds.first, true);
       }
    }
@@ -249,19 +302,26 @@ QString CGeneticAlgorithm::StringCustom(bool bVariables_, bool bPredicates_, boo
 
 void CGeneticAlgorithm::WriteInFile(const QString& fileName_, bool bVariables_, bool bPredicates_, bool bIntegrityLimitation_, bool bGeneration_, bool bFitness_, bool bTrueCondition_, size_t countIndividuals_) const
 {
-   QFile file(fileName_);
-
-   if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
-      ERROR("Не удалось открыть файл: " + fileName_, "Ошибка выгрузки данных", "CGeneticAlgorithm::WriteInFile")
+   quint8 sections = 0;
+   if (bVariables_)
+      sections |= eResultVariables;
+   if (bPredicates_)
+      sections |= eResultPredicates;
+   if (bIntegrityLimitation_)
+      sections |= eResultIntegrityLimitation;
+   if (bGeneration_)
+      sections |= eResultGeneration;
+   if (bFitness_)
+      sections |= eResultFitness;
+   if (bTrueCondition_)
+      sections |= eResultTrueCondition;
 
    try
    {
-      file.write(StringCustom(bVariables_, bPredicates_, bIntegrityLimitation_, bGeneration_, bFitness_, bTrueCondition_, countIndividuals_).toLocal8Bit());
+      CResultWriter(*this).Write(fileName_, sections, countIndividuals_);
    }
-   catch (CException& error)
+   catch (const CException& error)
    {
-      QString title(error.title());
-      title.append(". Ошибка выгрузки данных");
       Q_EMIT signalError(error);
    }
 }
@@ -293,43 +353,226 @@ void CGeneticAlgorithm::Start(int countIndividuals_, int countIterations_, doubl
    const double percentagePerIteration = 100. / countIterations_; // количество процентов за одну итерацию
    int percentageCompleted = 0;
 
+   m_bStopRequested = false;
+   m_bInterrupted = false;
+   m_deadline = m_timeBudget > 0 ? QDeadlineTimer(m_timeBudget) : QDeadlineTimer(QDeadlineTimer::Forever);
+   m_runThread = std::this_thread::get_id();
+   m_vPortfolioRuns.clear();
+   m_idxBestPortfolioRun = SIZE_MAX;
+   m_vExactRepairs.clear();
+   m_countFitnessEvaluations = 0;
+   m_scriptGeneration.clear();
+   size_t countDone = 0; // количество вычисленных поколений
+
+   // Геном из правок: результат запуска - материализованное поколение.
+   auto materializeGeneration = [this]()
+      {
+         if (m_scriptGeneration.empty())
+            return;
+
+         m_generation.clear();
+         m_generation.reserve(m_scriptGeneration.size());
+         for (const auto& individual : m_scriptGeneration)
+            m_generation.push_back(materializeIndividual(individual));
+
+         m_scriptGeneration.clear();
+      };
+
    try
    {
+      CStatsWriter statsWriter;
+      if (!m_statsFile.isEmpty())
+         statsWriter.Open(m_statsFile);
+
+      m_evaluationCounters.Reset();
+      SEvaluationStats evaluationBefore; // счетчики на начало поколения
+
+      m_trace.reset();
+      if (!m_traceFile.isEmpty())
+      {
+         m_trace = std::make_unique<CTrace>();
+         m_trace->Open(m_traceFile);
+      }
+
       // Создание первого поколения
-      CreateFirstGenerationRandom(countIndividuals_);
+      {
+         CTraceScope traceFirst(m_trace.get(), "CreateFirstGeneration");
+         CreateFirstGeneration(countIndividuals_);
+      }
+
+      m_countFitnessEvaluations += m_generation.size();
+
+      if (m_bScriptGenome)
+      {
+         m_scriptGeneration = scriptGeneration(m_generation);
+         m_generation.clear();
+      }
+
+      publishSnapshot(0, false);
+      QElapsedTimer timerSnapshot;
+      timerSnapshot.start();
+
+      QElapsedTimer timer;
 
       for (size_t iGeneration = 0; iGeneration < countIterations_; ++iGeneration)
       {
+         if (isStopRequested())
+            throw SStopRequest();
+
+         CTraceScope traceGeneration(m_trace.get(), "generation");
+         traceGeneration.Arg("generation", iGeneration);
+
+         SGenerationStats stats;
+         stats.generation = iGeneration;
+         timer.start();
+
+         // С геномом из правок потомки - scriptChildren, в children они материализуются только для фитнеса.
          TGeneration children(countIndividuals_ * 2);
-         for (size_t iNewIndiv = 0; iNewIndiv < children.size(); ++iNewIndiv)
+         TScriptGeneration scriptChildren(m_bScriptGenome ? children.size() : 0);
          {
-            // Селекция (выбор родителей) (турнирный отбор)
-            size_t idxParent1, idxParent2;
-            std::tie(idxParent1, idxParent2) = GetPairParents(countIndividuals_);
-
-            // Скрещивание (нет смысла считать фитнес, все еще может поменяться).
-            children[iNewIndiv] = std::make_pair(CrossingOnlyPredicates(m_generation[idxParent1].first, m_generation[idxParent2].first), -999.);
+            CTraceScope tracePhase(m_trace.get(), "crossing");
+            for (size_t iNewIndiv = 0; iNewIndiv < children.size(); ++iNewIndiv)
+            {
+               CTraceScope trace(m_trace.get(), m_bScriptGenome ? "CrossingScripts" : "CrossingOnlyPredicates");
+               trace.Arg("individual", iNewIndiv);
+
+               // Селекция (выбор родителей) (турнирный отбор)
+               size_t idxParent1, idxParent2;
+               std::tie(idxParent1, idxParent2) = GetPairParents(countIndividuals_);
+
+               // Скрещивание (нет смысла считать фитнес, все еще может поменяться).
+               if (m_bScriptGenome)
+                  scriptChildren[iNewIndiv] = std::make_pair(CrossingScripts(m_scriptGeneration[idxParent1].first, m_scriptGeneration[idxParent2].first), -999.);
+               else
+                  children[iNewIndiv] = std::make_pair(CrossingOnlyPredicates(m_generation[idxParent1].first, m_generation[idxParent2].first), -999.);
+            }
          }
 
+         stats.crossingTime = timer.nsecsElapsed();
+         timer.start();
+
          // Мутации
-         size_t countMutation = children.size() * percentIndividualsUndergoingMutation_ * 0.01;
+         {
+            CTraceScope tracePhase(m_trace.get(), "mutation");
+            size_t countMutation = children.size() * percentIndividualsUndergoingMutation_ * 0.01;
+
+            // Мутация аргументов
+            if (percentMutationArguments_ > 0 && iGeneration < countIterations_ - countSkipMutationArg_)
+               for (size_t iMutation = 0; iMutation < countMutation; ++iMutation)
+               {
+                  const size_t idxIndividual = m_rand.Generate(0, children.size() - 1);
+                  CTraceScope trace(m_trace.get(), "MutationArguments");
+                  trace.Arg("individual", idxIndividual);
+                  if (m_bScriptGenome)
+                     MutationScriptArguments(scriptChildren.at(idxIndividual).first, percentMutationArguments_ * 0.01);
+                  else
+                     MutationArguments(children.at(idxIndividual).first, percentMutationArguments_ * 0.01);
+               }
 
-         // Мутация аргументов
-         if (percentMutationArguments_ > 0 && iGeneration < countIterations_ - countSkipMutationArg_)
-            for (size_t iMutation = 0; iMutation < countMutation; ++iMutation)
-               MutationArguments(children.at(m_rand.Generate(0, children.size() - 1)).first, percentMutationArguments_ * 0.01);
+            // Мутация предикатов
+            if (percentMutationPredicates_ > 0 && iGeneration < countIterations_ - countSkipMutationPred_)
+               for (size_t iMutation = 0; iMutation < countMutation; ++iMutation)
+               {
+                  const size_t idxIndividual = m_rand.Generate(0, children.size() - 1);
+                  CTraceScope trace(m_trace.get(), "MutationPredicates");
+                  trace.Arg("individual", idxIndividual);
+                  if (m_bScriptGenome)
+                     MutationScriptPredicates(scriptChildren.at(idxIndividual).first, percentMutationPredicates_ * 0.01);
+                  else
+                     MutationPredicates(children.at(idxIndividual).first, percentMutationPredicates_ * 0.01);
+               }
+         }
 
-         // Мутация предикатов
-         if (percentMutationPredicates_ > 0 && iGeneration < countIterations_ - countSkipMutationPred_)
-            for (size_t iMutation = 0; iMutation < countMutation; ++iMutation)
-               MutationPredicates(children.at(m_rand.Generate(0, children.size() - 1)).first, percentMutationPredicates_ * 0.01);
+         stats.mutationTime = timer.nsecsElapsed();
+         timer.start();
 
          // Теперь надо посчитать фитнес.
-         for (auto& individual : children)
-            individual.second = FitnessFunction(individual.first);
+         {
+            CTraceScope tracePhase(m_trace.get(), "fitness");
+            for (size_t iIndividual = 0; iIndividual < scriptChildren.size(); ++iIndividual)
+               children[iIndividual] = materializeIndividual(scriptChildren[iIndividual]);
+
+            {
+               CTraceScope trace(m_trace.get(), "evaluateBatches");
+               evaluateBatches(children);
+            }
+
+            for (size_t iIndividual = 0; iIndividual < children.size(); ++iIndividual)
+            {
+               CTraceScope trace(m_trace.get(), "FitnessFunction");
+               trace.Arg("individual", iIndividual);
+               if (m_bScriptGenome)
+                  children[iIndividual].second = scriptChildren[iIndividual].second = scriptFitnessFunction(scriptChildren[iIndividual].first, children[iIndividual].first);
+               else
+                  children[iIndividual].second = FitnessFunction(children[iIndividual].first);
+
+               const auto& conds = children[iIndividual].first;
+               if (std::any_of(conds.begin(), conds.end(), [this](const SCondition& cond_) { return !IsCorrectCondition(cond_); }))
+                  ++stats.countInvalidChildren;
+            }
+
+            m_mapBatchResults.clear();
+         }
+
+         stats.fitnessTime = timer.nsecsElapsed();
+         stats.countEvaluations = children.size();
+         m_countFitnessEvaluations += children.size();
+
+         // Материализованные потомки нужны только для фитнеса.
+         if (m_bScriptGenome)
+            TGeneration().swap(children);
+         timer.start();
 
          // Селекция (полная замена, родителей "убиваем")
-         Selection(std::move(children), countIndividuals_);
+         {
+            CTraceScope tracePhase(m_trace.get(), "selection");
+            if (m_bScriptGenome)
+               Selection(std::move(scriptChildren), countIndividuals_);
+            else
+               Selection(std::move(children), countIndividuals_);
+         }
+
+         stats.selectionTime = timer.nsecsElapsed();
+
+         // Локальный поиск лучших особей
+         if (m_localSearchCount > 0)
+         {
+            timer.start();
+            CTraceScope tracePhase(m_trace.get(), "localSearch");
+            if (m_bScriptGenome)
+            {
+               const size_t countSearch = std::min(m_localSearchCount, m_scriptGeneration.size());
+               for (size_t iIndividual = 0; iIndividual < countSearch; ++iIndividual)
+                  stats.countLocalSearchConditions += localSearchScript(m_scriptGeneration[iIndividual]);
+
+               SortGenerationDescendingOrder(m_scriptGeneration);
+            }
+            else
+            {
+               const size_t countSearch = std::min(m_localSearchCount, m_generation.size());
+               for (size_t iIndividual = 0; iIndividual < countSearch; ++iIndividual)
+                  stats.countLocalSearchConditions += localSearch(m_generation[iIndividual]);
+
+               SortGenerationDescendingOrder(m_generation);
+            }
+            stats.localSearchTime = timer.nsecsElapsed();
+         }
+
+         fillGenerationStats(stats);
+         stats.peakMemory = PeakMemoryUsage();
+         const SEvaluationStats evaluationTotal = m_evaluationCounters.Collect();
+         stats.evaluation = evaluationTotal;
+         stats.evaluation -= evaluationBefore;
+         evaluationBefore = evaluationTotal;
+         statsWriter.Write(stats);
+         Q_EMIT signalGenerationStats(stats);
+
+         ++countDone;
+         if (timerSnapshot.elapsed() >= m_snapshotInterval)
+         {
+            publishSnapshot(countDone, false);
+            timerSnapshot.start();
+         }
 
          // Отправляем сигнал о проценте выполнения.
          if (percentagePerIteration * iGeneration > percentageCompleted)
@@ -338,189 +581,926 @@ void CGeneticAlgorithm::Start(int countIndividuals_, int countIterations_, doubl
             Q_EMIT signalProgressUpdate(percentageCompleted);
          }
       }
-
-      // Сортируем в порядке убывания
-      SortGenerationDescendingOrder(m_generation);
+   }
+   catch (const SStopRequest&)
+   {
+      // Недосчитанное поколение отбрасывается, m_generation - последнее полностью вычисленное.
+      m_bInterrupted = true;
    }
    catch (const CException& error)
+   {
+      m_runThread = std::thread::id();
+      m_trace.reset();
+      m_mapBatchResults.clear();
+      materializeGeneration();
       EXEPTSIGNAL(error)
+   }
+
+   m_runThread = std::thread::id();
+   m_trace.reset();
+   m_mapBatchResults.clear();
+   materializeGeneration();
+
+   // Сортируем в порядке убывания
+   SortGenerationDescendingOrder(m_generation);
+   publishSnapshot(countDone, true);
+
+   if (!m_bInterrupted)
+      Q_EMIT signalProgressUpdate(100);
 
-   Q_EMIT signalProgressUpdate(100);
    Q_EMIT signalEnd();
 }
 
-void CGeneticAlgorithm::Clear()
+void CGeneticAlgorithm::StartPortfolio(const std::vector<SRunSettings>& vSettings_, int countThreads_)
 {
-   m_storage.Clear();
-   m_original.clear();
+   if (vSettings_.empty())
+      ERRORSIGNAL("Нет ни одного запуска в портфеле.", "Ошибка запуска", "CGeneticAlgorithm::StartPortfolio")
+
+   if (!m_evaluationCache)
+      m_evaluationCache = std::make_shared<CEvaluationCache>();
+
+   m_bStopRequested = false;
+   m_bInterrupted = false;
+   m_deadline = m_timeBudget > 0 ? QDeadlineTimer(m_timeBudget) : QDeadlineTimer(QDeadlineTimer::Forever);
+   m_runThread = std::this_thread::get_id();
+   m_evaluationCounters.Reset();
+   m_countFitnessEvaluations = 0;
+   m_snapshot.store(nullptr);
    m_generation.clear();
-}
+   m_vPortfolioRuns.assign(vSettings_.size(), SPortfolioRun());
+   m_idxBestPortfolioRun = SIZE_MAX;
+   m_vExactRepairs.clear();
 
-bool CGeneticAlgorithm::HasGenerations() const
-{
-   return !m_generation.empty();
-}
+   // Прогресс портфеля - средний прогресс запусков.
+   std::vector<std::atomic<int>> vProgress(vSettings_.size());
+   std::atomic<int> progressSent = 0;
 
-void CGeneticAlgorithm::SetLimitOfArgumentsChange(double value_)
-{
-   if (value_ <= 0 || value_ >= 1)
-      ERROR("Невозможно установить цену нижней границы для измененных аргументов выходящую за интервал (0; 1).",
-         "Некорректное значение", "CGeneticAlgorithm::SetRangeOfArgumentsChange")
+   std::vector<std::unique_ptr<CGeneticAlgorithm>> vRuns;
+   for (size_t iRun = 0; iRun < vSettings_.size(); ++iRun)
+   {
+      auto run = std::make_unique<CGeneticAlgorithm>();
+      run->m_storage = m_storage;
+      run->m_original = m_original;
+      run->m_vOriginalIndex = m_vOriginalIndex;
+      run->m_vOriginalBase = m_vOriginalBase;
+      run->m_bScriptGenome = m_bScriptGenome;
+      run->m_snapshotCount = m_snapshotCount;
+      run->m_snapshotInterval = m_snapshotInterval;
+      run->m_localSearchCount = static_cast<size_t>(qMax(vSettings_[iRun].countLocalSearch, 0));
+      run->m_localSearchNeighbors = m_localSearchNeighbors;
+      run->m_initialization = m_initialization;
+      run->m_evaluationCache = m_evaluationCache;
+      run->m_parent = this;
+      run->SetSeed(vSettings_[iRun].seed);
+
+      SPortfolioRun& result = m_vPortfolioRuns[iRun];
+      result.settings = vSettings_[iRun];
+
+      const CGeneticAlgorithm* pRun = run.get();
+      connect(pRun, &CGeneticAlgorithm::signalError, [&result](const CException& error_)
+         {
+            if (result.error.isEmpty())
+               result.error = QString(error_.title()) + ". " + error_.what();
+         });
 
-   m_minCostForArgDif = value_;
-}
+      connect(pRun, &CGeneticAlgorithm::signalProgressUpdate, [this, iRun, &vProgress, &progressSent](int value_)
+         {
+            vProgress[iRun] = value_;
 
-void CGeneticAlgorithm::SetCostAddingPredicate(double cost_)
-{
-   if (cost_ < 0 || cost_ > 1)
-      ERROR("Невозможно установить стоимость добавления предиката выходящую за диапазон [0; 1].",
-         "Некорректное значение", "CGeneticAlgorithm::SetCostAddingPredicate")
+            int sum = 0;
+            for (const auto& progress : vProgress)
+               sum += progress;
 
-   m_costAddingPredicate = cost_;
-}
+            const int mean = sum / static_cast<int>(vProgress.size());
+            int sent = progressSent;
+            while (mean > sent)
+               if (progressSent.compare_exchange_weak(sent, mean))
+               {
+                  Q_EMIT signalProgressUpdate(mean);
+                  break;
+               }
+         });
 
-bool CGeneticAlgorithm::isIllegalSymbol(QChar symbol_)
-{
-   const QChar illegalSymbols[] = { ',', '-','>', '$', '(', ')', '~', SYMBOL_COMPLETION_CONDEITION};
+      connect(pRun, &CGeneticAlgorithm::signalSnapshotUpdated, [this, pRun]()
+         {
+            updatePortfolioSnapshot(pRun->Snapshot());
+         });
 
-   for (const auto& illegal : illegalSymbols)
-      if (symbol_ == illegal)
-         return true;
+      // Некорректные цены - ошибка только этого запуска.
+      run->SetLimitOfArgumentsChange(result.settings.limitOfArgumentsChange);
+      run->SetCostAddingPredicate(result.settings.costAddingPredicate);
 
-   return false;
-}
+      vRuns.push_back(std::move(run));
+   }
 
-QString CGeneticAlgorithm::StringCondition(const SCondition& condition_) const
-{
-   CParserTemplatePredicates parser(&m_storage);
-   QString str;
+   ParallelFor(vRuns.size(), [&](size_t iRun)
+      {
+         CGeneticAlgorithm& run = *vRuns[iRun];
+         SPortfolioRun& result = m_vPortfolioRuns[iRun];
 
-   for (const auto& predTempl : condition_.left)
-      str += parser.GetStringTemplatePredicate(predTempl) + ' ';
+         if (!result.error.isEmpty())
+            return;
 
-   str.append("->");
+         // Запуски, до которых очередь дошла после остановки портфеля, не выполняются.
+         if (m_bStopRequested || m_deadline.hasExpired())
+         {
+            result.bInterrupted = true;
+            return;
+         }
 
-   for (const auto& predTempl : condition_.right)
-      str += ' ' + parser.GetStringTemplatePredicate(predTempl);
+         QElapsedTimer timer;
+         timer.start();
+
+         const SRunSettings& settings = result.settings;
+         run.Start(settings.countIndividuals,
+            settings.countIterations,
+            settings.percentMutationArguments,
+            settings.countSkipMutationArg,
+            settings.percentMutationPredicates,
+            settings.countSkipMutationPred,
+            settings.percentIndividualsUndergoingMutation);
+
+         result.runTime = timer.elapsed();
+         result.bInterrupted = run.WasInterrupted();
+         result.bHasGeneration = run.HasGenerations();
+         result.bestFitness = run.BestFitness();
+         result.countFitnessEvaluations = run.CountFitnessEvaluations();
+      }, countThreads_);
+
+   m_runThread = std::thread::id();
+
+   QString error;
+   for (size_t iRun = 0; iRun < vRuns.size(); ++iRun)
+   {
+      const SPortfolioRun& result = m_vPortfolioRuns[iRun];
 
-   return str.append(';');
-}
+      const SEvaluationStats stats = vRuns[iRun]->EvaluationStats();
+      for (size_t iSize = 0; iSize < stats.bySize.size(); ++iSize)
+         m_evaluationCounters.Add(iSize, stats.bySize[iSize]);
 
-QString CGeneticAlgorithm::StringIntegrityLimitation(const TIntegrityLimitation& integrityLimitation_, bool bInsertNewLine_, bool bTrueCondition_) const
-{
-   QString str;
-   for (const auto& condition : integrityLimitation_)
-   {
-      str += StringCondition(condition);
-      if (bTrueCondition_)
+      m_countFitnessEvaluations += result.countFitnessEvaluations;
+      m_bInterrupted = m_bInterrupted || result.bInterrupted;
+
+      if (!result.error.isEmpty())
       {
-         QString bTrueCondition = IsTrueCondition(condition) ? "true" : "false";
-         str += " (" + bTrueCondition + ')';
+         if (error.isEmpty())
+            error = result.error;
+
+         continue;
       }
-      str += NEW_LINE;
-   }
 
-   if (!bInsertNewLine_)
-      str.chop(COUNT_SYMB_NEW_LINE);
-   else
-      str.append(NEW_LINE);
+      if (!result.bHasGeneration)
+         continue;
 
-   return str;
-}
+      if (m_idxBestPortfolioRun == SIZE_MAX || result.bestFitness > m_vPortfolioRuns[m_idxBestPortfolioRun].bestFitness)
+         m_idxBestPortfolioRun = iRun;
+   }
 
-void CGeneticAlgorithm::CreateFirstGenerationRandom(size_t count_)
-{
-   if (count_ < 2)
-      throw CException("Количество особей должно быть больше 1.", "Ошибка генерации первого поколения", "CGeneticAlgorithm::CreateFirstGenerationRandom");
+   if (m_idxBestPortfolioRun == SIZE_MAX)
+   {
+      m_snapshot.store(nullptr);
+      ERRORSIGNAL(error.isEmpty() ? "Ни один запуск портфеля не выполнен." : error, "Ошибка запуска портфеля", "CGeneticAlgorithm::StartPortfolio")
+   }
 
-   if (m_storage.CountVariables() < 1)
-      throw CException("Количество переменных должно быть не меньше 1.", "Ошибка генерации первого поколения", "CGeneticAlgorithm::CreateFirstGenerationRandom");
+   // Поколение запуска уже отсортировано.
+   CGeneticAlgorithm& best = *vRuns[m_idxBestPortfolioRun];
+   m_generation = std::move(best.m_generation);
+   publishSnapshot(best.Snapshot() ? best.Snapshot()->generation : 0, true);
 
-   if (m_storage.IsEmpty())
-      throw CException("Количество предикатов должно быть не меньше 1.", "Ошибка генерации первого поколения", "CGeneticAlgorithm::CreateFirstGenerationRandom");
+   if (!m_bInterrupted)
+      Q_EMIT signalProgressUpdate(100);
 
-   const size_t sizeOrigin = m_original.size(); // количество условий в изначальном ограничении целостности
-   const size_t idxLastPredicate = m_storage.CountPredicates() - 1; // индекс последнего предиката
+   Q_EMIT signalEnd();
+}
 
+void CGeneticAlgorithm::StartExact(int maxEdits_, size_t maxCandidates_, int countThreads_)
+{
+   if (maxEdits_ < 0)
+      ERRORSIGNAL("Количество правок не может быть отрицательным!", "Ошибка запуска", "CGeneticAlgorithm::StartExact")
+
+   if (m_original.empty())
+      ERRORSIGNAL("Нет изначального ограничения целостности.", "Ошибка запуска", "CGeneticAlgorithm::StartExact")
+
+   m_bStopRequested = false;
+   m_bInterrupted = false;
+   m_deadline = m_timeBudget > 0 ? QDeadlineTimer(m_timeBudget) : QDeadlineTimer(QDeadlineTimer::Forever);
+   m_runThread = std::this_thread::get_id();
+   m_evaluationCounters.Reset();
+   m_countFitnessEvaluations = 0;
+   m_snapshot.store(nullptr);
    m_generation.clear();
+   m_vPortfolioRuns.clear();
+   m_idxBestPortfolioRun = SIZE_MAX;
+   m_vExactRepairs.assign(m_original.size(), SExactRepair());
 
-   for (size_t iGen = 0; iGen < count_; ++iGen)
+   TIntegrityLimitation best(m_original.size());
+   std::atomic<size_t> countDone = 0;
+
+   try
    {
-      TIntegrityLimitation conds(sizeOrigin);
+      ParallelFor(m_original.size(), [&](size_t iCond)
+         {
+            m_vExactRepairs[iCond] = exactRepair(iCond, maxEdits_, maxCandidates_, best[iCond]);
 
-      for (size_t iCond = 0; iCond < sizeOrigin; ++iCond)
-      {
-         // Не целесообразно делать условие сильно больше или меньше чем изначальное.
-         // Будем брать в пределах двух. Не больше чем в 2 раза и не меньше чем в 2 раза.
-         size_t sizeCond = m_rand.Generate(m_original.at(iCond).CountPredicates() / 2, m_original.at(iCond).CountPredicates() * 2);
-         SCondition cond;
+            const size_t done = ++countDone;
+            if (done < m_original.size())
+               Q_EMIT signalProgressUpdate(static_cast<int>(done * 100 / m_original.size()));
+         }, countThreads_);
+   }
+   catch (const CException& error)
+   {
+      m_runThread = std::thread::id();
+      EXEPTSIGNAL(error)
+   }
 
-         for (size_t iPred = 0; iPred < sizeCond; ++iPred)
-         {
-            SPredicateTemplate predTempl;
-            predTempl.idxPredicate = m_rand.Generate(0, idxLastPredicate);
-            predTempl.arguments.resize(m_storage.CountArguments(predTempl.idxPredicate));
+   m_runThread = std::thread::id();
+   m_bInterrupted = std::any_of(m_vExactRepairs.begin(), m_vExactRepairs.end(), [](const SExactRepair& repair_) { return !repair_.bComplete; })
+      && (m_bStopRequested || m_deadline.hasExpired());
 
-            if (m_rand.Generate(0, 1))
-               cond.left.push_back(std::move(predTempl));
-            else
-               cond.right.push_back(std::move(predTempl));
-         }
+   // Условия, до проверки которых дело не дошло, получают фитнес изначального условия.
+   for (size_t iCond = 0; iCond < m_vExactRepairs.size(); ++iCond)
+      if (m_vExactRepairs[iCond].countChecked == 0)
+         m_vExactRepairs[iCond].fitness = conditionFitness(iCond, best[iCond]);
 
-         cond.ForEachPredicate([this, &cond](SPredicateTemplate& predTempl)
-            {
-               for (int& argument : predTempl.arguments)
-               {
-                  argument = m_rand.Generate(0, cond.maxArgument + 2) - 1;
-                  if (argument == cond.maxArgument + 1)
-                     ++cond.maxArgument;
-               }
-            });
+   m_generation.push_back(std::make_pair(best, FitnessFunction(best)));
+   m_countFitnessEvaluations = 1;
+   publishSnapshot(0, true);
 
-         conds[iCond] = cond;
-      }
+   if (!m_bInterrupted)
+      Q_EMIT signalProgressUpdate(100);
 
-      m_generation.push_back(std::make_pair(conds, FitnessFunction(conds)));
-   }
+   Q_EMIT signalEnd();
 }
 
-CGeneticAlgorithm::TIntegrityLimitation CGeneticAlgorithm::CrossingOnlyPredicates(const TIntegrityLimitation& parent1_, const TIntegrityLimitation& parent2_) const
+void CGeneticAlgorithm::StartBeam(int beamWidth_, int maxDepth_, int countThreads_)
 {
-   if (parent1_.size() != parent2_.size())
-      throw CException("Разное количество условий целостности у родителей!", "Ошибка скрещивания", "CGeneticAlgorithm::CrossingOnlyPredicates");
-
-   TIntegrityLimitation child;
+   if (beamWidth_ < 1)
+      ERRORSIGNAL("Ширина луча должна быть не меньше 1.", "Ошибка запуска", "CGeneticAlgorithm::StartBeam")
+
+   if (maxDepth_ < 0)
+      ERRORSIGNAL("Не может быть отрицательной глубины поиска!", "Ошибка запуска", "CGeneticAlgorithm::StartBeam")
+
+   if (m_original.empty())
+      ERRORSIGNAL("Нет изначального ограничения целостности.", "Ошибка запуска", "CGeneticAlgorithm::StartBeam")
+
+   m_bStopRequested = false;
+   m_bInterrupted = false;
+   m_deadline = m_timeBudget > 0 ? QDeadlineTimer(m_timeBudget) : QDeadlineTimer(QDeadlineTimer::Forever);
+   m_runThread = std::this_thread::get_id();
+   m_vPortfolioRuns.clear();
+   m_idxBestPortfolioRun = SIZE_MAX;
+   m_vExactRepairs.clear();
+   m_countFitnessEvaluations = 0;
+   m_generation.clear();
+   size_t countDone = 0; // количество выполненных шагов
 
-   for (size_t iCond = 0; iCond < parent1_.size(); ++iCond)
+   // Особь луча: фитнесы условий (m_generation хранит сами особи) и признак раскрытия.
+   struct SBeamMember
    {
-      const SCondition& cond1 = parent1_.at(iCond);
-      const SCondition& cond2 = parent2_.at(iCond);
+      std::vector<double> vFitness;
+      bool bExpanded = false;
+   };
 
-      SCondition newCond;
+   // Кандидат - особь луча idxMember с условием iCond, замененным на condition.
+   struct SCandidate
+   {
+      size_t idxMember = 0;
+      size_t iCond = 0;
+      SCondition condition;
+      double fitnessCond = 0;
+      double fitness = 0;
+   };
+
+   // Ключ особи - условия как есть (части, предикаты и их аргументы) через разделитель. Ключ кэша не подходит:
+   // он не различает номера переменных шаблона, а от них зависит фитнес.
+   auto individualKey = [](const TIntegrityLimitation& conds_, size_t iCond_, const SCondition& cond_)
+   {
+      CEvaluationCache::TKey key;
+      auto appendPart = [&key](const TPartCondition& part_)
+         {
+            key.push_back(static_cast<int>(part_.size()));
+            for (const auto& predTempl : part_)
+            {
+               key.push_back(static_cast<int>(predTempl.idxPredicate));
+               key.insert(key.end(), predTempl.arguments.begin(), predTempl.arguments.end());
+            }
+         };
 
-      // левая часть
-      size_t minPred = qMin(cond1.left.size(), cond2.left.size());
-      for (size_t iPred = 0; iPred < minPred; ++iPred)
-      { 
-         if (m_rand.Generate(0, 1))
-            newCond.left.push_back(cond2.left.at(iPred));
-         else
-            newCond.left.push_back(cond1.left.at(iPred));
+      for (size_t iCond = 0; iCond < conds_.size(); ++iCond)
+      {
+         const SCondition& cond = iCond == iCond_ ? cond_ : conds_[iCond];
+         appendPart(cond.left);
+         appendPart(cond.right);
+         key.push_back(INT_MIN);
       }
 
-      const SCondition& condL = cond1.left.size() == minPred ? cond2 : cond1;
+      return key;
+   };
 
-      for (size_t iPred = minPred; iPred < condL.left.size(); ++iPred)
+   try
+   {
+      CStatsWriter statsWriter;
+      if (!m_statsFile.isEmpty())
+         statsWriter.Open(m_statsFile);
+
+      m_evaluationCounters.Reset();
+      SEvaluationStats evaluationBefore; // счетчики на начало шага
+
+      m_trace.reset();
+      if (!m_traceFile.isEmpty())
       {
-         if (m_rand.Generate(0, 1))
-            newCond.left.push_back(condL.left.at(iPred));
+         m_trace = std::make_unique<CTrace>();
+         m_trace->Open(m_traceFile);
       }
 
-      // правая часть
-      minPred = qMin(cond1.right.size(), cond2.right.size());
-      for (size_t iPred = 0; iPred < minPred; ++iPred)
-      {
-         if (m_rand.Generate(0, 1))
+      std::vector<SBeamMember> vBeam(1);
+      vBeam[0].vFitness.resize(m_original.size());
+      for (size_t iCond = 0; iCond < m_original.size(); ++iCond)
+         vBeam[0].vFitness[iCond] = conditionFitness(iCond, m_original[iCond]);
+
+      m_generation.push_back(std::make_pair(m_original, sumFitness(vBeam[0].vFitness)));
+      m_countFitnessEvaluations = 1;
+
+      // Все особи, когда-либо попавшие в кандидаты (повторно не оцениваются).
+      std::unordered_set<CEvaluationCache::TKey, CEvaluationCache::SKeyHash> seen;
+      seen.insert(individualKey(m_original, SIZE_MAX, SCondition()));
+
+      publishSnapshot(0, false);
+      QElapsedTimer timerSnapshot;
+      timerSnapshot.start();
+
+      QElapsedTimer timer;
+      std::vector<SCondition> vEdited;
+
+      for (int depth = 0; depth < maxDepth_; ++depth)
+      {
+         if (isStopRequested())
+            throw SStopRequest();
+
+         CTraceScope traceGeneration(m_trace.get(), "beamStep");
+         traceGeneration.Arg("depth", depth);
+
+         SGenerationStats stats;
+         stats.generation = depth;
+         timer.start();
+
+         // Раскрытие: все особи на одну правку от нераскрытых особей луча.
+         std::vector<SCandidate> vCandidates;
+         {
+            CTraceScope tracePhase(m_trace.get(), "expansion");
+            for (size_t idxMember = 0; idxMember < vBeam.size(); ++idxMember)
+            {
+               if (vBeam[idxMember].bExpanded)
+                  continue;
+
+               vBeam[idxMember].bExpanded = true;
+               const TIntegrityLimitation& conds = m_generation[idxMember].first;
+               for (size_t iCond = 0; iCond < conds.size(); ++iCond)
+               {
+                  vEdited.clear();
+                  editConditions(conds[iCond], nullptr, vEdited);
+
+                  for (auto& edited : vEdited)
+                     if (seen.insert(individualKey(conds, iCond, edited)).second)
+                        vCandidates.push_back({ idxMember, iCond, std::move(edited) });
+               }
+            }
+         }
+
+         stats.crossingTime = timer.nsecsElapsed();
+         timer.start();
+
+         // Оценка: пересчитывается только измененное условие.
+         {
+            CTraceScope tracePhase(m_trace.get(), "fitness");
+            ParallelFor(vCandidates.size(), [&](size_t idxCandidate)
+               {
+                  if (m_bStopRequested.load(std::memory_order_relaxed) || m_deadline.hasExpired())
+                     throw SStopRequest();
+
+                  SCandidate& candidate = vCandidates[idxCandidate];
+                  candidate.fitnessCond = conditionFitness(candidate.iCond, candidate.condition);
+
+                  std::vector<double> vFitness = vBeam[candidate.idxMember].vFitness;
+                  vFitness[candidate.iCond] = candidate.fitnessCond;
+                  candidate.fitness = sumFitness(vFitness);
+               }, countThreads_);
+         }
+
+         stats.fitnessTime = timer.nsecsElapsed();
+         stats.countEvaluations = vCandidates.size();
+         m_countFitnessEvaluations += vCandidates.size();
+         timer.start();
+
+         // Отбор: beamWidth_ лучших из луча и кандидатов, при равном фитнесе - в порядке получения
+         // (сначала прежний луч).
+         bool bChanged = false;
+         {
+            CTraceScope tracePhase(m_trace.get(), "selection");
+
+            std::vector<size_t> vOrder(m_generation.size() + vCandidates.size());
+            std::iota(vOrder.begin(), vOrder.end(), 0);
+            auto fitnessOf = [&](size_t idx_)
+            {
+               return idx_ < m_generation.size() ? m_generation[idx_].second : vCandidates[idx_ - m_generation.size()].fitness;
+            };
+
+            std::stable_sort(vOrder.begin(), vOrder.end(), [&fitnessOf](size_t a_, size_t b_)
+               {
+                  return fitnessOf(a_) > fitnessOf(b_);
+               });
+
+            vOrder.resize(std::min(vOrder.size(), static_cast<size_t>(beamWidth_)));
+
+            TGeneration nextGeneration;
+            std::vector<SBeamMember> vNextBeam;
+            nextGeneration.reserve(vOrder.size());
+            vNextBeam.reserve(vOrder.size());
+
+            for (size_t idx : vOrder)
+            {
+               if (idx < m_generation.size())
+               {
+                  nextGeneration.push_back(m_generation[idx]);
+                  vNextBeam.push_back(vBeam[idx]);
+                  continue;
+               }
+
+               SCandidate& candidate = vCandidates[idx - m_generation.size()];
+               TIntLimAndFitness individual = m_generation[candidate.idxMember];
+               individual.first[candidate.iCond] = std::move(candidate.condition);
+               individual.second = candidate.fitness;
+
+               SBeamMember member;
+               member.vFitness = vBeam[candidate.idxMember].vFitness;
+               member.vFitness[candidate.iCond] = candidate.fitnessCond;
+
+               nextGeneration.push_back(std::move(individual));
+               vNextBeam.push_back(std::move(member));
+               bChanged = true;
+            }
+
+            m_generation = std::move(nextGeneration);
+            vBeam = std::move(vNextBeam);
+         }
+
+         stats.selectionTime = timer.nsecsElapsed();
+
+         fillGenerationStats(stats);
+         stats.peakMemory = PeakMemoryUsage();
+         const SEvaluationStats evaluationTotal = m_evaluationCounters.Collect();
+         stats.evaluation = evaluationTotal;
+         stats.evaluation -= evaluationBefore;
+         evaluationBefore = evaluationTotal;
+         statsWriter.Write(stats);
+         Q_EMIT signalGenerationStats(stats);
+
+         ++countDone;
+         if (timerSnapshot.elapsed() >= m_snapshotInterval)
+         {
+            publishSnapshot(countDone, false);
+            timerSnapshot.start();
+         }
+
+         if (!bChanged)
+            break;
+
+         Q_EMIT signalProgressUpdate(static_cast<int>((depth + 1) * 100 / maxDepth_));
+      }
+   }
+   catch (const SStopRequest&)
+   {
+      // Недосчитанный шаг отбрасывается, m_generation - последний полностью вычисленный луч.
+      m_bInterrupted = true;
+   }
+   catch (const CException& error)
+   {
+      m_runThread = std::thread::id();
+      m_trace.reset();
+      EXEPTSIGNAL(error)
+   }
+
+   m_runThread = std::thread::id();
+   m_trace.reset();
+
+   SortGenerationDescendingOrder(m_generation);
+   publishSnapshot(countDone, true);
+
+   if (!m_bInterrupted)
+      Q_EMIT signalProgressUpdate(100);
+
+   Q_EMIT signalEnd();
+}
+
+void CGeneticAlgorithm::Clear()
+{
+   // Новое хранилище, а не очистка: прежнее может использоваться запусками портфеля.
+   m_storage = std::make_shared<CPredicatesStorage>();
+   m_original.clear();
+   m_vOriginalIndex.clear();
+   m_vOriginalBase.clear();
+   m_generation.clear();
+   m_snapshot.store(nullptr);
+   m_evaluationCache.reset();
+   m_vPortfolioRuns.clear();
+   m_idxBestPortfolioRun = SIZE_MAX;
+   m_vExactRepairs.clear();
+}
+
+bool CGeneticAlgorithm::HasGenerations() const
+{
+   return !m_generation.empty();
+}
+
+double CGeneticAlgorithm::BestFitness() const
+{
+   if (m_generation.empty())
+      return 0;
+
+   return std::max_element(m_generation.begin(), m_generation.end(),
+      [](const TIntLimAndFitness& a, const TIntLimAndFitness& b)
+      {
+         return a.second < b.second;
+      })->second;
+}
+
+void CGeneticAlgorithm::SetSeed(quint32 seed_)
+{
+   m_rand.SetSeed(seed_);
+}
+
+quint32 CGeneticAlgorithm::GetSeed() const
+{
+   return m_rand.GetSeed();
+}
+
+void CGeneticAlgorithm::SetStatsFile(const QString& fileName_)
+{
+   m_statsFile = fileName_;
+}
+
+void CGeneticAlgorithm::SetTraceFile(const QString& fileName_)
+{
+   m_traceFile = fileName_;
+}
+
+SEvaluationStats CGeneticAlgorithm::EvaluationStats() const
+{
+   return m_evaluationCounters.Collect();
+}
+
+quint64 CGeneticAlgorithm::CountFitnessEvaluations() const
+{
+   return m_countFitnessEvaluations;
+}
+
+void CGeneticAlgorithm::SetTimeBudget(qint64 msec_)
+{
+   m_timeBudget = qMax<qint64>(msec_, 0);
+}
+
+void CGeneticAlgorithm::RequestStop()
+{
+   m_bStopRequested = true;
+}
+
+bool CGeneticAlgorithm::WasInterrupted() const
+{
+   return m_bInterrupted;
+}
+
+bool CGeneticAlgorithm::IsRunning() const
+{
+   return m_runThread.load() != std::thread::id();
+}
+
+void CGeneticAlgorithm::SetSnapshotSettings(size_t countBest_, qint64 interval_)
+{
+   m_snapshotCount = countBest_;
+   m_snapshotInterval = qMax<qint64>(interval_, 0);
+}
+
+void CGeneticAlgorithm::SetLocalSearch(size_t countBest_, size_t countNeighbors_)
+{
+   m_localSearchCount = countBest_;
+   m_localSearchNeighbors = countNeighbors_;
+}
+
+void CGeneticAlgorithm::SetInitialization(const SInitialization& initialization_)
+{
+   if (initialization_.percentSeeded < 0 || initialization_.percentSeeded > 100)
+      ERROR("Процент копий изначального ограничения должен быть в отрезке [0; 100].", "Некорректное значение", "CGeneticAlgorithm::SetInitialization")
+
+   if (initialization_.minEdits < 0 || initialization_.maxEdits < initialization_.minEdits)
+      ERROR("Количество правок копий изначального ограничения должно быть неотрицательным, наименьшее - не больше наибольшего.",
+         "Некорректное значение", "CGeneticAlgorithm::SetInitialization")
+
+   m_initialization = initialization_;
+}
+
+void CGeneticAlgorithm::SetScriptGenome(bool bScriptGenome_)
+{
+   m_bScriptGenome = bScriptGenome_;
+}
+
+std::shared_ptr<const SGenerationSnapshot> CGeneticAlgorithm::Snapshot() const
+{
+   return m_snapshot.load();
+}
+
+const std::vector<SPortfolioRun>& CGeneticAlgorithm::PortfolioRuns() const
+{
+   return m_vPortfolioRuns;
+}
+
+size_t CGeneticAlgorithm::BestPortfolioRun() const
+{
+   return m_idxBestPortfolioRun;
+}
+
+const std::vector<SExactRepair>& CGeneticAlgorithm::ExactRepairs() const
+{
+   return m_vExactRepairs;
+}
+
+void CGeneticAlgorithm::SetEvaluationCache(std::shared_ptr<CEvaluationCache> cache_)
+{
+   m_evaluationCache = std::move(cache_);
+}
+
+std::shared_ptr<CEvaluationCache> CGeneticAlgorithm::EvaluationCache() const
+{
+   return m_evaluationCache;
+}
+
+const CPredicatesStorage& CGeneticAlgorithm::GetStorage() const
+{
+   return *m_storage;
+}
+
+const CGeneticAlgorithm::TIntegrityLimitation& CGeneticAlgorithm::GetOriginal() const
+{
+   return m_original;
+}
+
+void CGeneticAlgorithm::SetLimitOfArgumentsChange(double value_)
+{
+   if (value_ <= 0 || value_ >= 1)
+      ERROR("Невозможно установить цену нижней границы для измененных аргументов выходящую за интервал (0; 1).",
+         "Некорректное значение", "CGeneticAlgorithm::SetRangeOfArgumentsChange")
+
+   m_minCostForArgDif = value_;
+}
+
+void CGeneticAlgorithm::SetCostAddingPredicate(double cost_)
+{
+   if (cost_ < 0 || cost_ > 1)
+      ERROR("Невозможно установить стоимость добавления предиката выходящую за диапазон [0; 1].",
+         "Некорректное значение", "CGeneticAlgorithm::SetCostAddingPredicate")
+
+   m_costAddingPredicate = cost_;
+}
+
+bool CGeneticAlgorithm::isIllegalSymbol(QChar symbol_)
+{
+   const QChar illegalSymbols[] = { ',', '-','>', '$', '(', ')', '~', SYMBOL_COMPLETION_CONDEITION};
+
+   for (const auto& illegal : illegalSymbols)
+      if (symbol_ == illegal)
+         return true;
+
+   return false;
+}
+
+QString CGeneticAlgorithm::StringCondition(const SCondition& condition_) const
+{
+   CParserTemplatePredicates parser(m_storage.get());
+   QString str;
+
+   for (const auto& predTempl : condition_.left)
+      str += parser.GetStringTemplatePredicate(predTempl) + ' ';
+
+   str.append("->");
+
+   for (const auto& predTempl : condition_.right)
+      str += ' ' + parser.GetStringTemplatePredicate(predTempl);
+
+   return str.append(';');
+}
+
+QString CGeneticAlgorithm::StringIntegrityLimitation(const TIntegrityLimitation& integrityLimitation_, bool bInsertNewLine_, bool bTrueCondition_) const
+{
+   QString str;
+   for (const auto& condition : integrityLimitation_)
+   {
+      str += StringCondition(condition);
+      if (bTrueCondition_)
+      {
+         QString bTrueCondition = IsTrueCondition(condition) ? "true" : "false";
+         str += " (" + bTrueCondition + ')';
+      }
+      str += NEW_LINE;
+   }
+
+   if (!bInsertNewLine_)
+      str.chop(COUNT_SYMB_NEW_LINE);
+   else
+      str.append(NEW_LINE);
+
+   return str;
+}
+
+void CGeneticAlgorithm::CreateFirstGeneration(size_t count_)
+{
+   if (count_ < 2)
+      throw CException("Количество особей должно быть больше 1.", "Ошибка генерации первого поколения", "CGeneticAlgorithm::CreateFirstGeneration");
+
+   if (m_storage->CountVariables() < 1)
+      throw CException("Количество переменных должно быть не меньше 1.", "Ошибка генерации первого поколения", "CGeneticAlgorithm::CreateFirstGeneration");
+
+   if (m_storage->IsEmpty())
+      throw CException("Количество предикатов должно быть не меньше 1.", "Ошибка генерации первого поколения", "CGeneticAlgorithm::CreateFirstGeneration");
+
+   m_generation.clear();
+
+   // Поколение собирается отдельно и становится m_generation только после подсчета фитнеса,
+   // чтобы при остановке во время подсчета не остались особи без фитнеса.
+   TGeneration generation;
+
+   // Особи предыдущего запуска (исправляются, как и новые: файл мог быть записан с другими настройками или изменен)
+   if (!m_initialization.importFile.isEmpty())
+   {
+      for (auto& individual : CResultReader(*m_storage).Read(m_initialization.importFile, m_original.size(), count_))
+      {
+         for (size_t iCond = 0; iCond < individual.size(); ++iCond)
+            repairCondition(individual[iCond], iCond);
+
+         generation.push_back(std::make_pair(std::move(individual), 0.));
+      }
+   }
+
+   // Копии изначального ограничения с правками
+   const size_t countSeeded = static_cast<size_t>((count_ - generation.size()) * m_initialization.percentSeeded * 0.01 + 0.5);
+   for (size_t iGen = 0; iGen < countSeeded; ++iGen)
+      generation.push_back(std::make_pair(seededIndividual(), 0.));
+
+   CreateFirstGenerationRandom(count_ - generation.size(), generation);
+
+   // Фитнес считается для всего поколения сразу, чтобы условия проверялись блоками.
+   evaluateBatches(generation);
+   for (auto& [individual, fitness] : generation)
+      fitness = FitnessFunction(individual);
+
+   m_mapBatchResults.clear();
+   m_generation = std::move(generation);
+}
+
+void CGeneticAlgorithm::CreateFirstGenerationRandom(size_t count_, TGeneration& generation_)
+{
+   const size_t sizeOrigin = m_original.size(); // количество условий в изначальном ограничении целостности
+   const size_t idxLastPredicate = m_storage->CountPredicates() - 1; // индекс последнего предиката
+
+   for (size_t iGen = 0; iGen < count_; ++iGen)
+   {
+      TIntegrityLimitation conds(sizeOrigin);
+
+      for (size_t iCond = 0; iCond < sizeOrigin; ++iCond)
+      {
+         // Не целесообразно делать условие сильно больше или меньше чем изначальное.
+         // Будем брать в пределах двух. Не больше чем в 2 раза и не меньше чем в 2 раза.
+         size_t sizeCond = m_rand.Generate(m_original.at(iCond).CountPredicates() / 2, m_original.at(iCond).CountPredicates() * 2);
+         SCondition cond;
+
+         for (size_t iPred = 0; iPred < sizeCond; ++iPred)
+         {
+            SPredicateTemplate predTempl;
+            predTempl.idxPredicate = m_rand.Generate(0, idxLastPredicate);
+            predTempl.arguments.resize(m_storage->CountArguments(predTempl.idxPredicate));
+
+            if (m_rand.Generate(0, 1))
+               cond.left.push_back(std::move(predTempl));
+            else
+               cond.right.push_back(std::move(predTempl));
+         }
+
+         cond.ForEachPredicate([this, &cond](SPredicateTemplate& predTempl)
+            {
+               for (int& argument : predTempl.arguments)
+               {
+                  argument = m_rand.Generate(0, cond.maxArgument + 2) - 1;
+                  if (argument == cond.maxArgument + 1)
+                     ++cond.maxArgument;
+               }
+            });
+
+         repairCondition(cond, iCond);
+         conds[iCond] = cond;
+      }
+
+      generation_.push_back(std::make_pair(conds, 0.));
+   }
+}
+
+CGeneticAlgorithm::TIntegrityLimitation CGeneticAlgorithm::seededIndividual() const
+{
+   TIntegrityLimitation conds(m_original);
+
+   for (size_t iCond = 0; iCond < conds.size(); ++iCond)
+   {
+      const int countEdits = m_rand.Generate(m_initialization.minEdits, m_initialization.maxEdits);
+      for (int iEdit = 0; iEdit < countEdits; ++iEdit)
+         randomEdit(conds[iCond]);
+
+      repairCondition(conds[iCond], iCond);
+   }
+
+   return conds;
+}
+
+void CGeneticAlgorithm::randomEdit(SCondition& cond_) const
+{
+   switch (m_rand.Generate(0, 2))
+   {
+   case 0: // замена аргумента
+   {
+      size_t idxPredicate = m_rand.Generate(0, cond_.CountPredicates() - 1);
+      SPredicateTemplate& predTempl = idxPredicate < cond_.left.size() ? cond_.left[idxPredicate] : cond_.right[idxPredicate - cond_.left.size()];
+      if (predTempl.arguments.empty())
+         break;
+
+      int& argument = predTempl.arguments[m_rand.Generate(0, predTempl.arguments.size() - 1)];
+      argument = m_rand.Generate(0, cond_.maxArgument + 2) - 1;
+      cond_.RecalculateMaximum();
+      break;
+   }
+   case 1: // удаление предиката
+   {
+      TPartCondition& part = m_rand.Generate(0, 1) ? cond_.right : cond_.left;
+      if (part.size() < 2)
+         break;
+
+      part.erase(part.begin() + m_rand.Generate(0, part.size() - 1));
+      cond_.RecalculateMaximum();
+      break;
+   }
+   default: // добавление предиката
+   {
+      SPredicateTemplate predTempl;
+      predTempl.idxPredicate = m_rand.Generate(0, m_storage->CountPredicates() - 1);
+      predTempl.arguments.resize(m_storage->CountArguments(predTempl.idxPredicate));
+      for (int& argument : predTempl.arguments)
+      {
+         argument = m_rand.Generate(0, cond_.maxArgument + 2) - 1;
+         if (argument == cond_.maxArgument + 1)
+            ++cond_.maxArgument;
+      }
+
+      (m_rand.Generate(0, 1) ? cond_.right : cond_.left).push_back(std::move(predTempl));
+   }
+   }
+}
+
+CGeneticAlgorithm::TIntegrityLimitation CGeneticAlgorithm::CrossingOnlyPredicates(const TIntegrityLimitation& parent1_, const TIntegrityLimitation& parent2_) const
+{
+   if (parent1_.size() != parent2_.size())
+      throw CException("Разное количество условий целостности у родителей!", "Ошибка скрещивания", "CGeneticAlgorithm::CrossingOnlyPredicates");
+
+   TIntegrityLimitation child;
+
+   for (size_t iCond = 0; iCond < parent1_.size(); ++iCond)
+   {
+      const SCondition& cond1 = parent1_.at(iCond);
+      const SCondition& cond2 = parent2_.at(iCond);
+
+      SCondition newCond;
+
+      // левая часть
+      size_t minPred = qMin(cond1.left.size(), cond2.left.size());
+      for (size_t iPred = 0; iPred < minPred; ++iPred)
+      { 
+         if (m_rand.Generate(0, 1))
+            newCond.left.push_back(cond2.left.at(iPred));
+         else
+            newCond.left.push_back(cond1.left.at(iPred));
+      }
+
+      const SCondition& condL = cond1.left.size() == minPred ? cond2 : cond1;
+
+      for (size_t iPred = minPred; iPred < condL.left.size(); ++iPred)
+      {
+         if (m_rand.Generate(0, 1))
+            newCond.left.push_back(condL.left.at(iPred));
+      }
+
+      // Часть пуста только если у одного из родителей она пуста, тогда берется предикат другого.
+      if (newCond.left.empty() && !condL.left.empty())
+         newCond.left.push_back(condL.left.at(m_rand.Generate(0, condL.left.size() - 1)));
+
+      // правая часть
+      minPred = qMin(cond1.right.size(), cond2.right.size());
+      for (size_t iPred = 0; iPred < minPred; ++iPred)
+      {
+         if (m_rand.Generate(0, 1))
             newCond.right.push_back(cond2.right.at(iPred));
          else
             newCond.right.push_back(cond1.right.at(iPred));
@@ -534,7 +1514,11 @@ CGeneticAlgorithm::TIntegrityLimitation CGeneticAlgorithm::CrossingOnlyPredicate
             newCond.right.push_back(condR.right.at(iPred));
       }
 
+      if (newCond.right.empty() && !condR.right.empty())
+         newCond.right.push_back(condR.right.at(m_rand.Generate(0, condR.right.size() - 1)));
+
       newCond.RecalculateMaximum();
+      repairCondition(newCond, iCond);
       child.push_back(newCond);
    }
 
@@ -551,6 +1535,16 @@ void CGeneticAlgorithm::Selection(TGeneration&& individuals_, size_t countSurviv
    m_generation = std::move(individuals_);   
 }
 
+void CGeneticAlgorithm::Selection(TScriptGeneration&& individuals_, size_t countSurvivors_)
+{
+   if (individuals_.size() < countSurvivors_)
+      throw CException("Количество выживших не должно быть меньше самих особей", "Ошибка селекции", "CGeneticAlgorithm::Selection");
+
+   SortGenerationDescendingOrder(individuals_);
+   individuals_.resize(countSurvivors_);
+   m_scriptGeneration = std::move(individuals_);
+}
+
 void CGeneticAlgorithm::MutationArguments(TIntegrityLimitation& individual_, double ratio_) const
 {
    if (ratio_ <= 0.)
@@ -561,7 +1555,7 @@ void CGeneticAlgorithm::MutationArguments(TIntegrityLimitation& individual_, dou
       countAllArg += countAllArgumentsInCondition(cond);
 
    const size_t iLastCondition = individual_.size() - 1;
-   const size_t countVariables = m_storage.CountVariables();
+   const size_t countVariables = m_storage->CountVariables();
 
    const size_t countMutations = qMax(static_cast<size_t>(ratio_ * countAllArg), static_cast<size_t>(1));
    for (size_t i = 0; i < countMutations; ++i)
@@ -573,7 +1567,13 @@ void CGeneticAlgorithm::MutationArguments(TIntegrityLimitation& individual_, dou
 
       auto& predTempl = partCond.at(m_rand.Generate(0, partCond.size() - 1)); // выбор конкретного предиката в условии целостности
       size_t iArg = m_rand.Generate(0, predTempl.arguments.size() - 1); // выбор позиции (индекса) аргумента у выбранного предиката
-      size_t newValueArg = m_rand.Generate(0, fullCond.maxArgument + 2) - 1; // новое значение выбранного аргумента
+
+      // Если остальные аргументы - '~', новый аргумент - только переменная (предикат не остается только с '~').
+      bool bOthersAny = true;
+      for (size_t iOther = 0; iOther < predTempl.arguments.size() && bOthersAny; ++iOther)
+         bOthersAny = iOther == iArg || predTempl.arguments[iOther] == -1;
+
+      size_t newValueArg = m_rand.Generate(bOthersAny ? 1 : 0, fullCond.maxArgument + 2) - 1; // новое значение выбранного аргумента
       if (newValueArg == fullCond.maxArgument + 1)
          ++fullCond.maxArgument;
 
@@ -589,7 +1589,7 @@ void CGeneticAlgorithm::MutationPredicates(TIntegrityLimitation& individual_, do
    size_t countPredicats = CountAllPredicates(individual_);
 
    const size_t iLastCondition = individual_.size() - 1;
-   const size_t iLastPredicate = m_storage.CountPredicates() - 1;
+   const size_t iLastPredicate = m_storage->CountPredicates() - 1;
 
    const size_t countMutations = qMax(static_cast<size_t>(ratio_ * countPredicats), static_cast<size_t>(1));
    for (size_t i = 0; i < countMutations; ++i)
@@ -601,18 +1601,244 @@ void CGeneticAlgorithm::MutationPredicates(TIntegrityLimitation& individual_, do
 
       auto& predTempl = partCond.at(m_rand.Generate(0, partCond.size() - 1)); // выбор конкретного предиката в условии целостности (места)
 
-      predTempl.idxPredicate = m_rand.Generate(0, iLastPredicate); // новый индекс для этого предиката = новый предикат на том же месте
-      const size_t countArg = m_storage.CountArguments(predTempl.idxPredicate);
-      predTempl.arguments.resize(countArg);
-      for (size_t iArg = 0; iArg < countArg; ++iArg)
+      predTempl.idxPredicate = m_rand.Generate(0, iLastPredicate); // новый индекс для этого предиката = новый предикат на том же месте
+      const size_t countArg = m_storage->CountArguments(predTempl.idxPredicate);
+      predTempl.arguments.resize(countArg);
+      for (size_t iArg = 0; iArg < countArg; ++iArg)
+      {
+         predTempl.arguments[iArg] = m_rand.Generate(0, fullCond.maxArgument + 2) - 1;
+         if (predTempl.arguments.at(iArg) == fullCond.maxArgument + 1)
+            ++fullCond.maxArgument;
+      }
+
+      // Предикат только с '~' - одна переменная на случайном месте.
+      if (!predTempl.arguments.empty() && hasOnlyAnyArguments(predTempl))
+      {
+         int& argument = predTempl.arguments[m_rand.Generate(0, countArg - 1)];
+         argument = m_rand.Generate(0, fullCond.maxArgument + 1);
+         if (argument == fullCond.maxArgument + 1)
+            ++fullCond.maxArgument;
+      }
+
+      bringArgumentsBackToNormal(fullCond);
+   }
+}
+
+void CGeneticAlgorithm::repairCondition(SCondition& cond_, size_t iCond_) const
+{
+   const SCondition& original = m_original.at(iCond_);
+   if (cond_.left.empty() || cond_.right.empty())
+   {
+      if (cond_.left.empty())
+         cond_.left.push_back(original.left.at(m_rand.Generate(0, original.left.size() - 1)));
+
+      if (cond_.right.empty())
+         cond_.right.push_back(original.right.at(m_rand.Generate(0, original.right.size() - 1)));
+
+      cond_.RecalculateMaximum();
+   }
+
+   cond_.ForEachPredicate([this, &cond_](SPredicateTemplate& predTempl)
+      {
+         if (predTempl.arguments.empty() || !hasOnlyAnyArguments(predTempl))
+            return;
+
+         int& argument = predTempl.arguments[m_rand.Generate(0, predTempl.arguments.size() - 1)];
+         argument = m_rand.Generate(0, cond_.maxArgument + 1);
+         if (argument == cond_.maxArgument + 1)
+            ++cond_.maxArgument;
+      });
+}
+
+CGeneticAlgorithm::TScriptGeneration CGeneticAlgorithm::scriptGeneration(const TGeneration& generation_) const
+{
+   TScriptGeneration scriptGeneration;
+   scriptGeneration.reserve(generation_.size());
+
+   for (const auto& [individual, fitness] : generation_)
+   {
+      if (individual.size() != m_original.size())
+         throw CException("Попытка перевода в правки ограничения целостности другого размера. Обратитесь к разработчику.", "Непредвиденная ошибка.", "CGeneticAlgorithm::scriptGeneration");
+
+      std::vector<CEditScript> vScripts;
+      vScripts.reserve(individual.size());
+      for (size_t iCond = 0; iCond < individual.size(); ++iCond)
+         vScripts.push_back(CEditScript::FromCondition(m_original[iCond], individual[iCond]));
+
+      scriptGeneration.emplace_back(std::move(vScripts), fitness);
+   }
+
+   return scriptGeneration;
+}
+
+CGeneticAlgorithm::TIntLimAndFitness CGeneticAlgorithm::materializeIndividual(const TScriptIndividual& individual_) const
+{
+   TIntegrityLimitation conds;
+   conds.reserve(individual_.first.size());
+   for (size_t iCond = 0; iCond < individual_.first.size(); ++iCond)
+      conds.push_back(individual_.first[iCond].Materialize(m_original.at(iCond)));
+
+   return std::make_pair(std::move(conds), individual_.second);
+}
+
+std::vector<CEditScript> CGeneticAlgorithm::CrossingScripts(const std::vector<CEditScript>& parent1_, const std::vector<CEditScript>& parent2_) const
+{
+   if (parent1_.size() != parent2_.size() || parent1_.size() != m_original.size())
+      throw CException("Разное количество условий целостности у родителей!", "Ошибка скрещивания", "CGeneticAlgorithm::CrossingScripts");
+
+   std::vector<CEditScript> child;
+   child.reserve(parent1_.size());
+
+   for (size_t iCond = 0; iCond < parent1_.size(); ++iCond)
+   {
+      const SCondition& original = m_original[iCond];
+      const CEditScript& script1 = parent1_[iCond];
+      const CEditScript& script2 = parent2_[iCond];
+
+      CEditScript newScript;
+
+      for (int iPart = 0; iPart < 2; ++iPart)
+      {
+         // Предикаты изначального условия: правки каждого (удаление, замены аргументов) - от случайного родителя.
+         const size_t countOriginal = (iPart ? original.right : original.left).size();
+         for (size_t iPred = 0; iPred < countOriginal; ++iPred)
+            newScript.CopyPredicate(m_rand.Generate(0, 1) ? script2 : script1, iPart, iPred);
+
+         // Добавленные предикаты: общие места - от случайного родителя, остальные - с вероятностью 1/2.
+         const TPartCondition& inserted1 = script1.Inserted(iPart);
+         const TPartCondition& inserted2 = script2.Inserted(iPart);
+         const size_t minPred = qMin(inserted1.size(), inserted2.size());
+         for (size_t iPred = 0; iPred < minPred; ++iPred)
+            newScript.Insert(iPart, m_rand.Generate(0, 1) ? inserted2[iPred] : inserted1[iPred]);
+
+         const TPartCondition& insertedL = inserted1.size() == minPred ? inserted2 : inserted1;
+         for (size_t iPred = minPred; iPred < insertedL.size(); ++iPred)
+            if (m_rand.Generate(0, 1))
+               newScript.Insert(iPart, insertedL[iPred]);
+      }
+
+      repairScript(newScript, iCond);
+      child.push_back(std::move(newScript));
+   }
+
+   return child;
+}
+
+void CGeneticAlgorithm::MutationScriptArguments(std::vector<CEditScript>& individual_, double ratio_) const
+{
+   if (ratio_ <= 0.)
+      return;
+
+   size_t countAllArg = 0;
+   for (size_t iCond = 0; iCond < individual_.size(); ++iCond)
+      for (int iPart = 0; iPart < 2; ++iPart)
+         for (size_t iPred = 0; iPred < individual_[iCond].CountPredicates(m_original.at(iCond), iPart); ++iPred)
+            countAllArg += individual_[iCond].Predicate(m_original[iCond], iPart, iPred).arguments.size();
+
+   const size_t iLastCondition = individual_.size() - 1;
+
+   const size_t countMutations = qMax(static_cast<size_t>(ratio_ * countAllArg), static_cast<size_t>(1));
+   for (size_t i = 0; i < countMutations; ++i)
+   {
+      const size_t iCond = m_rand.Generate(0, iLastCondition); // выбор условия
+      const SCondition& original = m_original.at(iCond);
+      CEditScript& script = individual_[iCond];
+      const int iPart = m_rand.Generate(0, 1) ? 1 : 0; // выбор части условия (правая или левая)
+      const size_t countPred = script.CountPredicates(original, iPart);
+      if (countPred == 0)
+         continue;
+
+      const size_t iPred = m_rand.Generate(0, countPred - 1); // выбор конкретного предиката в условии целостности
+      const SPredicateTemplate predTempl = script.Predicate(original, iPart, iPred);
+      const size_t iArg = m_rand.Generate(0, predTempl.arguments.size() - 1); // выбор позиции (индекса) аргумента
+
+      // Если остальные аргументы - '~', новый аргумент - только переменная (предикат не остается только с '~').
+      bool bOthersAny = true;
+      for (size_t iOther = 0; iOther < predTempl.arguments.size() && bOthersAny; ++iOther)
+         bOthersAny = iOther == iArg || predTempl.arguments[iOther] == -1;
+
+      const int maxArgument = script.MaxArgument(original);
+      const int newValueArg = static_cast<int>(m_rand.Generate(bOthersAny ? 1 : 0, maxArgument + 2)) - 1; // новое значение аргумента
+      script.SetPredicateArgument(original, iPart, iPred, iArg, newValueArg);
+   }
+}
+
+void CGeneticAlgorithm::MutationScriptPredicates(std::vector<CEditScript>& individual_, double ratio_) const
+{
+   if (ratio_ <= 0.)
+      return;
+
+   size_t countPredicats = 0;
+   for (size_t iCond = 0; iCond < individual_.size(); ++iCond)
+      countPredicats += individual_[iCond].CountPredicates(m_original.at(iCond), 0) + individual_[iCond].CountPredicates(m_original[iCond], 1);
+
+   const size_t iLastCondition = individual_.size() - 1;
+   const size_t iLastPredicate = m_storage->CountPredicates() - 1;
+
+   const size_t countMutations = qMax(static_cast<size_t>(ratio_ * countPredicats), static_cast<size_t>(1));
+   for (size_t i = 0; i < countMutations; ++i)
+   {
+      const size_t iCond = m_rand.Generate(0, iLastCondition); // выбор условия
+      const SCondition& original = m_original.at(iCond);
+      CEditScript& script = individual_[iCond];
+      const int iPart = m_rand.Generate(0, 1) ? 1 : 0; // выбор части условия (правая или левая)
+      const size_t countPred = script.CountPredicates(original, iPart);
+      if (countPred == 0)
+         continue;
+
+      const size_t iPred = m_rand.Generate(0, countPred - 1); // выбор конкретного предиката в условии целостности (места)
+      int maxArgument = script.MaxArgument(original);
+
+      SPredicateTemplate predTempl;
+      predTempl.idxPredicate = m_rand.Generate(0, iLastPredicate); // новый предикат на том же месте
+      const size_t countArg = m_storage->CountArguments(predTempl.idxPredicate);
+      predTempl.arguments.resize(countArg);
+      for (size_t iArg = 0; iArg < countArg; ++iArg)
+      {
+         predTempl.arguments[iArg] = m_rand.Generate(0, maxArgument + 2) - 1;
+         if (predTempl.arguments.at(iArg) == maxArgument + 1)
+            ++maxArgument;
+      }
+
+      // Предикат только с '~' - одна переменная на случайном месте.
+      if (!predTempl.arguments.empty() && hasOnlyAnyArguments(predTempl))
+      {
+         int& argument = predTempl.arguments[m_rand.Generate(0, countArg - 1)];
+         argument = m_rand.Generate(0, maxArgument + 1);
+      }
+
+      script.ReplacePredicate(original, iPart, iPred, predTempl);
+      script.Normalize(original);
+   }
+}
+
+void CGeneticAlgorithm::repairScript(CEditScript& script_, size_t iCond_) const
+{
+   const SCondition& original = m_original.at(iCond_);
+
+   // Пустая часть - восстанавливается случайный предикат изначальной части.
+   for (int iPart = 0; iPart < 2; ++iPart)
+   {
+      const TPartCondition& part = iPart ? original.right : original.left;
+      if (script_.CountPredicates(original, iPart) == 0)
+         script_.Restore(iPart, m_rand.Generate(0, part.size() - 1));
+   }
+
+   int maxArgument = script_.MaxArgument(original);
+   for (int iPart = 0; iPart < 2; ++iPart)
+      for (size_t iPred = 0; iPred < script_.CountPredicates(original, iPart); ++iPred)
       {
-         predTempl.arguments[iArg] = m_rand.Generate(0, fullCond.maxArgument + 2) - 1;
-         if (predTempl.arguments.at(iArg) == fullCond.maxArgument + 1)
-            ++fullCond.maxArgument;
-      }
+         const SPredicateTemplate predTempl = script_.Predicate(original, iPart, iPred);
+         if (predTempl.arguments.empty() || !hasOnlyAnyArguments(predTempl))
+            continue;
 
-      bringArgumentsBackToNormal(fullCond);
-   }
+         const size_t iArg = m_rand.Generate(0, predTempl.arguments.size() - 1);
+         const int argument = m_rand.Generate(0, maxArgument + 1);
+         if (argument == maxArgument + 1)
+            ++maxArgument;
+
+         script_.SetPredicateArgument(original, iPart, iPred, iArg, argument);
+      }
 }
 
 size_t CGeneticAlgorithm::CountAllPredicates(const TIntegrityLimitation& individual_) const
@@ -655,15 +1881,28 @@ bool CGeneticAlgorithm::IsTrueCondition(const SCondition& Cond_) const
 {
    std::vector<SPredicate> vPredLeft, vPredRight;
    for (auto predTemp : Cond_.left)
-      vPredLeft.push_back(m_storage.GetPredicate(predTemp.idxPredicate));
+      vPredLeft.push_back(m_storage->GetPredicate(predTemp.idxPredicate));
 
    for (auto predTemp : Cond_.right)
-      vPredRight.push_back(m_storage.GetPredicate(predTemp.idxPredicate));
+      vPredRight.push_back(m_storage->GetPredicate(predTemp.idxPredicate));
 
-   const size_t countVariables = m_storage.CountVariables();
+   const size_t countVariables = m_storage->CountVariables();
+
+   // Счетчики проверки, добавляются в m_evaluationCounters один раз при выходе.
+   SEvaluationCounts counts;
+   counts.evaluations = 1;
+   auto finish = [this, &counts, &Cond_](bool bResult_)
+      {
+         counts.falseResults = bResult_ ? 0 : 1;
+         m_evaluationCounters.Add(static_cast<size_t>(Cond_.maxArgument + 1), counts);
+         return bResult_;
+      };
 
    try
    {
+      QElapsedTimer timerAnyMap;
+      timerAnyMap.start();
+
       // Заполняем мапину для предикат имеющих -1 в аргументе.
       std::map<SPredicateTemplate, std::vector<bool>> mapPredAnyArg;
       bool bHasAnyPred = false;
@@ -703,12 +1942,15 @@ bool CGeneticAlgorithm::IsTrueCondition(const SCondition& Cond_) const
                newVArg[iArg] = itReplace->second;
             }
 
-            SPredicate predicate = m_storage.GetPredicate(predTempl.idxPredicate);
+            SPredicate predicate = m_storage->GetPredicate(predTempl.idxPredicate);
             CCounterWithoutRepeat<size_t> counterArg(0, countVariables, predTempl.arguments.size() - countAnyArg);
             const size_t countIteration = counterArg.countIterations();
             const size_t countAnyIter = CCounterWithoutRepeat<size_t>(0, countVariables, countAnyArg).countIterations();
             for (size_t iteration = 0; iteration < countIteration; ++iteration, ++counterArg)
             {
+               if (iteration % STOP_CHECK_PERIOD == STOP_CHECK_PERIOD - 1 && isStopRequested())
+                  throw SStopRequest();
+
                const std::vector<size_t>& vSubstitution = counterArg.get();
 
                // Формируем вектор аргументов которые зафиксированны, и вектор только зафиксированных.
@@ -749,14 +1991,24 @@ bool CGeneticAlgorithm::IsTrueCondition(const SCondition& Cond_) const
             }
          });
 
-      if (bHasAnyPred)
-         return false;
+      if (bHasAnyPred || !mapPredAnyArg.empty())
+      {
+         counts.anyMapBuilds = 1;
+         counts.anyMapTime = static_cast<quint64>(timerAnyMap.nsecsElapsed());
+      }
 
+      if (bHasAnyPred)
+         return finish(false);
 
       CCounterWithoutRepeat<size_t> argCounter(0, countVariables, Cond_.maxArgument + 1);
       const size_t countIteration = argCounter.countIterations();
       for (size_t iteration = 0; iteration < countIteration; ++iteration, ++argCounter)
       {
+         if (iteration % STOP_CHECK_PERIOD == STOP_CHECK_PERIOD - 1 && isStopRequested())
+            throw SStopRequest();
+
+         ++counts.placements;
+
          // Если в левой части 0, то импликация всегда истинна. (0->X = 1)
          // Если в правой части 1, то импликация тоже всегда истинна. (X->1 = 1)
 
@@ -771,6 +2023,7 @@ bool CGeneticAlgorithm::IsTrueCondition(const SCondition& Cond_) const
             auto it = mapPredAnyArg.find(predTempl);
             if (it != mapPredAnyArg.end())
             {
+               ++counts.anyMapLookups;
                std::vector<size_t> fixedArg;
                for (int arg : predTempl.arguments)
                   if (arg != -1)
@@ -787,201 +2040,787 @@ bool CGeneticAlgorithm::IsTrueCondition(const SCondition& Cond_) const
             }
             else
             {
+               ++counts.tableLookups;
+
+               // Формируем вектор аргументов из подстановочного вектора.
+               std::vector<size_t> arg(predTempl.arguments.size());
+               for (size_t j = 0; j < arg.size(); ++j)
+                  arg[j] = vSubstitution[predTempl.arguments[j]];
+
+               // Получаем индекс из таблицы.
+               size_t idxArg = vPredLeft[i].GetIndex(countVariables, arg);
+
+               // Проверяем
+               if (!vPredLeft[i].table.at(idxArg))
+               {
+                  // Импликация истина.
+                  isTrueForOne = true;
+                  break;
+               }
+            }
+         }
+
+         if (isTrueForOne)
+         {
+            ++counts.leftFalseExits;
+            continue;
+         }
+
+         // Проверяем для одной подстановки правую часть.
+         for (size_t i = 0; i < vPredRight.size(); ++i)
+         {
+            const auto& predTempl = Cond_.right[i];
+            // Ищем в мапине содержащий предикаты с одним или более не зафиксированным аргументом.
+            auto it = mapPredAnyArg.find(predTempl);
+            if (it != mapPredAnyArg.end())
+            {
+               ++counts.anyMapLookups;
+               std::vector<size_t> fixedArg;
+               for (int arg : predTempl.arguments)
+                  if (arg != -1)
+                     fixedArg.push_back(vSubstitution[arg]);
+
+               size_t idxFixedArg = GetIndex(countVariables, fixedArg);
+
+               if (it->second.at(idxFixedArg))
+               {
+                  // Импликация истина.
+                  isTrueForOne = true;
+                  break;
+               }
+            }
+            else
+            {
+               ++counts.tableLookups;
+
                // Формируем вектор аргументов из подстановочного вектора.
                std::vector<size_t> arg(predTempl.arguments.size());
                for (size_t j = 0; j < arg.size(); ++j)
                   arg[j] = vSubstitution[predTempl.arguments[j]];
 
-               // Получаем индекс из таблицы.
-               size_t idxArg = vPredLeft[i].GetIndex(countVariables, arg);
+               // Получаем индекс из таблицы.
+               size_t idxArg = vPredRight[i].GetIndex(countVariables, arg);
+
+               // Проверяем
+               if (vPredRight[i].table.at(idxArg))
+               {
+                  // Импликация истина.
+                  isTrueForOne = true;
+                  break;
+               }
+            }
+         }
+
+         if (!isTrueForOne)
+            return finish(false);
+
+         ++counts.rightTrueExits;
+      }
+   }
+   catch (std::exception error)
+   {
+      throw CException(error.what(), "Ошибка проверки условия", "CGeneticAlgorithm::IsTrueCondition");
+   }
+
+   return finish(true);
+}
+
+double CGeneticAlgorithm::FitnessFunction(const TIntegrityLimitation& conds_) const
+{
+   if (m_original.size() != conds_.size())
+      throw CException("Попытка фитнеса двух разных ограничений целостности. Обратитесь к разработчику.", "Непредвиденная ошибка.", "CGeneticAlgorithm::FitnessFunction");
+
+   double fitnes = 0;
+
+   for (size_t iCond = 0; iCond < m_original.size(); ++iCond)
+      fitnes += conditionFitness(iCond, conds_.at(iCond)) / m_original.size();
+
+   return fitnes;
+}
+
+double CGeneticAlgorithm::conditionFitness(size_t iCond_, const SCondition& cond_) const
+{
+   if (!IsCorrectCondition(cond_))
+      return -1.;
+
+   SCounts count;
+
+   count += quantitativeAssessment(m_original.at(iCond_).left, m_vOriginalIndex.at(iCond_)[0], cond_.left);
+   count += quantitativeAssessment(m_original.at(iCond_).right, m_vOriginalIndex.at(iCond_)[1], cond_.right);
+
+   // Истинность поколения проверяется заранее (evaluateBatches, события по группам условий),
+   // здесь обычно только поиск результата.
+   CTraceScope trace(m_trace.get(), "isTrueConditionCached");
+   trace.Arg("condition", iCond_).Arg("variables", cond_.maxArgument + 1);
+   return countsFitness(count, isTrueConditionCached(cond_));
+}
+
+double CGeneticAlgorithm::sumFitness(const std::vector<double>& vFitness_)
+{
+   double fitnes = 0;
+   for (double fitnessCond : vFitness_)
+      fitnes += fitnessCond / vFitness_.size();
+
+   return fitnes;
+}
+
+size_t CGeneticAlgorithm::localSearch(TIntLimAndFitness& individual_) const
+{
+   TIntegrityLimitation& conds = individual_.first;
+   if (conds.size() != m_original.size())
+      throw CException("Попытка локального поиска для ограничения целостности другого размера. Обратитесь к разработчику.", "Непредвиденная ошибка.", "CGeneticAlgorithm::localSearch");
+
+   // Фитнес особи - сумма фитнесов условий, поэтому сосед сравнивается только по измененному условию.
+   std::vector<double> vFitness(conds.size());
+   for (size_t iCond = 0; iCond < conds.size(); ++iCond)
+      vFitness[iCond] = conditionFitness(iCond, conds[iCond]);
+
+   // Фитнес особи обновляется и при остановке во время проверки условия, найденные улучшения сохраняются.
+   auto updateFitness = [&individual_, &vFitness]()
+   {
+      individual_.second = sumFitness(vFitness);
+   };
+
+   size_t countChecked = 0;
+   std::vector<SCondition> vNeighbors;
+
+   try
+   {
+      bool bImproved = true;
+      while (bImproved && countChecked < m_localSearchNeighbors && !isStopRequested())
+      {
+         bImproved = false;
+         for (size_t iCond = 0; iCond < conds.size() && countChecked < m_localSearchNeighbors; ++iCond)
+         {
+            vNeighbors.clear();
+            editConditions(conds[iCond], &m_original[iCond], vNeighbors);
+
+            for (auto& neighbor : vNeighbors)
+            {
+               if (countChecked >= m_localSearchNeighbors)
+                  break;
+
+               ++countChecked;
+               const double fitness = conditionFitness(iCond, neighbor);
+               if (fitness > vFitness[iCond])
+               {
+                  conds[iCond] = std::move(neighbor);
+                  vFitness[iCond] = fitness;
+                  bImproved = true;
+                  break;
+               }
+            }
+         }
+      }
+   }
+   catch (const SStopRequest&)
+   {
+      updateFitness();
+      throw;
+   }
+
+   updateFitness();
+   return conds.size() + countChecked;
+}
+
+double CGeneticAlgorithm::scriptFitnessFunction(const std::vector<CEditScript>& scripts_, const TIntegrityLimitation& conds_) const
+{
+   if (m_original.size() != scripts_.size() || m_original.size() != conds_.size())
+      throw CException("Попытка фитнеса двух разных ограничений целостности. Обратитесь к разработчику.", "Непредвиденная ошибка.", "CGeneticAlgorithm::scriptFitnessFunction");
+
+   // Те же действия, что и в FitnessFunction, чтобы значения совпадали точно.
+   double fitnes = 0;
+
+   for (size_t iCond = 0; iCond < m_original.size(); ++iCond)
+      fitnes += scriptFitness(iCond, scripts_[iCond], conds_[iCond]) / m_original.size();
+
+   return fitnes;
+}
+
+double CGeneticAlgorithm::scriptFitness(size_t iCond_, const CEditScript& script_, const SCondition& cond_) const
+{
+   SCounts count;
+   bool bCorrect = false;
+
+   // Правки, для которых счетчики по ним не считаются, - по материализованному условию.
+   if (!scriptCounts(m_original.at(iCond_), m_vOriginalBase.at(iCond_), script_, count, bCorrect))
+      return conditionFitness(iCond_, cond_);
+
+   if (!bCorrect)
+      return -1.;
+
+   CTraceScope trace(m_trace.get(), "isTrueConditionCached");
+   trace.Arg("condition", iCond_).Arg("variables", cond_.maxArgument + 1);
+   return countsFitness(count, isTrueConditionCached(cond_));
+}
+
+size_t CGeneticAlgorithm::localSearchScript(TScriptIndividual& individual_) const
+{
+   TIntLimAndFitness materialized = materializeIndividual(individual_);
+
+   // Улучшенная особь возвращается в правки и при остановке, найденные улучшения сохраняются.
+   auto updateScripts = [this, &materialized, &individual_]()
+   {
+      for (size_t iCond = 0; iCond < materialized.first.size(); ++iCond)
+         individual_.first[iCond] = CEditScript::FromCondition(m_original[iCond], materialized.first[iCond]);
+
+      individual_.second = materialized.second;
+   };
+
+   size_t countChecked = 0;
+   try
+   {
+      countChecked = localSearch(materialized);
+   }
+   catch (const SStopRequest&)
+   {
+      updateScripts();
+      throw;
+   }
+
+   updateScripts();
+   return countChecked;
+}
+
+double CGeneticAlgorithm::conditionFitnessBound(size_t iCond_, const SCondition& cond_) const
+{
+   if (!IsCorrectCondition(cond_))
+      return -1.;
+
+   SCounts count;
+
+   count += quantitativeAssessment(m_original.at(iCond_).left, m_vOriginalIndex.at(iCond_)[0], cond_.left);
+   count += quantitativeAssessment(m_original.at(iCond_).right, m_vOriginalIndex.at(iCond_)[1], cond_.right);
+
+   return fitnessBound(count);
+}
+
+double CGeneticAlgorithm::fitnessBound(const SCounts& count_) const
+{
+   return countsFitness(count_, true);
+}
+
+double CGeneticAlgorithm::countsFitness(const SCounts& count_, bool bTrue_) const
+{
+   const double dMultiplierArgs = getMultiplierArguments(count_.diffArg, count_.totalArg);
+
+   double fitnesCond = bTrue_ ? 0. : -1.;
+   fitnesCond += dMultiplierArgs * count_.matchPred;
+   fitnesCond += m_costAddingPredicate * count_.addedPred;
+   fitnesCond /= count_.matchPred + count_.addedPred + count_.deletedPred;
+
+   return fitnesCond;
+}
+
+double CGeneticAlgorithm::scriptFitnessBound(size_t iCond_, const CEditScript::TBase& base_, const CEditScript& script_) const
+{
+   SCounts count;
+   bool bCorrect = false;
+
+   if (!scriptCounts(m_original.at(iCond_), base_, script_, count, bCorrect))
+      return conditionFitnessBound(iCond_, script_.Materialize(m_original.at(iCond_)));
+
+   if (!bCorrect)
+      return -1.;
+
+   return fitnessBound(count);
+}
+
+bool CGeneticAlgorithm::scriptCounts(const SCondition& original_, const CEditScript::TBase& base_, const CEditScript& script_, SCounts& count_, bool& bCorrect_)
+{
+   // При различных предикатах изначальной части каждый ее оставшийся предикат сопоставляется только
+   // со своей копией, если добавленные предикаты не совпадают с ним по индексу.
+   for (int iPart = 0; iPart < 2; ++iPart)
+   {
+      if (!base_[iPart].bDistinct)
+         return false;
+
+      for (const auto& predTempl : script_.Inserted(iPart))
+         if (std::binary_search(base_[iPart].vPredicates.begin(), base_[iPart].vPredicates.end(), predTempl.idxPredicate))
+            return false;
+   }
+
+   SCounts count;
+   count.totalArg = base_[0].totalArg + base_[1].totalArg;
+
+   std::array<size_t, 2> aDeleted = { 0, 0 };
+   std::array<size_t, 2> aNoVariables = { base_[0].countNoVariables, base_[1].countNoVariables };
+
+   // Правки упорядочены по части и предикату: правки одного предиката идут подряд.
+   const std::vector<SEdit>& vEdits = script_.Edits();
+   for (size_t iEdit = 0; iEdit < vEdits.size();)
+   {
+      const int iPart = vEdits[iEdit].part;
+      const size_t position = vEdits[iEdit].position;
+      const SPredicateTemplate& predTempl = (iPart ? original_.right : original_.left).at(position);
+      const size_t countVariablesBefore = base_[iPart].vVariables.at(position);
+
+      size_t countVariables = countVariablesBefore;
+      size_t countChanged = 0;
+      bool bDeleted = false;
+
+      for (; iEdit < vEdits.size() && vEdits[iEdit].part == iPart && vEdits[iEdit].position == position; ++iEdit)
+      {
+         const SEdit& edit = vEdits[iEdit];
+         if (edit.type == eEditDelete)
+         {
+            bDeleted = true;
+            continue;
+         }
+
+         ++countChanged;
+         countVariables += (edit.value != -1);
+         countVariables -= (predTempl.arguments.at(edit.argument) != -1);
+      }
+
+      if (countVariablesBefore == 0)
+         --aNoVariables[iPart];
+
+      if (bDeleted)
+      {
+         ++aDeleted[iPart];
+         count.totalArg -= predTempl.arguments.size();
+         continue;
+      }
+
+      count.diffArg += countChanged;
+      if (countVariables == 0)
+         ++aNoVariables[iPart];
+   }
+
+   bCorrect_ = true;
+   for (int iPart = 0; iPart < 2; ++iPart)
+   {
+      const TPartCondition& inserted = script_.Inserted(iPart);
+      const size_t countKept = base_[iPart].vVariables.size() - aDeleted[iPart];
+
+      count.matchPred += countKept;
+      count.deletedPred += aDeleted[iPart];
+      count.addedPred += inserted.size();
+
+      if (countKept + inserted.size() == 0 || aNoVariables[iPart] > 0)
+         bCorrect_ = false;
+
+      for (const auto& predTempl : inserted)
+         if (std::all_of(predTempl.arguments.begin(), predTempl.arguments.end(), [](int arg_) { return arg_ == -1; }))
+            bCorrect_ = false;
+   }
+
+   count_ = count;
+   return true;
+}
+
+SExactRepair CGeneticAlgorithm::exactRepair(size_t iCond_, int maxEdits_, size_t maxCandidates_, SCondition& best_) const
+{
+   SExactRepair repair;
+   repair.bComplete = true;
+
+   // Проверка остановки без привязки к потоку запуска (условия обрабатываются в потоках пула).
+   auto bStop = [this]()
+   {
+      return m_bStopRequested.load(std::memory_order_relaxed) || m_deadline.hasExpired();
+   };
+
+   // Кандидат - правки изначального условия, верхняя граница фитнеса и количество правок.
+   // Условие материализуется только для раскрытия и проверки истинности.
+   struct SCandidate
+   {
+      CEditScript script;
+      double bound = 0;
+      int countEdits = 0;
+   };
+
+   const SCondition& original = m_original.at(iCond_);
+   const CEditScript::TBase base = CEditScript::Describe(original);
+
+   std::vector<SCandidate> vCandidates;
+   std::unordered_set<CEvaluationCache::TKey, CEvaluationCache::SKeyHash> keys;
+
+   // Добавляет кандидата, если таких правок еще не было. Возвращает false, если кандидатов слишком много.
+   auto addCandidate = [&](CEditScript&& script_, int countEdits_)
+   {
+      if (!keys.insert(script_.Key()).second)
+         return true;
+
+      if (vCandidates.size() >= maxCandidates_)
+      {
+         repair.bComplete = false;
+         return false;
+      }
+
+      const double bound = scriptFitnessBound(iCond_, base, script_);
+      vCandidates.push_back({ std::move(script_), bound, countEdits_ });
+      return true;
+   };
+
+   addCandidate(CEditScript(), 0);
+
+   // Кандидаты строятся по уровням: на уровне edits - условия, впервые полученные edits правками.
+   std::vector<CEditScript> vEdited;
+   size_t beginLevel = 0;
+   for (int edits = 1; edits <= maxEdits_ && repair.bComplete; ++edits)
+   {
+      const size_t endLevel = vCandidates.size();
+      for (size_t iCandidate = beginLevel; iCandidate < endLevel && repair.bComplete; ++iCandidate)
+      {
+         if (bStop())
+         {
+            repair.bComplete = false;
+            break;
+         }
+
+         vEdited.clear();
+         editScripts(iCond_, vCandidates[iCandidate].script, vEdited);
 
-               // Проверяем
-               if (!vPredLeft[i].table.at(idxArg))
-               {
-                  // Импликация истина.
-                  isTrueForOne = true;
-                  break;
-               }
-            }
-         }
+         for (auto& edited : vEdited)
+            if (!addCandidate(std::move(edited), edits))
+               break;
+      }
 
-         if (isTrueForOne)
-            continue;
+      beginLevel = endLevel;
+   }
 
-         // Проверяем для одной подстановки правую часть.
-         for (size_t i = 0; i < vPredRight.size(); ++i)
-         {
-            const auto& predTempl = Cond_.right[i];
-            // Ищем в мапине содержащий предикаты с одним или более не зафиксированным аргументом.
-            auto it = mapPredAnyArg.find(predTempl);
-            if (it != mapPredAnyArg.end())
-            {
-               std::vector<size_t> fixedArg;
-               for (int arg : predTempl.arguments)
-                  if (arg != -1)
-                     fixedArg.push_back(vSubstitution[arg]);
+   repair.countCandidates = vCandidates.size();
 
-               size_t idxFixedArg = GetIndex(countVariables, fixedArg);
+   // Проверка в порядке убывания границы: как только граница не больше найденного фитнеса,
+   // ни один из оставшихся кандидатов не может быть лучше.
+   std::vector<size_t> vOrder(vCandidates.size());
+   std::iota(vOrder.begin(), vOrder.end(), 0);
+   std::stable_sort(vOrder.begin(), vOrder.end(), [&vCandidates](size_t a_, size_t b_)
+      {
+         return vCandidates[a_].bound > vCandidates[b_].bound;
+      });
 
-               if (it->second.at(idxFixedArg))
-               {
-                  // Импликация истина.
-                  isTrueForOne = true;
-                  break;
-               }
-            }
-            else
-            {
-               // Формируем вектор аргументов из подстановочного вектора.
-               std::vector<size_t> arg(predTempl.arguments.size());
-               for (size_t j = 0; j < arg.size(); ++j)
-                  arg[j] = vSubstitution[predTempl.arguments[j]];
+   size_t idxBest = SIZE_MAX;
 
-               // Получаем индекс из таблицы.
-               size_t idxArg = vPredRight[i].GetIndex(countVariables, arg);
+   try
+   {
+      for (size_t idxCandidate : vOrder)
+      {
+         const SCandidate& candidate = vCandidates[idxCandidate];
+         if (idxBest != SIZE_MAX && candidate.bound <= repair.fitness)
+            break;
 
-               // Проверяем
-               if (vPredRight[i].table.at(idxArg))
-               {
-                  // Импликация истина.
-                  isTrueForOne = true;
-                  break;
-               }
-            }
+         if (bStop())
+         {
+            repair.bComplete = false;
+            break;
          }
 
-         if (!isTrueForOne)
-            return false;
+         ++repair.countChecked;
+         const double fitness = conditionFitness(iCond_, candidate.script.Materialize(original));
+         if (idxBest == SIZE_MAX || fitness > repair.fitness)
+         {
+            idxBest = idxCandidate;
+            repair.fitness = fitness;
+         }
       }
    }
-   catch (std::exception error)
+   catch (const SStopRequest&)
    {
-      throw CException(error.what(), "Ошибка проверки условия", "CGeneticAlgorithm::IsTrueCondition");
+      repair.bComplete = false;
    }
 
-   return true;
+   // Ни одного кандидата не проверено (остановка) - остается изначальное условие.
+   if (idxBest == SIZE_MAX)
+   {
+      best_ = original;
+      return repair;
+   }
+
+   best_ = vCandidates[idxBest].script.Materialize(original);
+   repair.countEdits = vCandidates[idxBest].countEdits;
+   return repair;
 }
 
-double CGeneticAlgorithm::FitnessFunction(const TIntegrityLimitation& conds_) const
+void CGeneticAlgorithm::editConditions(const SCondition& cond_, const SCondition* pOriginal_, std::vector<SCondition>& vEdited_) const
 {
-   if (m_original.size() != conds_.size())
-      throw CException("Попытка фитнеса двух разных ограничений целостности. Обратитесь к разработчику.", "Непредвиденная ошибка.", "CGeneticAlgorithm::FitnessFunction");
-
-   double fitnes = 0;
+   // Добавляет условие с пересчитанным максимальным аргументом.
+   auto addEdited = [&vEdited_](SCondition&& edited_)
+   {
+      edited_.maxArgument = -1;
+      edited_.RecalculateMaximum();
+      vEdited_.push_back(std::move(edited_));
+   };
 
-   for (size_t iCond = 0; iCond < m_original.size(); ++iCond)
+   for (int iPart = 0; iPart < 2; ++iPart)
    {
-      if (!IsCorrectCondition(conds_.at(iCond)))
+      const TPartCondition& part = iPart ? cond_.right : cond_.left;
+
+      // Замена одного аргумента: сначала '~' (или переменная вместо '~'), затем остальные переменные.
+      for (size_t iPred = 0; iPred < part.size(); ++iPred)
+         for (size_t iArg = 0; iArg < part[iPred].arguments.size(); ++iArg)
+         {
+            const int current = part[iPred].arguments[iArg];
+            for (int value = -1; value <= cond_.maxArgument + 1; ++value)
+            {
+               if (value == current)
+                  continue;
+
+               SCondition edited = cond_;
+               (iPart ? edited.right : edited.left)[iPred].arguments[iArg] = value;
+               addEdited(std::move(edited));
+            }
+         }
+
+      // Удаление предиката (часть не остается пустой).
+      if (part.size() > 1)
+         for (size_t iPred = 0; iPred < part.size(); ++iPred)
+         {
+            SCondition edited = cond_;
+            TPartCondition& editedPart = iPart ? edited.right : edited.left;
+            editedPart.erase(editedPart.begin() + iPred);
+            addEdited(std::move(edited));
+         }
+
+      // Добавление предиката изначального условия, которого в части нет.
+      if (pOriginal_)
       {
-         fitnes += -1. / m_original.size();
-         continue;
-      }
+         for (const auto& predTempl : iPart ? pOriginal_->right : pOriginal_->left)
+         {
+            const bool bHas = std::any_of(part.begin(), part.end(), [&predTempl](const SPredicateTemplate& other_)
+               {
+                  return other_.idxPredicate == predTempl.idxPredicate && other_.arguments == predTempl.arguments;
+               });
 
-      SCounts count;
+            if (bHas)
+               continue;
 
-      count += quantitativeAssessment(m_original.at(iCond).left, conds_.at(iCond).left);
-      count += quantitativeAssessment(m_original.at(iCond).right, conds_.at(iCond).right);
+            SCondition edited = cond_;
+            (iPart ? edited.right : edited.left).push_back(predTempl);
+            addEdited(std::move(edited));
+         }
 
-      const double dMultiplierArgs = getMultiplierArguments(count.diffArg, count.totalArg);
-      double fitnesCond = IsTrueCondition(conds_.at(iCond)) ? 0. : -1.;
-      fitnesCond += dMultiplierArgs * count.matchPred;
-      fitnesCond += m_costAddingPredicate * count.addedPred;
-      fitnesCond /= count.matchPred + count.addedPred + count.deletedPred;
+         continue;
+      }
 
-      fitnes += fitnesCond / m_original.size();
+      // Добавление любого предиката.
+      forEachInsertion(cond_.maxArgument, [&](const SPredicateTemplate& predTempl_)
+         {
+            SCondition edited = cond_;
+            (iPart ? edited.right : edited.left).push_back(predTempl_);
+            addEdited(std::move(edited));
+         });
    }
-
-   return fitnes;
 }
 
-std::multimap<int, size_t> CGeneticAlgorithm::findMinDifference(const SPredicateTemplate& sample_, const TPartCondition& verifiable_) const
+void CGeneticAlgorithm::editScripts(size_t iCond_, const CEditScript& script_, std::vector<CEditScript>& vEdited_) const
 {
-   // Число отличий, индекс в векторе условия.
-   std::multimap<int, size_t> result;
+   const SCondition& original = m_original.at(iCond_);
+   const SCondition cond = script_.Materialize(original);
 
-   try
+   for (int iPart = 0; iPart < 2; ++iPart)
    {
-      const size_t countVariables = m_storage.CountVariables();
-      const std::vector<int>& sampleArgs = sample_.arguments;
+      const TPartCondition& part = iPart ? original.right : original.left;
+      const TPartCondition& inserted = script_.Inserted(iPart);
+      const size_t countPredicates = (iPart ? cond.right : cond.left).size();
 
-      if (sampleArgs.empty())
-         throw CException("Предикат с 0 аргументов недопустим.", "Ошибка", "CGeneticAlgorithm::findMinDifference");
-
-      for (size_t iPredTempl = 0; iPredTempl < verifiable_.size(); ++iPredTempl)
+      // Замена одного аргумента оставшегося предиката изначального условия.
+      for (size_t iPred = 0; iPred < part.size(); ++iPred)
       {
-         const SPredicateTemplate& predTempl = verifiable_.at(iPredTempl);
-         if (predTempl.idxPredicate != sample_.idxPredicate)
+         if (script_.IsDeleted(iPart, iPred))
             continue;
 
-         const std::vector<int>& verArgs = predTempl.arguments;
+         for (size_t iArg = 0; iArg < part[iPred].arguments.size(); ++iArg)
+         {
+            const int current = script_.Argument(original, iPart, iPred, iArg);
+            for (int value = -1; value <= cond.maxArgument + 1; ++value)
+            {
+               if (value == current)
+                  continue;
 
-         if (verArgs.empty() || verArgs.size() != sampleArgs.size())
-            throw CException("", "Ошибка. Обратитесь к разработчику", "CGeneticAlgorithm::findMinDifference");
+               vEdited_.push_back(script_);
+               vEdited_.back().SetArgument(original, iPart, iPred, iArg, value);
+            }
+         }
+      }
 
-         int counter = 0;
-         for (size_t i = 0; i < verArgs.size(); ++i)
+      // Замена одного аргумента добавленного предиката.
+      for (size_t iInserted = 0; iInserted < inserted.size(); ++iInserted)
+         for (size_t iArg = 0; iArg < inserted[iInserted].arguments.size(); ++iArg)
          {
-            if (sampleArgs[i] != verArgs[i])
-               ++counter;
+            const int current = inserted[iInserted].arguments[iArg];
+            for (int value = -1; value <= cond.maxArgument + 1; ++value)
+            {
+               if (value == current)
+                  continue;
+
+               vEdited_.push_back(script_);
+               vEdited_.back().SetInsertedArgument(iPart, iInserted, iArg, value);
+            }
          }
 
-         result.emplace(counter, iPredTempl);
+      // Удаление предиката (часть не остается пустой).
+      if (countPredicates > 1)
+      {
+         for (size_t iPred = 0; iPred < part.size(); ++iPred)
+            if (!script_.IsDeleted(iPart, iPred))
+            {
+               vEdited_.push_back(script_);
+               vEdited_.back().Delete(iPart, iPred);
+            }
+
+         for (size_t iInserted = 0; iInserted < inserted.size(); ++iInserted)
+         {
+            vEdited_.push_back(script_);
+            vEdited_.back().EraseInserted(iPart, iInserted);
+         }
       }
+
+      // Добавление любого предиката.
+      forEachInsertion(cond.maxArgument, [&](const SPredicateTemplate& predTempl_)
+         {
+            vEdited_.push_back(script_);
+            vEdited_.back().Insert(iPart, predTempl_);
+         });
    }
-   catch (CException& error)
+}
+
+void CGeneticAlgorithm::forEachInsertion(int maxArgument_, const std::function<void(const SPredicateTemplate&)>& callback_) const
+{
+   for (size_t idxPredicate = 0; idxPredicate < m_storage->CountPredicates(); ++idxPredicate)
    {
-      if (!strlen(error.message()))
-         error.addToBeginningMessage("Ошибка при нахождении предикатов с минимальным отличием.");
-      else
-         error.message("Ошибка при нахождении предикатов с минимальным отличием.");
+      SPredicateTemplate predTempl(idxPredicate, std::vector<int>(m_storage->CountArguments(idxPredicate), -1));
 
-      throw error;
+      std::function<void(size_t, int, bool)> fillArgument = [&](size_t iArg_, int maxArgument_, bool bHasVariable_)
+      {
+         if (iArg_ == predTempl.arguments.size())
+         {
+            if (bHasVariable_)
+               callback_(predTempl);
+
+            return;
+         }
+
+         for (int value = -1; value <= maxArgument_ + 1; ++value)
+         {
+            predTempl.arguments[iArg_] = value;
+            fillArgument(iArg_ + 1, qMax(maxArgument_, value), bHasVariable_ || value >= 0);
+         }
+      };
+
+      fillArgument(0, maxArgument_, false);
    }
+}
 
-   return result;
+CGeneticAlgorithm::SPartIndex CGeneticAlgorithm::indexPart(const TPartCondition& part_)
+{
+   SPartIndex index;
+   index.vPositions.resize(part_.size());
+   std::iota(index.vPositions.begin(), index.vPositions.end(), 0);
+   std::stable_sort(index.vPositions.begin(), index.vPositions.end(), [&part_](size_t a_, size_t b_)
+      {
+         return part_[a_].idxPredicate < part_[b_].idxPredicate;
+      });
+
+   for (size_t i = 0; i < index.vPositions.size(); ++i)
+   {
+      const size_t idxPredicate = part_[index.vPositions[i]].idxPredicate;
+      if (index.vPredicates.empty() || index.vPredicates.back() != idxPredicate)
+      {
+         index.vPredicates.push_back(idxPredicate);
+         index.vBegins.push_back(i);
+      }
+   }
+
+   index.vBegins.push_back(index.vPositions.size());
+   return index;
+}
+
+void CGeneticAlgorithm::indexOriginal()
+{
+   m_vOriginalIndex.clear();
+   m_vOriginalIndex.reserve(m_original.size());
+   for (const auto& cond : m_original)
+      m_vOriginalIndex.push_back({ indexPart(cond.left), indexPart(cond.right) });
+
+   m_vOriginalBase.clear();
+   m_vOriginalBase.reserve(m_original.size());
+   for (const auto& cond : m_original)
+      m_vOriginalBase.push_back(CEditScript::Describe(cond));
 }
 
-CGeneticAlgorithm::SCounts CGeneticAlgorithm::quantitativeAssessment(const TPartCondition& sample_, const TPartCondition& verifiable_) const
+CGeneticAlgorithm::SCounts CGeneticAlgorithm::quantitativeAssessment(const TPartCondition& sample_, const SPartIndex& index_, const TPartCondition& verifiable_) const
 {
    SCounts count;
+   const size_t countGroups = index_.vPredicates.size();
 
-   std::vector<bool> vUsedPredInst(verifiable_.size(), false);
+   // Буферы потока: после первых вызовов память не выделяется.
+   thread_local std::vector<size_t> vGroupOf, vBegins, vNext, vPositions;
+   thread_local std::vector<int> vCost;
 
-   for (size_t iPredInst = 0; iPredInst < sample_.size(); ++iPredInst)
+   // Предикаты проверяемой части раскладываются по группам изначальной (сортировка подсчетом).
+   // Предикаты, которых в изначальной части нет, - добавленные.
+   vGroupOf.resize(verifiable_.size());
+   vBegins.assign(countGroups + 1, 0);
+   for (size_t iPred = 0; iPred < verifiable_.size(); ++iPred)
    {
-      auto mapIdentical = findMinDifference(sample_.at(iPredInst), verifiable_);
-
-      if (mapIdentical.empty())
+      auto it = std::lower_bound(index_.vPredicates.begin(), index_.vPredicates.end(), verifiable_[iPred].idxPredicate);
+      if (it == index_.vPredicates.end() || *it != verifiable_[iPred].idxPredicate)
       {
-         ++count.deletedPred;
+         vGroupOf[iPred] = SIZE_MAX;
+         ++count.addedPred;
+         continue;
       }
-      else
+
+      vGroupOf[iPred] = it - index_.vPredicates.begin();
+      ++vBegins[vGroupOf[iPred] + 1];
+   }
+
+   for (size_t iGroup = 0; iGroup < countGroups; ++iGroup)
+      vBegins[iGroup + 1] += vBegins[iGroup];
+
+   vNext.assign(vBegins.begin(), vBegins.end());
+   vPositions.resize(verifiable_.size());
+   for (size_t iPred = 0; iPred < verifiable_.size(); ++iPred)
+      if (vGroupOf[iPred] != SIZE_MAX)
+         vPositions[vNext[vGroupOf[iPred]]++] = iPred;
+
+   for (size_t iGroup = 0; iGroup < countGroups; ++iGroup)
+   {
+      const size_t* pSample = index_.vPositions.data() + index_.vBegins[iGroup];
+      const size_t countSample = index_.vBegins[iGroup + 1] - index_.vBegins[iGroup];
+      const size_t* pVerifiable = vPositions.data() + vBegins[iGroup];
+      const size_t countVerifiable = vBegins[iGroup + 1] - vBegins[iGroup];
+
+      const size_t countMatch = std::min(countSample, countVerifiable);
+      count.matchPred += countMatch;
+      count.deletedPred += countSample - countMatch;
+      count.addedPred += countVerifiable - countMatch;
+      if (countMatch == 0)
+         continue;
+
+      const size_t countArgs = sample_[pSample[0]].arguments.size();
+      if (countArgs == 0)
+         throw CException("Предикат с 0 аргументов недопустим.", "Ошибка при сопоставлении предикатов", "CGeneticAlgorithm::quantitativeAssessment");
+
+      count.totalArg += countMatch * countArgs;
+
+      // Строки матрицы отличий - меньшая из групп.
+      const bool bSampleRows = countSample <= countVerifiable;
+      const size_t countRows = bSampleRows ? countSample : countVerifiable;
+      const size_t countColumns = bSampleRows ? countVerifiable : countSample;
+
+      vCost.resize(countRows * countColumns);
+      for (size_t iSample = 0; iSample < countSample; ++iSample)
       {
-         bool bFoundPair = false;
-         for (const auto& candidate : mapIdentical)
+         const std::vector<int>& sampleArgs = sample_[pSample[iSample]].arguments;
+         for (size_t iVerifiable = 0; iVerifiable < countVerifiable; ++iVerifiable)
          {
-            const size_t idxPredTempl = candidate.second;
-            if (!vUsedPredInst.at(idxPredTempl))
-            {
-               vUsedPredInst.at(idxPredTempl) = true;
-               count.diffArg += candidate.first;
-               count.totalArg += verifiable_.at(idxPredTempl).arguments.size();
-               bFoundPair = true;
-               break;
-            }
-         }
+            const std::vector<int>& verArgs = verifiable_[pVerifiable[iVerifiable]].arguments;
+            if (verArgs.size() != countArgs)
+               throw CException("Разное количество аргументов одинаковых предикатов. Обратитесь к разработчику.", "Ошибка при сопоставлении предикатов", "CGeneticAlgorithm::quantitativeAssessment");
 
-         if (bFoundPair)
-            ++count.matchPred;
-         else
-            ++count.deletedPred;
+            int counter = 0;
+            for (size_t i = 0; i < countArgs; ++i)
+               if (sampleArgs[i] != verArgs[i])
+                  ++counter;
+
+            vCost[bSampleRows ? iSample * countColumns + iVerifiable : iVerifiable * countColumns + iSample] = counter;
+         }
       }
-   }
 
-   for (bool used : vUsedPredInst)
-   {
-      if (!used)
-         ++count.addedPred;
+      count.diffArg += MinCostAssignment(vCost.data(), countRows, countColumns);
    }
 
    return count;
@@ -1007,7 +2846,8 @@ size_t CGeneticAlgorithm::SelectRandParent(size_t countIndividuals_) const
    while (first == second)
       second = m_rand.Generate();
 
-   return m_generation[first].second < m_generation[second].second ? second : first;
+   auto fitness = [this](qint64 idx_) { return m_scriptGeneration.empty() ? m_generation[idx_].second : m_scriptGeneration[idx_].second; };
+   return fitness(first) < fitness(second) ? second : first;
 }
 
 std::pair<size_t, size_t> CGeneticAlgorithm::GetPairParents(size_t countIndividuals_) const
@@ -1030,17 +2870,208 @@ void CGeneticAlgorithm::SortGenerationDescendingOrder(TGeneration& generation_)
       });
 }
 
-QString CGeneticAlgorithm::highlightBlock(const QString& str_, qsizetype& index_)
+void CGeneticAlgorithm::SortGenerationDescendingOrder(TScriptGeneration& generation_) const
 {
-   qsizetype start = index_;
+   std::sort(generation_.begin(), generation_.end(),
+      [](const TScriptIndividual& a, const TScriptIndividual& b)
+      {
+         return a.second > b.second;
+      });
+}
 
-   for (; index_ < str_.size(); ++index_)
+bool CGeneticAlgorithm::isStopRequested() const
+{
+   // Строки для окна просмотра могут проверять условия в другом потоке во время запуска, их не прерываем.
+   if (m_runThread.load(std::memory_order_relaxed) != std::this_thread::get_id())
+      return false;
+
+   if (m_bStopRequested.load(std::memory_order_relaxed) || m_deadline.hasExpired())
+      return true;
+
+   // Запуск портфеля останавливается вместе с портфелем.
+   return m_parent && (m_parent->m_bStopRequested.load(std::memory_order_relaxed) || m_parent->m_deadline.hasExpired());
+}
+
+void CGeneticAlgorithm::publishSnapshot(size_t generation_, bool bFinal_)
+{
+   // Во время запуска с геномом из правок поколение - m_scriptGeneration, в снимок особи материализуются.
+   const bool bScripts = !m_scriptGeneration.empty();
+   const size_t countIndividuals = bScripts ? m_scriptGeneration.size() : m_generation.size();
+   auto fitness = [this, bScripts](size_t idx_) { return bScripts ? m_scriptGeneration[idx_].second : m_generation[idx_].second; };
+
+   auto snapshot = std::make_shared<SGenerationSnapshot>();
+   snapshot->generation = generation_;
+   snapshot->countIndividuals = countIndividuals;
+   snapshot->bFinal = bFinal_;
+
+   if (bFinal_ && !bScripts)
    {
-      if (str_.at(index_) == '$')
-         break;
+      // После запуска поколение уже отсортировано.
+      snapshot->best.assign(m_generation.begin(), m_generation.end());
    }
+   else
+   {
+      // Копируются только лучшие особи, поколение не сортируется.
+      const size_t count = bFinal_ ? countIndividuals : qMin(m_snapshotCount, countIndividuals);
+      std::vector<size_t> vIdx(countIndividuals);
+      std::iota(vIdx.begin(), vIdx.end(), 0);
+      std::partial_sort(vIdx.begin(), vIdx.begin() + count, vIdx.end(), [&fitness](size_t a, size_t b)
+         {
+            return fitness(a) > fitness(b) || (fitness(a) == fitness(b) && a < b);
+         });
 
-   return str_.mid(start, index_ - start);
+      snapshot->best.reserve(count);
+      for (size_t i = 0; i < count; ++i)
+         snapshot->best.push_back(bScripts ? materializeIndividual(m_scriptGeneration[vIdx[i]]) : m_generation[vIdx[i]]);
+   }
+
+   m_snapshot.store(std::move(snapshot));
+   Q_EMIT signalSnapshotUpdated();
+}
+
+void CGeneticAlgorithm::updatePortfolioSnapshot(std::shared_ptr<const SGenerationSnapshot> snapshot_)
+{
+   if (!snapshot_ || snapshot_->best.empty())
+      return;
+
+   {
+      std::lock_guard<std::mutex> lock(m_mutexPortfolio);
+      const std::shared_ptr<const SGenerationSnapshot> current = m_snapshot.load();
+      if (current && !current->best.empty() && current->best.front().second >= snapshot_->best.front().second)
+         return;
+
+      m_snapshot.store(std::move(snapshot_));
+   }
+
+   Q_EMIT signalSnapshotUpdated();
+}
+
+bool CGeneticAlgorithm::isTrueConditionCached(const SCondition& cond_) const
+{
+   if (!m_evaluationCache)
+   {
+      if (!m_mapBatchResults.empty())
+      {
+         auto it = m_mapBatchResults.find(CEvaluationCache::Key(cond_));
+         if (it != m_mapBatchResults.end())
+            return it->second;
+      }
+
+      return IsTrueCondition(cond_);
+   }
+
+   CEvaluationCache::TKey key = CEvaluationCache::Key(cond_);
+   bool bTrue = false;
+   if (m_evaluationCache->Find(key, bTrue))
+      return bTrue;
+
+   bTrue = IsTrueCondition(cond_);
+   m_evaluationCache->Insert(std::move(key), bTrue);
+   return bTrue;
+}
+
+void CGeneticAlgorithm::evaluateBatches(const TGeneration& generation_)
+{
+   m_mapBatchResults.clear();
+   CBatchEvaluator evaluator(*m_storage);
+
+   // Новые условия по количеству переменных шаблона (повторы и условия из кэша пропускаются).
+   std::map<int, std::vector<const SCondition*>> mapConditions;
+   std::unordered_set<CEvaluationCache::TKey, CEvaluationCache::SKeyHash> keys;
+   for (const auto& [individual, fitness] : generation_)
+      for (const SCondition& cond : individual)
+      {
+         if (!IsCorrectCondition(cond) || !evaluator.IsSupported(cond))
+            continue;
+
+         CEvaluationCache::TKey key = CEvaluationCache::Key(cond);
+         if ((!m_evaluationCache || !m_evaluationCache->Contains(key)) && keys.insert(std::move(key)).second)
+            mapConditions[cond.maxArgument].push_back(&cond);
+      }
+
+   auto checkStop = [this]()
+      {
+         if (isStopRequested())
+            throw SStopRequest();
+      };
+
+   try
+   {
+      for (const auto& [maxArgument, vConditions] : mapConditions)
+      {
+         CTraceScope trace(m_trace.get(), "EvaluatePrefixes");
+         trace.Arg("variables", maxArgument + 1).Arg("conditions", static_cast<qint64>(vConditions.size()));
+
+         SEvaluationCounts counts;
+         const std::vector<bool> vTrue = evaluator.EvaluatePrefixes(vConditions, counts, checkStop);
+         m_evaluationCounters.Add(static_cast<size_t>(maxArgument + 1), counts);
+
+         for (size_t iCond = 0; iCond < vConditions.size(); ++iCond)
+         {
+            if (m_evaluationCache)
+               m_evaluationCache->Insert(CEvaluationCache::Key(*vConditions[iCond]), vTrue[iCond]);
+            else
+               m_mapBatchResults.emplace(CEvaluationCache::Key(*vConditions[iCond]), vTrue[iCond]);
+         }
+      }
+   }
+   catch (const CException&)
+   {
+      throw;
+   }
+   catch (const std::exception& error)
+   {
+      throw CException(error.what(), "Ошибка проверки условия", "CGeneticAlgorithm::evaluateBatches");
+   }
+}
+
+void CGeneticAlgorithm::fillGenerationStats(SGenerationStats& stats_) const
+{
+   const bool bScripts = !m_scriptGeneration.empty();
+   const size_t countIndividuals = bScripts ? m_scriptGeneration.size() : m_generation.size();
+   if (countIndividuals == 0)
+      return;
+
+   // Разнообразие - доля различных особей. Особи сравниваются по хешу предикатов и аргументов
+   // (с геномом из правок - по хешу ключей правок).
+   std::unordered_set<size_t> hashes;
+   hashes.reserve(countIndividuals);
+
+   double sumFitness = 0;
+   stats_.bestFitness = stats_.worstFitness = bScripts ? m_scriptGeneration.front().second : m_generation.front().second;
+
+   auto addFitness = [&sumFitness, &stats_](double fitness_)
+      {
+         sumFitness += fitness_;
+         stats_.bestFitness = qMax(stats_.bestFitness, fitness_);
+         stats_.worstFitness = qMin(stats_.worstFitness, fitness_);
+      };
+
+   for (const auto& [individual, fitness] : m_generation)
+   {
+      addFitness(fitness);
+
+      size_t hash = individual.size();
+      for (const auto& cond : individual)
+         hash = hashPartCondition(hashPartCondition(hash, cond.left), cond.right);
+
+      hashes.insert(hash);
+   }
+
+   for (const auto& [individual, fitness] : m_scriptGeneration)
+   {
+      addFitness(fitness);
+
+      size_t hash = individual.size();
+      for (const auto& script : individual)
+         for (int value : script.Key())
+            hash = hash * 31 + static_cast<size_t>(value);
+
+      hashes.insert(hash);
+   }
+
+   stats_.meanFitness = sumFitness / countIndividuals;
+   stats_.diversity = static_cast<double>(hashes.size()) / countIndividuals;
 }
 
 QString CGeneticAlgorithm::highlightName(const QString& str_, qsizetype& index_)
@@ -1,21 +1,39 @@
 #pragma once
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <tuple>
+#include <unordered_map>
+#include <map>
 
+#include <QDeadlineTimer>
 #include <QObject>
 #include <QString>
 
 #include "random.h"
 #include "predicate.h"
 #include "parser_template_predicates.h"
+#include "generation_stats.h"
+#include "generation_snapshot.h"
+#include "evaluation_cache.h"
+#include "run_settings.h"
+#include "edit_script.h"
+#include "trace.h"
 
 class QTextStream;
 class CException;
+class CTextReader;
 
 class CGeneticAlgorithm : public QObject
 {
    Q_OBJECT
 
+   // Замеры производительности закрытых методов (Masters_thesis_2_benchmark).
+   friend class CBenchmark;
+
    // ================================ С т р у к т у р ы ================================
 
    // Для фитнес функции - количества.
@@ -32,21 +50,39 @@ class CGeneticAlgorithm : public QObject
       SCounts& operator+=(const SCounts& added_);
    };
 
+   // Часть изначального условия, разбитая на группы одинаковых предикатов (для quantitativeAssessment).
+   struct SPartIndex
+   {
+      std::vector<size_t> vPredicates; // индексы предикатов групп (по возрастанию)
+      std::vector<size_t> vBegins;     // начала групп в vPositions (последний элемент - конец)
+      std::vector<size_t> vPositions;  // номера предикатов части по группам
+   };
+
    using TIntegrityLimitation = std::vector<SCondition>; // Ограничение целостности (вектор условий).
    using TIntLimAndFitness = std::pair<TIntegrityLimitation, double>; // Ограничение целостности и фитнес.
    using TGeneration = std::vector<TIntLimAndFitness>; // Поколение - вектор ограничений с фитнесом.
+   using TScriptIndividual = std::pair<std::vector<CEditScript>, double>; // Ограничение в виде правок изначального и фитнес.
+   using TScriptGeneration = std::vector<TScriptIndividual>; // Поколение в виде правок.
 
    // =============================== П е р е м е н н ы е ===============================
 
    // Предикаты (там же хранятся и переменные).
-   CPredicatesStorage m_storage;
+   // Не меняется после загрузки, поэтому общее для запусков портфеля.
+   std::shared_ptr<CPredicatesStorage> m_storage;
 
    // Изначальное ограничение целостности (для финтес ф-ции). 
    TIntegrityLimitation m_original;
+   std::vector<std::array<SPartIndex, 2>> m_vOriginalIndex; // части изначальных условий по группам
+   std::vector<CEditScript::TBase> m_vOriginalBase; // описания изначальных условий (для фитнеса по правкам)
 
    // Одно поколение (состоящее из множества особей/индивидуумов).
    TGeneration m_generation;
 
+   // Геном - правки изначального ограничения (SetScriptGenome). Во время запуска поколение хранится
+   // в m_scriptGeneration, m_generation материализуется из него в конце запуска.
+   bool m_bScriptGenome = false;
+   TScriptGeneration m_scriptGeneration;
+
    mutable CRandom m_rand;
 
    // Нижняя граница для измененных аргументов в предикате.
@@ -56,12 +92,80 @@ class CGeneticAlgorithm : public QObject
    // Цена добавления предиката [0; 1].
    double m_costAddingPredicate = 0.5;
 
+   // Файл для статистики поколений (пустой - не записывать).
+   QString m_statsFile;
+
+   // Счетчики проверки условий (IsTrueCondition) с начала последнего запуска.
+   mutable CEvaluationCounters m_evaluationCounters;
+
+   // Файл трассировки (пустой - трассировка выключена).
+   QString m_traceFile;
+
+   // Трассировка текущего запуска (nullptr - выключена).
+   std::unique_ptr<CTrace> m_trace;
+
+   // Ограничение времени работы Start (мс), 0 - без ограничения.
+   qint64 m_timeBudget = 0;
+
+   // Запрос остановки (выставляется из любого потока).
+   std::atomic<bool> m_bStopRequested = false;
+
+   // Поток, в котором идет запуск (пустой - запуска нет).
+   // Запрос остановки и m_deadline проверяются только в этом потоке.
+   std::atomic<std::thread::id> m_runThread;
+
+   // Время окончания текущего запуска.
+   QDeadlineTimer m_deadline;
+
+   // Был ли последний запуск остановлен до выполнения всех итераций.
+   bool m_bInterrupted = false;
+
+   // Количество вычислений фитнеса особей за последний запуск.
+   quint64 m_countFitnessEvaluations = 0;
+
+   // Количество лучших особей в снимке, публикуемом во время запуска.
+   size_t m_snapshotCount = 100;
+
+   // Наименьший интервал между снимками во время запуска (мс).
+   qint64 m_snapshotInterval = 250;
+
+   // Локальный поиск: количество лучших особей, улучшаемых после каждого поколения (0 - выключен),
+   // и наибольшее количество проверяемых соседей одной особи.
+   size_t m_localSearchCount = 0;
+   size_t m_localSearchNeighbors = 200;
+
+   // Создание первого поколения (импорт, копии изначального ограничения с правками, случайные особи).
+   SInitialization m_initialization;
+
+   // Последний опубликованный снимок поколения (nullptr - запусков не было).
+   std::atomic<std::shared_ptr<const SGenerationSnapshot>> m_snapshot;
+
+   // Кэш истинности условий для текущих данных (nullptr - не используется).
+   std::shared_ptr<CEvaluationCache> m_evaluationCache;
+
+   // Истинность условий детей текущего поколения, проверенных evaluateBatches без кэша
+   // (очищается после оценки поколения).
+   std::unordered_map<CEvaluationCache::TKey, bool, CEvaluationCache::SKeyHash> m_mapBatchResults;
+
+   // Итоги запусков последнего портфеля и номер запуска, давшего результат (SIZE_MAX - портфеля не было).
+   std::vector<SPortfolioRun> m_vPortfolioRuns;
+   size_t m_idxBestPortfolioRun = SIZE_MAX;
+
+   // Итоги точного поиска по условиям (пусто - точного поиска не было).
+   std::vector<SExactRepair> m_vExactRepairs;
+
+   // Портфель, которому принадлежит запуск (его запрос остановки и время окончания действуют и на запуск).
+   const CGeneticAlgorithm* m_parent = nullptr;
+
+   // Выбор лучшего снимка среди запусков портфеля.
+   std::mutex m_mutexPortfolio;
+
 public:
    // ========================== О т к р ы т ы е   м е т о д ы ==========================
    CGeneticAlgorithm();
    ~CGeneticAlgorithm() = default;
 
-   // Получает данные из файла.
+   // Получает данные из файла (текстового или двоичного, формат определяется по сигнатуре).
    // !> emit signal error.
    void FillDataInFile(const QString& fileName_);
 
@@ -89,7 +193,8 @@ public:
    // countIndividuals_ - Количество первых особей.
    QString StringCustom(bool bVariables_ = true, bool bPredicates_ = true, bool bIntegrityLimitation_ = true, bool bGeneration_ = true, bool bFitness_ = true, bool bTrueCondition_ = false, size_t countIndividuals_ = SIZE_MAX) const;
 
-   // Запись в файл.
+   // Запись в файл (потоковая, см. CResultWriter). Формат по расширению: ".jsonl" - JSON lines,
+   // ".bin" - двоичный, иначе текст как у StringCustom.
    // fileName_ - имя файла.
    // bVariables_ - Записать переменные.
    // bPredicates_ - Записать предикаты и их таблицы истинности.
@@ -102,6 +207,8 @@ public:
    void WriteInFile(const QString& fileName_, bool bVariables_ = true, bool bPredicates_ = true, bool bIntegrityLimitation_ = true, bool bGeneration_ = true, bool bFitness_ = true, bool bTrueCondition_ = false, size_t countIndividuals_ = SIZE_MAX) const;
 
    // Запустить алгоритм с заданием параметров.
+   // Запуск можно прервать RequestStop или ограничением времени (SetTimeBudget). Тогда результатом
+   // остается последнее полностью вычисленное поколение, а сигнал signalEnd отправляется как обычно.
    // countIndividuals_ - количество особей
    // countIterations_ - количество итераций
    // percentMutationArguments_ - процент мутаций аргументов в предикате в одном условии
@@ -115,6 +222,126 @@ public:
 
    bool HasGenerations() const;
 
+   // Возвращает значение фитнес функции лучшей особи поколения.
+   // Если поколений нет - вернет 0.
+   double BestFitness() const;
+
+   // Устанавливает зерно генератора случайных чисел (для воспроизводимости запуска).
+   void SetSeed(quint32 seed_);
+
+   // Возвращает текущее зерно генератора случайных чисел.
+   quint32 GetSeed() const;
+
+   // Задает файл для статистики поколений, записываемой во время Start (".jsonl" - JSON lines, иначе CSV).
+   // Пустое имя - не записывать. Сигнал signalGenerationStats отправляется всегда.
+   void SetStatsFile(const QString& fileName_);
+
+   // Задает файл трассировки запуска в формате Chrome trace_event (открывается в Perfetto).
+   // Пустое имя - трассировка выключена.
+   void SetTraceFile(const QString& fileName_);
+
+   // Возвращает счетчики проверки условий с начала последнего запуска (Start).
+   SEvaluationStats EvaluationStats() const;
+
+   // Возвращает количество вычислений фитнеса особей за последний запуск (для портфеля - сумма по запускам).
+   quint64 CountFitnessEvaluations() const;
+
+   // Устанавливает ограничение времени работы Start (мс), 0 - без ограничения.
+   void SetTimeBudget(qint64 msec_);
+
+   // Просит остановить текущий запуск. Можно вызывать из любого потока.
+   // Остановка происходит между поколениями или при проверке условия.
+   void RequestStop();
+
+   // Возвращает true, если последний запуск был остановлен (запросом или по времени).
+   bool WasInterrupted() const;
+
+   // Возвращает true, если идет запуск.
+   bool IsRunning() const;
+
+   // Задает снимки, публикуемые во время запуска: countBest_ лучших особей не чаще чем раз в interval_ мс.
+   // После окончания запуска публикуется снимок со всем поколением.
+   void SetSnapshotSettings(size_t countBest_, qint64 interval_);
+
+   // Задает локальный поиск (меметический алгоритм): после селекции каждого поколения countBest_ лучших особей
+   // улучшаются подъемом по соседним особям, не более countNeighbors_ соседей на особь. 0 - без локального поиска.
+   // Сосед отличается одним изменением в одном условии: аргумент заменен другим или '~', предикат удален
+   // или добавлен предикат изначального условия. Пересчитывается только измененное условие.
+   void SetLocalSearch(size_t countBest_, size_t countNeighbors_ = 200);
+
+   // Задает создание первого поколения Start (см. SInitialization). Файл импорта читается при каждом запуске.
+   // !> emit signal error при некорректных значениях.
+   void SetInitialization(const SInitialization& initialization_);
+
+   // Задает геном особей Start: false - условия целиком, true - правки изначального ограничения (CEditScript).
+   // Особь из правок занимает несколько байт на правку; скрещивание и мутации работают с правками, структурная
+   // часть фитнеса считается по правкам, условия материализуются только для проверки истинности, снимков
+   // и результата. Особи первого поколения переводятся в правки (CEditScript::FromCondition).
+   void SetScriptGenome(bool bScriptGenome_);
+
+   // Возвращает последний опубликованный снимок поколения (nullptr - запусков не было).
+   // Можно вызывать из любого потока, снимок не меняется.
+   std::shared_ptr<const SGenerationSnapshot> Snapshot() const;
+
+   // Выполняет независимые запуски с настройками vSettings_ параллельно (countThreads_ - количество потоков,
+   // 0 - по количеству ядер). Запуски используют общие данные и общий кэш истинности условий
+   // (создается, если не задан SetEvaluationCache), поэтому данные и кэш не копируются.
+   // Цены изменения аргументов и добавления предиката берутся из настроек запуска.
+   // Результат - последнее поколение запуска с лучшей особью, итоги всех запусков - PortfolioRuns.
+   // RequestStop и ограничение времени (SetTimeBudget) действуют на весь портфель.
+   // Файлы статистики и трассировки в портфеле не пишутся.
+   // !> emit signal error, если ни один запуск не завершился успешно.
+   void StartPortfolio(const std::vector<SRunSettings>& vSettings_, int countThreads_ = 0);
+
+   // Возвращает итоги запусков последнего портфеля (пусто - после Start или загрузки данных).
+   const std::vector<SPortfolioRun>& PortfolioRuns() const;
+
+   // Возвращает номер запуска портфеля, поколение которого стало результатом (SIZE_MAX - нет).
+   size_t BestPortfolioRun() const;
+
+   // Точный поиск исправления: для каждого условия изначального ограничения перебираются все условия,
+   // получаемые не более чем maxEdits_ правками (замена аргумента, добавление или удаление предиката),
+   // и выбирается условие с наибольшим фитнесом. Фитнес особи - сумма фитнесов условий, поэтому лучшие
+   // условия дают лучшую особь. Кандидаты проверяются на истинность в порядке убывания фитнеса без учета
+   // истинности (верхней границы), перебор прекращается, когда граница не больше найденного фитнеса.
+   // maxCandidates_ - наибольшее количество кандидатов одного условия (больше - результат не доказан).
+   // Условия обрабатываются параллельно (countThreads_, 0 - по количеству ядер).
+   // Результат - поколение из одной лучшей особи, итоги по условиям - ExactRepairs.
+   // RequestStop и ограничение времени прекращают перебор, результат - лучшее найденное.
+   // !> emit signal error при ошибке.
+   void StartExact(int maxEdits_, size_t maxCandidates_ = 200000, int countThreads_ = 0);
+
+   // Возвращает итоги последнего точного поиска по условиям (пусто - точного поиска не было).
+   const std::vector<SExactRepair>& ExactRepairs() const;
+
+   // Поиск исправления лучом: начиная с изначального ограничения, на каждом шаге (глубине) все еще
+   // не раскрытые особи луча раскрываются одной правкой одного условия (как в StartExact), и из луча
+   // и новых особей остаются beamWidth_ лучших различных. Поиск детерминирован, заканчивается через
+   // maxDepth_ шагов или раньше, если в луч не попала ни одна новая особь.
+   // Фитнес особи считается по фитнесам условий, пересчитывается только измененное условие.
+   // Кандидаты шага оцениваются параллельно (countThreads_, 0 - по количеству ядер).
+   // Сигналы, статистика (шаг - поколение) и результат (луч) - как у Start.
+   // !> emit signal error при ошибке.
+   void StartBeam(int beamWidth_, int maxDepth_, int countThreads_ = 0);
+
+   // Задает кэш истинности условий для текущих данных (nullptr - без кэша).
+   // Сбрасывается при загрузке новых данных.
+   void SetEvaluationCache(std::shared_ptr<CEvaluationCache> cache_);
+
+   std::shared_ptr<CEvaluationCache> EvaluationCache() const;
+
+   // Возвращает хранилище предикатов и переменных (не меняется во время запуска).
+   const CPredicatesStorage& GetStorage() const;
+
+   // Возвращает изначальное ограничение целостности.
+   const TIntegrityLimitation& GetOriginal() const;
+
+   // Записывает условие в строку.
+   QString StringCondition(const SCondition& condition_) const;
+
+   // Возвращает истинность условия.
+   bool IsTrueCondition(const SCondition& cond_) const;
+
    // Устанавливает цену нижней границы для измененных аргументов.
    // Допустимые значения в интевале (0; 1).
    // !> emit signal error.
@@ -130,6 +357,8 @@ public:
 signals:
    // ================================== С и г н а л ы ==================================
    void signalProgressUpdate(int value_) const;
+   void signalGenerationStats(const SGenerationStats& stats_) const;
+   void signalSnapshotUpdated() const;
    void signalEnd() const;
    void signalError(const CException& error_) const;
 
@@ -137,39 +366,56 @@ signals:
 private:
    //  ========================= З а к р ы т ы е   м е т о д ы ==========================
 
-   // Считывает и заносит условия из строки.
-   void SetConditionsFromString(const QString& str_);
-
-   // Записывает условие в строку.
-   QString StringCondition(const SCondition& condition_) const;
+   // Считывает и заносит условия из текущего раздела reader_.
+   void SetConditions(CTextReader& reader_);
 
    // Записывает ограничение целостности в строку.
    QString StringIntegrityLimitation(const TIntegrityLimitation& integrityLimitation_, bool bInsertNewLine_ = false, bool bTrueCondition_ = false) const;
 
-   // Сгенерировать первое поколение рандомно.
-   void CreateFirstGenerationRandom(size_t count_);
+   // Создает первое поколение из count_ особей по m_initialization.
+   // !> exception при некорректных данных или ошибке импорта.
+   void CreateFirstGeneration(size_t count_);
+
+   // Добавляет в generation_ count_ случайных особей (фитнес не считается).
+   void CreateFirstGenerationRandom(size_t count_, TGeneration& generation_);
+
+   // Возвращает копию изначального ограничения, в каждом условии которой сделано
+   // от m_initialization.minEdits до m_initialization.maxEdits случайных правок (randomEdit).
+   TIntegrityLimitation seededIndividual() const;
+
+   // Делает в условии cond_ одну случайную правку: заменяет аргумент, удаляет предикат (часть не остается пустой)
+   // или добавляет случайный предикат.
+   void randomEdit(SCondition& cond_) const;
 
    // Скрещивание только по предикатам.
+   // Часть условия потомка не остается пустой: берется случайный предикат той же части другого родителя,
+   // если и она пуста - изначального условия (repairCondition).
    TIntegrityLimitation CrossingOnlyPredicates(const TIntegrityLimitation& parent1_, const TIntegrityLimitation& parent2_) const;
 
    // Селекция. Выбираются лучшие (по фитнесс функции) CountSurvivors_ особей из individuals_, т.е. полная замена, родителей "убиваем".
    void Selection(TGeneration&& individuals_, size_t countSurvivors_);
 
+   // То же для особей в виде правок (в m_scriptGeneration).
+   void Selection(TScriptGeneration&& individuals_, size_t countSurvivors_);
+
    // Мутация аргументов в предикате.
+   // Аргумент не заменяется на '~', если остальные аргументы предиката - '~'.
    void MutationArguments(TIntegrityLimitation& individual_, double ratio_) const;
 
    // Мутация предикатов.
+   // У нового предиката хотя бы один аргумент - переменная.
    void MutationPredicates(TIntegrityLimitation& individual_, double ratio_) const;
 
+   // Делает условие cond_ на месте iCond_ корректным (IsCorrectCondition): в пустую часть добавляется случайный
+   // предикат той же части изначального условия, у предиката только с '~' один аргумент становится переменной.
+   void repairCondition(SCondition& cond_, size_t iCond_) const;
+
    // Возвращает количество всех предикатов во всем ограничении.
    size_t CountAllPredicates(const TIntegrityLimitation& individual_) const;
 
    // Возвращает корректность условия (обе части должны быть не пусты).
    bool IsCorrectCondition(const SCondition& cond_) const;
 
-   // Возвращает истинность условия.
-   bool IsTrueCondition(const SCondition& cond_) const;
-
    // Возвращает индекс родителя из поколения. Турнирная функция выбора.
    size_t SelectRandParent(size_t countIndividuals_) const;
 
@@ -179,6 +425,27 @@ private:
 
    // Сортирует поколение в порядке убывания фитнес функции.
    void SortGenerationDescendingOrder(TGeneration& generation_) const;
+   void SortGenerationDescendingOrder(TScriptGeneration& generation_) const;
+
+   // Возвращает true, если текущий запуск надо остановить (запрос остановки или истекло время).
+   bool isStopRequested() const;
+
+   // Публикует снимок текущего поколения: m_snapshotCount лучших особей, если bFinal_ - все поколение.
+   void publishSnapshot(size_t generation_, bool bFinal_);
+
+   // Заменяет снимок портфеля снимком запуска snapshot_, если в нем особь лучше.
+   void updatePortfolioSnapshot(std::shared_ptr<const SGenerationSnapshot> snapshot_);
+
+   // Возвращает истинность условия, используя кэш (если задан).
+   bool isTrueConditionCached(const SCondition& cond_) const;
+
+   // Проверяет истинность корректных условий особей generation_, которых нет в кэше, блоками CBatchEvaluator
+   // (условия с одинаковым количеством переменных шаблона - по общему префиксному дереву левых частей)
+   // и добавляет в кэш, а без кэша - в m_mapBatchResults.
+   void evaluateBatches(const TGeneration& generation_);
+
+   // Заполняет в stats_ фитнес (лучший, средний, худший) и разнообразие текущего поколения.
+   void fillGenerationStats(SGenerationStats& stats_) const;
 
    // Фитнес функция.
    // Возвращает значение приспособленности (фитнеса) для ограничения целостности.
@@ -195,27 +462,109 @@ private:
    // dif аргуметнов поменялось из tot то P = нижняя_граница + ((tot-dif)/tot) * (1 - нижняя_граница).
    double FitnessFunction(const TIntegrityLimitation& conds_) const;
 
+   // Возвращает фитнес условия cond_ (FC) на месте iCond_ изначального ограничения.
+   double conditionFitness(size_t iCond_, const SCondition& cond_) const;
+
+   // Возвращает фитнес условия cond_ без проверки истинности (как для истинного условия).
+   // Это верхняя граница conditionFitness, для истинного условия значения совпадают.
+   double conditionFitnessBound(size_t iCond_, const SCondition& cond_) const;
+
+   // Возвращает фитнес истинного условия со счетчиками count_.
+   double fitnessBound(const SCounts& count_) const;
+
+   // Возвращает фитнес корректного условия со счетчиками count_ и истинностью bTrue_.
+   double countsFitness(const SCounts& count_, bool bTrue_) const;
+
+   // То же, что conditionFitnessBound для условия script_, полученного правками изначального условия iCond_
+   // (base_ - его описание). Счетчики берутся из правок, если они совпадают с quantitativeAssessment
+   // (предикаты изначальной части различны и добавленные предикаты не совпадают с ними по индексу),
+   // иначе условие материализуется.
+   double scriptFitnessBound(size_t iCond_, const CEditScript::TBase& base_, const CEditScript& script_) const;
+
+   // Подсчитывает по правкам script_ изначального условия original_ счетчики count_ и корректность условия
+   // за O(правок). Возвращает false, если счетчики по правкам могут не совпасть с quantitativeAssessment.
+   static bool scriptCounts(const SCondition& original_, const CEditScript::TBase& base_, const CEditScript& script_, SCounts& count_, bool& bCorrect_);
+
+   // Находит лучшее условие на месте iCond_ не более чем в maxEdits_ правках от изначального (для StartExact).
+   SExactRepair exactRepair(size_t iCond_, int maxEdits_, size_t maxCandidates_, SCondition& best_) const;
+
+   // Добавляет в vEdited_ условия, отличающиеся от cond_ одной правкой: аргумент заменен другим или '~',
+   // предикат удален (часть не остается пустой) или добавлен. Если задано изначальное условие pOriginal_,
+   // добавляются только его предикаты, которых в части нет, иначе - все предикаты со всеми аргументами.
+   void editConditions(const SCondition& cond_, const SCondition* pOriginal_, std::vector<SCondition>& vEdited_) const;
+
+   // Добавляет в vEdited_ правки, отличающиеся от script_ одной правкой (те же, что и editConditions без
+   // изначального условия для материализованного условия). iCond_ - номер изначального условия.
+   void editScripts(size_t iCond_, const CEditScript& script_, std::vector<CEditScript>& vEdited_) const;
+
+   // Вызывает callback_ для каждого предиката, который можно добавить в условие с максимальным аргументом
+   // maxArgument_: новые переменные нумеруются по порядку появления, предикат только с '~' не добавляется.
+   void forEachInsertion(int maxArgument_, const std::function<void(const SPredicateTemplate&)>& callback_) const;
+
+   // Возвращает фитнес особи по фитнесам ее условий (в том же порядке действий, что и FitnessFunction).
+   static double sumFitness(const std::vector<double>& vFitness_);
+
+   // Улучшает особь individual_ локальным поиском (первое найденное улучшение, пока оно есть).
+   // Возвращает количество вычисленных фитнесов условий.
+   size_t localSearch(TIntLimAndFitness& individual_) const;
+
+   // ------------------------------- Геном из правок ----------------------------------
+
+   // Возвращает поколение generation_ в виде правок изначального ограничения (фитнес сохраняется).
+   TScriptGeneration scriptGeneration(const TGeneration& generation_) const;
+
+   // Возвращает материализованную особь individual_.
+   TIntLimAndFitness materializeIndividual(const TScriptIndividual& individual_) const;
+
+   // Скрещивание правок. Каждый предикат изначального условия (удаленный или с заменами аргументов) берется
+   // от случайного родителя, добавленные предикаты - как в CrossingOnlyPredicates. Потомок исправляется repairScript.
+   std::vector<CEditScript> CrossingScripts(const std::vector<CEditScript>& parent1_, const std::vector<CEditScript>& parent2_) const;
+
+   // Мутация аргументов особи в виде правок (как MutationArguments).
+   void MutationScriptArguments(std::vector<CEditScript>& individual_, double ratio_) const;
+
+   // Мутация предикатов особи в виде правок (как MutationPredicates): предикат заменяется случайным,
+   // переменные шаблона перенумеровываются.
+   void MutationScriptPredicates(std::vector<CEditScript>& individual_, double ratio_) const;
+
+   // То же, что repairCondition, для условия в виде правок script_ изначального условия iCond_.
+   void repairScript(CEditScript& script_, size_t iCond_) const;
+
+   // Фитнес особи в виде правок scripts_ (conds_ - она же материализованная, для проверки истинности).
+   // Совпадает с FitnessFunction(conds_).
+   double scriptFitnessFunction(const std::vector<CEditScript>& scripts_, const TIntegrityLimitation& conds_) const;
+
+   // Фитнес условия script_ на месте iCond_: счетчики по правкам (scriptCounts), истинность - по cond_.
+   double scriptFitness(size_t iCond_, const CEditScript& script_, const SCondition& cond_) const;
+
+   // Локальный поиск для особи в виде правок: особь материализуется, улучшается localSearch и переводится в правки.
+   size_t localSearchScript(TScriptIndividual& individual_) const;
+
    // ----------------------- Вспомогательные функции для фитнеса -----------------------
 
-   // Возвращает индексы предикатов из условия, которые совпадают с sample_, и количество отличий в порядке возрастания отличий в аргументах.
-   // Возвращает multimap<число_отличий, индекс_предиката>.
-   std::multimap<int, size_t> findMinDifference(const SPredicateTemplate& sample_, const TPartCondition& verifiable_) const;
+   // Возвращает часть part_, разбитую на группы одинаковых предикатов.
+   static SPartIndex indexPart(const TPartCondition& part_);
+
+   // Заполняет m_vOriginalIndex по m_original.
+   void indexOriginal();
 
-   // Количественная оценка.
+   // Количественная оценка части verifiable_ относительно части sample_ изначального условия (index_ - ее группы).
+   // Предикаты сопоставляются внутри групп одинаковых предикатов так, чтобы сопоставленных было больше всего,
+   // а отличий в аргументах - меньше всего (задача о назначениях, MinCostAssignment).
    // Возвращает:
    // 1. Количество отличных аргументов у (всех) одинаковых предикат.
    // 2. Количество всего аргументов у этих предикат (всех).
    // 3. Количество совпадающих предикат.
    // 4. Количество добавленных предикат.
    // 5. Количество удаленных предикат.
-   SCounts quantitativeAssessment(const TPartCondition& sample_, const TPartCondition& verifiable_) const;
+   // !> exception при разном количестве аргументов одинаковых предикатов или предикате без аргументов.
+   SCounts quantitativeAssessment(const TPartCondition& sample_, const SPartIndex& index_, const TPartCondition& verifiable_) const;
 
    // Возвращает множитель аргументов.
    double getMultiplierArguments(size_t differences_, size_t total_) const;
 
    // --------------------------- Функции работы со строками ----------------------------
 
-   static QString highlightBlock(const QString& str_, qsizetype& index_);
    static QString highlightName(const QString& str_, qsizetype& index_);
    static bool hasSymbol(const QString str_, qsizetype& index_, QChar symbol_);
 };
\ No newline at end of file
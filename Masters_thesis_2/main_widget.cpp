@@ -17,12 +17,14 @@ MainWidget::MainWidget(QWidget *parent) :
     connect(ui->pbLoad, &QPushButton::clicked, this, &MainWidget::onLoad);
     connect(ui->pbUpload, &QPushButton::clicked, this, &MainWidget::onUpload);
     connect(ui->pbStart, &QPushButton::clicked, this, &MainWidget::onStart);
+    connect(ui->pbStop, &QPushButton::clicked, this, &MainWidget::onStop);
     connect(ui->pbShowData, &QPushButton::clicked, this, &MainWidget::onShowData);
     connect(ui->cbSkipMutationsPredicates, &QCheckBox::checkStateChanged, this, &MainWidget::onCheckStateChanged);
     connect(ui->cbSkipMutationsArgumetns, &QCheckBox::checkStateChanged, this, &MainWidget::onCheckStateChanged);
     connect(ui->sbIterations, &QSpinBox::valueChanged, this, &MainWidget::onIterationsChanged);
 
     connect(&m_algorithm, &CGeneticAlgorithm::signalProgressUpdate, this, &MainWidget::onUpdateProgress);
+    connect(&m_algorithm, &CGeneticAlgorithm::signalSnapshotUpdated, this, &MainWidget::onSnapshotUpdated);
     connect(&m_algorithm, &CGeneticAlgorithm::signalError, this, &MainWidget::onShowError);
     connect(&m_algorithm, &CGeneticAlgorithm::signalEnd, this, &MainWidget::onEndingCalc);
 }
@@ -34,20 +36,20 @@ MainWidget::~MainWidget()
 
 void MainWidget::onLoad()
 {
-   QString path = QFileDialog::getOpenFileName(this, "Выберите файл для загрузки данных", "", "Текстовые файлы (*.txt)");
+   QString path = QFileDialog::getOpenFileName(this, "Выберите файл для загрузки данных", "", "Файлы данных (*.txt *.bin);;Все файлы (*)");
    if (!path.isEmpty())
    {
       QString strError;
       m_algorithm.FillDataInFile(path);
 
       if (m_dlgViewer)
-         m_dlgViewer->UpdateText();
+         m_dlgViewer->UpdateData();
    }
 }
 
 void MainWidget::onUpload()
 {
-   QString path = QFileDialog::getSaveFileName(this, "Сохранение результата", "", "Текстовые файлы (*.txt)");
+   QString path = QFileDialog::getSaveFileName(this, "Сохранение результата", "", "Текстовые файлы (*.txt);;JSON Lines (*.jsonl);;Двоичные файлы (*.bin)");
 
    if (!path.isEmpty())
    {
@@ -59,11 +61,16 @@ void MainWidget::onUpload()
 void MainWidget::onStart()
 {
    ui->pbStart->setEnabled(false);
+   ui->pbStop->setEnabled(true);
+   ui->pbLoad->setEnabled(false); // данные читаются окном просмотра во время работы
    ui->progressBar->setVisible(true);
    ui->progressBar->setValue(0);
+   ui->progressBar->setFormat("%p%");
 
    m_algorithm.SetCostAddingPredicate(ui->sbCostAdding->value());
    m_algorithm.SetLimitOfArgumentsChange(ui->sbCostArguments->value());
+   m_algorithm.SetTimeBudget(ui->sbTimeLimit->value() * 1000LL);
+   m_algorithm.SetLocalSearch(ui->sbLocalSearch->value());
 
    QThread* thread = new QThread();
    m_algorithm.moveToThread(thread);
@@ -89,6 +96,13 @@ void MainWidget::onStart()
    thread->start();
 }
 
+void MainWidget::onStop()
+{
+   // Алгоритм занят в своем потоке, поэтому запрос передается напрямую (RequestStop потокобезопасен).
+   ui->pbStop->setEnabled(false);
+   m_algorithm.RequestStop();
+}
+
 void MainWidget::onShowData()
 {
    if (!m_dlgViewer)
@@ -129,6 +143,13 @@ void MainWidget::onUpdateProgress(int progress_)
    ui->progressBar->setValue(progress_);
 }
 
+void MainWidget::onSnapshotUpdated()
+{
+   // Окно просмотра выводит снимок поколения, поэтому его можно обновлять во время работы алгоритма.
+   if (m_dlgViewer && m_dlgViewer->isVisible())
+      m_dlgViewer->UpdateGeneration();
+}
+
 void MainWidget::onShowError(const CException& messege_)
 {
    QMessageBox::critical(this, messege_.title(), messege_.what());
@@ -137,7 +158,12 @@ void MainWidget::onShowError(const CException& messege_)
 void MainWidget::onEndingCalc()
 {
    ui->pbStart->setEnabled(true);
+   ui->pbStop->setEnabled(false);
+   ui->pbLoad->setEnabled(true);
+
+   if (m_algorithm.WasInterrupted())
+      ui->progressBar->setFormat("Остановлено на %p%");
 
    if (m_dlgViewer)
-      m_dlgViewer->UpdateText();
+      m_dlgViewer->UpdateGeneration();
 }
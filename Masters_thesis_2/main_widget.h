@@ -22,11 +22,13 @@ private slots:
    void onLoad();
    void onUpload();
    void onStart();
+   void onStop();
    void onShowData();
    void onCheckStateChanged(int value_);
    void onIterationsChanged(int value_);
 
    void onUpdateProgress(int progress_);
+   void onSnapshotUpdated();
    void onShowError(const CException& messege_);
    void onEndingCalc();
 
@@ -0,0 +1,68 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <mutex>
+
+#include <QThread>
+#include <QThreadPool>
+
+// Выполняет task_(i) для всех i из [0; count_) на нескольких потоках.
+// Вызывающий поток тоже выполняет задачи, поэтому функцию можно вызывать из потока пула.
+// Порядок выполнения задач не определен.
+// Если задачи бросили исключения, то после завершения всех задач бросается исключение задачи с наименьшим индексом.
+// countThreads_ - максимальное количество потоков (0 - по количеству ядер).
+inline void ParallelFor(size_t count_, const std::function<void(size_t)>& task_, int countThreads_ = 0)
+{
+   if (count_ == 0)
+      return;
+
+   if (countThreads_ <= 0)
+      countThreads_ = QThread::idealThreadCount();
+
+   const size_t countHelpers = std::min(count_, static_cast<size_t>(qMax(countThreads_, 1))) - 1;
+
+   std::atomic<size_t> next = 0;
+   std::mutex mutexError;
+   size_t idxError = SIZE_MAX;
+   std::exception_ptr error;
+
+   auto worker = [&]()
+      {
+         for (size_t i = next++; i < count_; i = next++)
+         {
+            try
+            {
+               task_(i);
+            }
+            catch (...)
+            {
+               std::lock_guard<std::mutex> lock(mutexError);
+               if (i < idxError)
+               {
+                  idxError = i;
+                  error = std::current_exception();
+               }
+            }
+         }
+      };
+
+   if (countHelpers == 0)
+   {
+      worker();
+   }
+   else
+   {
+      QThreadPool pool;
+      pool.setMaxThreadCount(static_cast<int>(countHelpers));
+      for (size_t i = 0; i < countHelpers; ++i)
+         pool.start(worker);
+
+      worker();
+      pool.waitForDone();
+   }
+
+   if (error)
+      std::rethrow_exception(error);
+}
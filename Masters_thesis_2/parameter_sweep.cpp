@@ -0,0 +1,399 @@
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <numeric>
+
+#include <QElapsedTimer>
+#include <QStringList>
+
+#include "parameter_sweep.h"
+#include "genetic_algorithm.h"
+#include "exception.h"
+#include "random.h"
+
+static const char* TITLE_SWEEP = "Ошибка перебора параметров";
+
+// Наибольшее количество значений параметра и конфигураций сетки.
+static constexpr size_t MAX_COUNT_VALUES = 10000;
+static constexpr size_t MAX_COUNT_CONFIGURATIONS = 100000;
+
+// Описание параметра: имя и допустимые значения.
+struct SParameterInfo
+{
+   const char* name;
+   double min;
+   double max;
+   bool bInteger;
+};
+
+static const SParameterInfo PARAMETERS[eCountSweepParameters] = {
+   { "individuals", 2, INT_MAX, true },
+   { "mutation-arguments", 0, 100, false },
+   { "skip-mutation-arguments", 0, INT_MAX, true },
+   { "mutation-predicates", 0, 100, false },
+   { "skip-mutation-predicates", 0, INT_MAX, true },
+   { "mutation-individuals", 0, 100, false },
+   { "cost-arguments", 0.01, 0.99, false },
+   { "cost-adding", 0, 1, false },
+   { "local-search", 0, INT_MAX, true }
+};
+
+// Возвращает значение параметра info_ из строки str_ (item_ - описание параметра для сообщения).
+// !> exception при некорректном значении.
+static double parseValue(const QString& str_, const SParameterInfo& info_, const QString& item_)
+{
+   bool bOk = false;
+   const double value = str_.trimmed().toDouble(&bOk);
+   if (!bOk || value < info_.min || value > info_.max || (info_.bInteger && value != std::floor(value)))
+      throw CException(QString("Некорректное значение параметра \"%1\".").arg(item_), TITLE_SWEEP, "CParameterSweep::ParseSpace");
+
+   return value;
+}
+
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-= Методы класса =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+std::vector<SSweepRange> CParameterSweep::ParseSpace(const QString& spec_)
+{
+   std::vector<SSweepRange> vRanges;
+
+   for (const QString& item : spec_.split(';', Qt::SkipEmptyParts))
+   {
+      const qsizetype posEqual = item.indexOf(QChar('='));
+      const QString name = item.left(posEqual).trimmed();
+
+      const auto itInfo = std::find_if(std::begin(PARAMETERS), std::end(PARAMETERS),
+         [&name](const SParameterInfo& info_) { return name == info_.name; });
+
+      if (posEqual < 0 || itInfo == std::end(PARAMETERS))
+         throw CException(QString("Неизвестный параметр перебора \"%1\".").arg(item.trimmed()), TITLE_SWEEP, "CParameterSweep::ParseSpace");
+
+      SSweepRange range;
+      range.parameter = static_cast<ESweepParameter>(itInfo - std::begin(PARAMETERS));
+
+      if (std::any_of(vRanges.begin(), vRanges.end(), [&range](const SSweepRange& other_) { return other_.parameter == range.parameter; }))
+         throw CException(QString("Параметр перебора \"%1\" задан дважды.").arg(name), TITLE_SWEEP, "CParameterSweep::ParseSpace");
+
+      const QString values = item.mid(posEqual + 1);
+      const QStringList bounds = values.split(':');
+
+      if (bounds.size() == 1)
+      {
+         for (const QString& value : values.split(',', Qt::SkipEmptyParts))
+            range.vValues.push_back(parseValue(value, *itInfo, item));
+
+         if (range.vValues.empty())
+            throw CException(QString("Не заданы значения параметра \"%1\".").arg(item), TITLE_SWEEP, "CParameterSweep::ParseSpace");
+      }
+      else if (bounds.size() == 2 || bounds.size() == 3)
+      {
+         range.min = parseValue(bounds[0], *itInfo, item);
+         range.max = parseValue(bounds[1], *itInfo, item);
+         if (range.min > range.max)
+            throw CException(QString("Некорректный отрезок параметра \"%1\".").arg(item), TITLE_SWEEP, "CParameterSweep::ParseSpace");
+
+         if (bounds.size() == 3)
+         {
+            bool bOk = false;
+            const double step = bounds[2].trimmed().toDouble(&bOk);
+            if (!bOk || step <= 0 || (range.max - range.min) / step >= MAX_COUNT_VALUES)
+               throw CException(QString("Некорректный шаг параметра \"%1\".").arg(item), TITLE_SWEEP, "CParameterSweep::ParseSpace");
+
+            // Значения считаются от начала отрезка, чтобы не накапливалась ошибка округления.
+            for (size_t iValue = 0; range.min + iValue * step <= range.max + step * 1e-9; ++iValue)
+            {
+               const double value = std::min(range.min + iValue * step, range.max);
+               range.vValues.push_back(itInfo->bInteger ? std::round(value) : value);
+            }
+         }
+      }
+      else
+         throw CException(QString("Некорректное значение параметра \"%1\".").arg(item), TITLE_SWEEP, "CParameterSweep::ParseSpace");
+
+      vRanges.push_back(std::move(range));
+   }
+
+   return vRanges;
+}
+
+QString CParameterSweep::ParameterName(ESweepParameter parameter_)
+{
+   return parameter_ < eCountSweepParameters ? PARAMETERS[parameter_].name : "";
+}
+
+void CParameterSweep::Run(CGeneticAlgorithm& algorithm_, const SRunSettings& base_, const SSweepSettings& settings_)
+{
+   m_vRows.clear();
+   m_idxBestRow = SIZE_MAX;
+
+   if (settings_.countSeeds < 1 || settings_.countRungs < 1 || settings_.eta < 1 || settings_.countRandom < 0 || base_.countIterations < 1)
+      throw CException("Некорректные настройки перебора параметров.", TITLE_SWEEP, "CParameterSweep::Run");
+
+   const std::vector<SRunSettings> vConfigurations = configurations(base_, settings_);
+   const size_t countSeeds = static_cast<size_t>(settings_.countSeeds);
+   const int countRungs = settings_.eta > 1 ? settings_.countRungs : 1;
+
+   std::vector<size_t> vLive(vConfigurations.size());
+   std::iota(vLive.begin(), vLive.end(), 0);
+
+   for (int rung = 0; rung < countRungs; ++rung)
+   {
+      // Единственная оставшаяся конфигурация сразу получает полное количество итераций.
+      if (vLive.size() == 1)
+         rung = countRungs - 1;
+
+      const double share = std::pow(settings_.eta, countRungs - 1 - rung);
+
+      std::vector<SRunSettings> vSettings;
+      vSettings.reserve(vLive.size() * countSeeds);
+      for (size_t idxConfiguration : vLive)
+         for (size_t iSeed = 0; iSeed < countSeeds; ++iSeed)
+         {
+            SRunSettings settings = vConfigurations[idxConfiguration];
+            settings.seed = base_.seed + static_cast<quint32>(iSeed);
+            settings.countIterations = std::max(1, static_cast<int>(std::lround(base_.countIterations / share)));
+
+            // Итерации без мутаций сокращаются вместе с запуском, иначе на коротких ступенях мутаций бы не было.
+            settings.countSkipMutationArg = static_cast<int>(std::lround(settings.countSkipMutationArg / share));
+            settings.countSkipMutationPred = static_cast<int>(std::lround(settings.countSkipMutationPred / share));
+
+            vSettings.push_back(settings);
+         }
+
+      QElapsedTimer timer;
+      timer.start();
+      algorithm_.StartPortfolio(vSettings, settings_.countThreads);
+      const qint64 rungTime = timer.elapsed();
+
+      const std::vector<SPortfolioRun>& vRuns = algorithm_.PortfolioRuns();
+      if (vRuns.size() != vSettings.size() || algorithm_.BestPortfolioRun() == SIZE_MAX)
+      {
+         const auto itError = std::find_if(vRuns.begin(), vRuns.end(), [](const SPortfolioRun& run_) { return !run_.error.isEmpty(); });
+         throw CException(itError != vRuns.end() ? itError->error : QString("Ни один запуск ступени %1 не выполнен.").arg(rung + 1),
+            TITLE_SWEEP, "CParameterSweep::Run");
+      }
+
+      const size_t firstRow = m_vRows.size();
+      for (size_t iLive = 0; iLive < vLive.size(); ++iLive)
+      {
+         SSweepRow row;
+         row.configuration = vLive[iLive];
+         row.rung = rung;
+         row.settings = vSettings[iLive * countSeeds];
+         row.countSeeds = settings_.countSeeds;
+         row.rungTime = rungTime;
+
+         for (size_t iSeed = 0; iSeed < countSeeds; ++iSeed)
+         {
+            const SPortfolioRun& run = vRuns[iLive * countSeeds + iSeed];
+            row.countFitnessEvaluations += run.countFitnessEvaluations;
+            row.runTime += run.runTime;
+
+            if (row.error.isEmpty())
+               row.error = run.error;
+
+            // Фитнес запуска с ошибкой или без поколения не определен.
+            if (!run.error.isEmpty() || !run.bHasGeneration)
+               continue;
+
+            row.bestFitness = row.countCompleted == 0 ? run.bestFitness : std::max(row.bestFitness, run.bestFitness);
+            row.meanFitness += run.bestFitness;
+            ++row.countCompleted;
+         }
+
+         if (row.countCompleted > 0)
+            row.meanFitness /= row.countCompleted;
+
+         m_vRows.push_back(std::move(row));
+      }
+
+      // Конфигурации ступени в порядке убывания среднего фитнеса, конфигурации без выполненных запусков - в конце.
+      std::vector<size_t> vOrder(vLive.size());
+      std::iota(vOrder.begin(), vOrder.end(), 0);
+      std::stable_sort(vOrder.begin(), vOrder.end(), [this, firstRow](size_t a_, size_t b_)
+         {
+            const SSweepRow& a = m_vRows[firstRow + a_];
+            const SSweepRow& b = m_vRows[firstRow + b_];
+            if ((a.countCompleted > 0) != (b.countCompleted > 0))
+               return a.countCompleted > 0;
+
+            return a.meanFitness > b.meanFitness;
+         });
+
+      const size_t countEvaluated = std::count_if(vOrder.begin(), vOrder.end(), [this, firstRow](size_t i_)
+         {
+            return m_vRows[firstRow + i_].countCompleted > 0;
+         });
+
+      // Портфель с лучшим запуском гарантирует выполненную конфигурацию, проверка - на всякий случай.
+      if (countEvaluated == 0)
+         throw CException(QString("Ни один запуск ступени %1 не выполнен.").arg(rung + 1), TITLE_SWEEP, "CParameterSweep::Run");
+
+      m_idxBestRow = firstRow + vOrder.front();
+
+      if (rung + 1 == countRungs || algorithm_.WasInterrupted())
+         break;
+
+      const size_t countKeep = std::min((vLive.size() + settings_.eta - 1) / settings_.eta, countEvaluated);
+      std::vector<size_t> vNext;
+      for (size_t iOrder = 0; iOrder < countKeep; ++iOrder)
+      {
+         m_vRows[firstRow + vOrder[iOrder]].bPromoted = true;
+         vNext.push_back(vLive[vOrder[iOrder]]);
+      }
+
+      vLive = std::move(vNext);
+   }
+}
+
+const std::vector<SSweepRow>& CParameterSweep::Rows() const
+{
+   return m_vRows;
+}
+
+size_t CParameterSweep::BestRow() const
+{
+   return m_idxBestRow;
+}
+
+QString CParameterSweep::StringTable() const
+{
+   QString str("configuration\trung\titerations\tseeds\tindividuals\tmutation_arguments\tskip_mutation_arguments\t"
+      "mutation_predicates\tskip_mutation_predicates\tmutation_individuals\tcost_arguments\tcost_adding\tlocal_search\t"
+      "completed_seeds\tmean_fitness\tbest_fitness\tfitness_evaluations\trun_ms\trung_ms\tpromoted\terror\n");
+
+   for (size_t iRow = 0; iRow < m_vRows.size(); ++iRow)
+   {
+      const SSweepRow& row = m_vRows[iRow];
+      const SRunSettings& settings = row.settings;
+
+      str += QString("%1\t%2\t%3\t%4\t%5\t%6\t%7\t%8\t%9\t")
+         .arg(row.configuration + 1)
+         .arg(row.rung + 1)
+         .arg(settings.countIterations)
+         .arg(row.countSeeds)
+         .arg(settings.countIndividuals)
+         .arg(settings.percentMutationArguments)
+         .arg(settings.countSkipMutationArg)
+         .arg(settings.percentMutationPredicates)
+         .arg(settings.countSkipMutationPred);
+      str += QString("%1\t%2\t%3\t%4\t")
+         .arg(settings.percentIndividualsUndergoingMutation)
+         .arg(settings.limitOfArgumentsChange)
+         .arg(settings.costAddingPredicate)
+         .arg(settings.countLocalSearch);
+      // Без выполненных запусков фитнес не определен, поля пустые.
+      str += QString("%1\t").arg(row.countCompleted);
+      str += row.countCompleted > 0 ? QString("%1\t%2\t").arg(row.meanFitness).arg(row.bestFitness) : QString("\t\t");
+      str += QString("%1\t%2\t%3\t%4\t")
+         .arg(row.countFitnessEvaluations)
+         .arg(row.runTime)
+         .arg(row.rungTime)
+         .arg(iRow == m_idxBestRow ? "best" : (row.bPromoted ? "yes" : "no"));
+      str += row.error.simplified() + '\n';
+   }
+
+   return str;
+}
+
+std::vector<SRunSettings> CParameterSweep::configurations(const SRunSettings& base_, const SSweepSettings& settings_)
+{
+   std::vector<SRunSettings> vConfigurations;
+
+   if (settings_.countRandom > 0)
+   {
+      CRandom rand;
+      rand.SetSeed(base_.seed);
+
+      for (int iConfiguration = 0; iConfiguration < settings_.countRandom; ++iConfiguration)
+      {
+         SRunSettings settings = base_;
+         for (const auto& range : settings_.vRanges)
+         {
+            double value = 0;
+            if (!range.vValues.empty())
+               value = range.vValues[rand.Generate(0, range.vValues.size() - 1)];
+            else
+            {
+               value = range.min + (range.max - range.min) * (rand.Generate(0, 1000000) / 1000000.);
+               if (PARAMETERS[range.parameter].bInteger)
+                  value = std::round(value);
+            }
+
+            setParameter(settings, range.parameter, value);
+         }
+
+         vConfigurations.push_back(settings);
+      }
+
+      return vConfigurations;
+   }
+
+   size_t countConfigurations = 1;
+   for (const auto& range : settings_.vRanges)
+   {
+      if (range.vValues.empty())
+         throw CException(QString("Отрезок значений параметра %1 допустим только в случайном поиске, для сетки задайте шаг (min:max:шаг).")
+            .arg(ParameterName(range.parameter)), TITLE_SWEEP, "CParameterSweep::configurations");
+
+      countConfigurations *= range.vValues.size();
+      if (countConfigurations > MAX_COUNT_CONFIGURATIONS)
+         throw CException(QString("Слишком много конфигураций сетки (больше %1).").arg(MAX_COUNT_CONFIGURATIONS), TITLE_SWEEP, "CParameterSweep::configurations");
+   }
+
+   // Перебор сетки: индексы значений меняются как разряды числа, первый параметр - младший разряд.
+   std::vector<size_t> vIdxValues(settings_.vRanges.size(), 0);
+   for (size_t iConfiguration = 0; iConfiguration < countConfigurations; ++iConfiguration)
+   {
+      SRunSettings settings = base_;
+      for (size_t iRange = 0; iRange < settings_.vRanges.size(); ++iRange)
+         setParameter(settings, settings_.vRanges[iRange].parameter, settings_.vRanges[iRange].vValues[vIdxValues[iRange]]);
+
+      vConfigurations.push_back(settings);
+
+      for (size_t iRange = 0; iRange < vIdxValues.size(); ++iRange)
+      {
+         if (++vIdxValues[iRange] < settings_.vRanges[iRange].vValues.size())
+            break;
+
+         vIdxValues[iRange] = 0;
+      }
+   }
+
+   return vConfigurations;
+}
+
+void CParameterSweep::setParameter(SRunSettings& settings_, ESweepParameter parameter_, double value_)
+{
+   switch (parameter_)
+   {
+   case eSweepIndividuals:
+      settings_.countIndividuals = static_cast<int>(value_);
+      break;
+   case eSweepMutationArguments:
+      settings_.percentMutationArguments = value_;
+      break;
+   case eSweepSkipMutationArguments:
+      settings_.countSkipMutationArg = static_cast<int>(value_);
+      break;
+   case eSweepMutationPredicates:
+      settings_.percentMutationPredicates = value_;
+      break;
+   case eSweepSkipMutationPredicates:
+      settings_.countSkipMutationPred = static_cast<int>(value_);
+      break;
+   case eSweepMutationIndividuals:
+      settings_.percentIndividualsUndergoingMutation = value_;
+      break;
+   case eSweepCostArguments:
+      settings_.limitOfArgumentsChange = value_;
+      break;
+   case eSweepCostAdding:
+      settings_.costAddingPredicate = value_;
+      break;
+   case eSweepLocalSearch:
+      settings_.countLocalSearch = static_cast<int>(value_);
+      break;
+   default:
+      break;
+   }
+}
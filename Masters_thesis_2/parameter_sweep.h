@@ -0,0 +1,111 @@
+#pragma once
+#include <vector>
+
+#include <QString>
+
+#include "run_settings.h"
+
+class CGeneticAlgorithm;
+
+// Перебираемые параметры запуска (имена совпадают с параметрами консольной программы).
+enum ESweepParameter
+{
+   eSweepIndividuals,             // individuals
+   eSweepMutationArguments,       // mutation-arguments
+   eSweepSkipMutationArguments,   // skip-mutation-arguments
+   eSweepMutationPredicates,      // mutation-predicates
+   eSweepSkipMutationPredicates,  // skip-mutation-predicates
+   eSweepMutationIndividuals,     // mutation-individuals
+   eSweepCostArguments,           // cost-arguments
+   eSweepCostAdding,              // cost-adding
+   eSweepLocalSearch,             // local-search
+   eCountSweepParameters
+};
+
+// Значения одного параметра: список (для сетки и случайного выбора) или отрезок (только для случайного поиска).
+struct SSweepRange
+{
+   ESweepParameter parameter = eSweepIndividuals;
+   std::vector<double> vValues; // пусто - отрезок [min; max]
+   double min = 0;
+   double max = 0;
+};
+
+// Настройки перебора.
+struct SSweepSettings
+{
+   std::vector<SSweepRange> vRanges;
+   int countRandom = 0; // количество случайных конфигураций, 0 - полный перебор сетки
+   int countSeeds = 3;  // запусков (зерен) на конфигурацию
+   int eta = 3;         // после каждой ступени остается 1/eta лучших конфигураций, 1 - без отсева
+   int countRungs = 3;  // количество ступеней
+   int countThreads = 0; // 0 - по количеству ядер
+};
+
+// Итог одной конфигурации на одной ступени.
+struct SSweepRow
+{
+   size_t configuration = 0;
+   int rung = 0;
+   SRunSettings settings; // параметры запусков (зерно - первого запуска)
+   int countSeeds = 0;
+   int countCompleted = 0; // запуски с поколением и без ошибок, только они входят в фитнес
+   double meanFitness = 0; // средний по выполненным запускам лучший фитнес
+   double bestFitness = 0;
+   quint64 countFitnessEvaluations = 0; // сумма по запускам
+   qint64 runTime = 0;  // сумма времени запусков (мс)
+   qint64 rungTime = 0; // время всей ступени (мс)
+   bool bPromoted = false; // конфигурация перешла на следующую ступень
+   QString error;          // первая ошибка запусков конфигурации
+};
+
+// Перебор параметров запуска по сетке или случайный поиск с последовательным отсевом (successive halving).
+// Все конфигурации ступени запускаются одним портфелем (CGeneticAlgorithm::StartPortfolio) с зернами
+// seed, seed + 1, ... (одинаковыми для всех конфигураций), поэтому запуски распределяются по ядрам
+// и используют общий кэш истинности условий. На ступени r из R количество итераций равно
+// countIterations / eta^(R - 1 - r), после ступени остаются ceil(n / eta) конфигураций с лучшим средним фитнесом.
+// Конфигурации без выполненных запусков (ошибка, остановка до первого поколения) ниже всех остальных,
+// лучшими не отмечаются и на следующую ступень не переходят.
+// Алгоритм не умеет продолжать запуск, поэтому на следующей ступени конфигурации запускаются заново.
+class CParameterSweep
+{
+   std::vector<SSweepRow> m_vRows;
+   size_t m_idxBestRow = SIZE_MAX;
+
+public:
+
+   // Разбирает описание пространства параметров вида "имя=значение,значение;имя=min:max;имя=min:max:шаг".
+   // "min:max" - отрезок для случайного поиска, "min:max:шаг" - список значений с шагом.
+   // !> exception при неизвестном параметре или некорректном значении.
+   static std::vector<SSweepRange> ParseSpace(const QString& spec_);
+
+   // Возвращает имя параметра.
+   static QString ParameterName(ESweepParameter parameter_);
+
+   // Выполняет перебор на загруженных в algorithm_ данных.
+   // base_ - значения неперебираемых параметров, base_.countIterations - итерации последней ступени,
+   // base_.seed - зерно первого запуска и случайного выбора конфигураций.
+   // Результат алгоритма - поколение лучшего запуска последней выполненной ступени.
+   // Ограничение времени алгоритма (SetTimeBudget) действует на каждую ступень,
+   // остановленная запросом или по времени ступень становится последней.
+   // !> exception при некорректных настройках или если ни один запуск ступени не выполнен.
+   void Run(CGeneticAlgorithm& algorithm_, const SRunSettings& base_, const SSweepSettings& settings_);
+
+   // Возвращает итоги конфигураций по ступеням в порядке выполнения.
+   const std::vector<SSweepRow>& Rows() const;
+
+   // Возвращает номер строки лучшей конфигурации последней ступени (SIZE_MAX - перебора не было).
+   size_t BestRow() const;
+
+   // Возвращает таблицу итогов (значения разделены табуляцией).
+   QString StringTable() const;
+
+private:
+
+   // Возвращает конфигурации для перебора.
+   // !> exception при отрезке в переборе по сетке.
+   static std::vector<SRunSettings> configurations(const SRunSettings& base_, const SSweepSettings& settings_);
+
+   // Записывает значение value_ параметра parameter_ в settings_.
+   static void setParameter(SRunSettings& settings_, ESweepParameter parameter_, double value_);
+};
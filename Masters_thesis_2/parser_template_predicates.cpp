@@ -1,20 +1,10 @@
+#include <climits>
+
 #include "parser_template_predicates.h"
+#include "text_reader.h"
 #include "exception.h"
 
 
-// Возвращает true и увеличивает index_ на 1, если в позиции index_ есть символ symbol_,
-// иначе возвращает false.
-static bool hasSymbol(const QString& str_, qsizetype& index_, QChar symbol_)
-{
-   if (index_ < str_.size() && str_.at(index_) == symbol_)
-   {
-      ++index_;
-      return true;
-   }
-
-   return false;
-}
-
 // Возвращает true, если symbol_ является зарезервированным символом, false - иначе.
 static bool isIllegalSymbol(QChar symbol_)
 {
@@ -27,22 +17,6 @@ static bool isIllegalSymbol(QChar symbol_)
    return false;
 }
 
-// Возвращает имя из строки str_ начиная с позиции index_.
-// После успешного считывания имени index_ указывает на следующий символ после имени.
-static QString highlightName(const QString& str_, qsizetype& index_)
-{
-   qsizetype start = index_;
-
-   for (; index_ < str_.size(); ++index_)
-   {
-      const QChar& symb = str_.at(index_);
-      if (symb.isSpace() || isIllegalSymbol(symb))
-         break;
-   }
-
-   return str_.mid(start, index_ - start);
-}
-
 // =-=-=-=-=-=-=-=-=-=-=-=-=-= Методы класса =-=-=-=-=-=-=-=-=-=-=-=-=-=
 
 bool SPredicateTemplate::operator<(const SPredicateTemplate& predTempl_) const
@@ -111,90 +85,108 @@ CParserTemplatePredicates::CParserTemplatePredicates(const CPredicatesStorage* s
 
 SCondition CParserTemplatePredicates::Parse(const QString& condition_) const
 {
-   SCondition result;
-   std::map<QString, int> mapTemplateArgs;
+   CTextReader reader(condition_);
+   return Parse(reader);
+}
 
-   const qsizetype length = condition_.length();
-   qsizetype i = 0;
+SCondition CParserTemplatePredicates::Parse(CTextReader& reader_) const
+{
+   CSymbolTable templateArgs; // идентификатор имени - номер аргумента шаблона
+   return parse(reader_, &templateArgs);
+}
+
+SCondition CParserTemplatePredicates::ParseNumbered(const QString& condition_) const
+{
+   CTextReader reader(condition_);
+   return parse(reader, nullptr);
+}
+
+SCondition CParserTemplatePredicates::parse(CTextReader& reader_, CSymbolTable* pTemplateArgs_) const
+{
+   SCondition result;
 
    // считываем левую часть условия
-   while (!skipSpace(condition_, i))
+   while (!reader_.SkipSpace())
    {
-      if (hasSymbol(condition_, i, '-'))
+      if (reader_.HasSymbol('-'))
       {
-         if (hasSymbol(condition_, i, '>'))
+         if (reader_.HasSymbol('>'))
             break; // выход из цикла по левой части условия
          else
-            throw CException("После символа \'-\' ожидался символ \'>\'.");
+            throw CException(reader_.Message("После символа \'-\' ожидался символ \'>\'."));
       }
 
-      result.left.push_back(getPredicate(condition_, i, mapTemplateArgs, result.maxArgument));
+      result.left.push_back(getPredicate(reader_, pTemplateArgs_, result.maxArgument));
    }
 
    if (result.left.empty())
-      throw CException("Отсутствует левая часть условия.");
+      throw CException(reader_.Message("Отсутствует левая часть условия."));
 
    // считываем правую часть условия
-   while (!skipSpace(condition_, i))
+   while (!reader_.SkipSpace())
    {
-      if (hasSymbol(condition_, i, ';'))
+      if (reader_.HasSymbol(SYMBOL_COMPLETION_CONDEITION))
          break; // выход из цикла по правой части условия
 
-      result.right.push_back(getPredicate(condition_, i, mapTemplateArgs, result.maxArgument));
+      result.right.push_back(getPredicate(reader_, pTemplateArgs_, result.maxArgument));
    }
 
    if (result.right.empty())
-      throw CException("Отсутствует правая часть условия.");
+      throw CException(reader_.Message("Отсутствует правая часть условия."));
 
    return result;
 }
 
-SPredicateTemplate CParserTemplatePredicates::getPredicate(const QString& str_, qsizetype& index_, std::map<QString, int>& mapTemplateArgs_, int& maxArg_) const
+SPredicateTemplate CParserTemplatePredicates::getPredicate(CTextReader& reader_, CSymbolTable* pTemplateArgs_, int& maxArg_) const
 {
-   QString predicateName = highlightName(str_, index_);
+   const STextPosition position = reader_.Position();
+   const QString predicateName = reader_.ReadName(isIllegalSymbol).toString();
    if (predicateName.isEmpty())
-      throw CException(QString("Некорректное имя предиката! Встречено:\n%1").arg(str_.mid(index_)));
+      throw CException(reader_.Message(QString("Некорректное имя предиката! Встречен символ \'%1\'.").arg(reader_.Peek())));
 
    size_t idxPredicate = m_storage->GetIndexPredicate(predicateName);
    if (idxPredicate == SIZE_MAX)
-      throw CException(QString("Не найден предикат с именем \"%1\"").arg(predicateName));
+      throw CException(CTextReader::Message(QString("Не найден предикат с именем \"%1\"").arg(predicateName), position));
 
-   skipSpace(str_, index_);
-   if (!hasSymbol(str_, index_, '('))
-      throw CException(QString("После имени предиката \"%1\" ожидаось \'(\'.").arg(predicateName));
+   reader_.SkipSpace();
+   if (!reader_.HasSymbol('('))
+      throw CException(reader_.Message(QString("После имени предиката \"%1\" ожидаось \'(\'.").arg(predicateName)));
 
    size_t countArg = m_storage->CountArguments(idxPredicate);
    std::vector<int> vArguments(countArg);
    for (quint16 iArg = 0; iArg < countArg; ++iArg)
    {
-      if (skipSpace(str_, index_))
-         throw CException(QString("Недостаточно аргументов у предиката \"%1\".").arg(predicateName));
+      if (reader_.SkipSpace())
+         throw CException(reader_.Message(QString("Недостаточно аргументов у предиката \"%1\".").arg(predicateName)));
 
-      QString nameArg = highlightName(str_, index_);
+      QStringView nameArg = reader_.ReadName(isIllegalSymbol);
       if (nameArg.isEmpty())
       {
-         if (index_ < str_.size() && str_.at(index_) == '~')
-         {
-            ++index_;
+         if (reader_.HasSymbol('~'))
             vArguments[iArg] = -1;
-         }
          else
-            throw CException(QString("Некорректное имя переменной у аргумента предиката \"%1\"").arg(predicateName));
+            throw CException(reader_.Message(QString("Некорректное имя переменной у аргумента предиката \"%1\"").arg(predicateName)));
+      }
+      else if (pTemplateArgs_)
+      {
+         // Номер аргумента - порядковый номер первого появления его имени в условии.
+         vArguments[iArg] = static_cast<int>(pTemplateArgs_->Insert(nameArg));
+         maxArg_ = qMax(maxArg_, vArguments[iArg]);
       }
       else
       {
-         auto itTemplArg = mapTemplateArgs_.find(nameArg);
-         if (itTemplArg == mapTemplateArgs_.end())
-            itTemplArg = mapTemplateArgs_.emplace(nameArg, ++maxArg_).first;
+         vArguments[iArg] = GetNumberByLetterDesignation(nameArg);
+         if (vArguments[iArg] < 0)
+            throw CException(reader_.Message(QString("Некорректное обозначение аргумента \"%1\" у предиката \"%2\".").arg(nameArg.toString()).arg(predicateName)));
 
-         vArguments[iArg] = itTemplArg->second;
+         maxArg_ = qMax(maxArg_, vArguments[iArg]);
       }
 
-      skipSpace(str_, index_, ',');
+      reader_.SkipSpace(',');
    }
 
-   if (!hasSymbol(str_, index_, ')'))
-      throw CException(QString("Ожидалось \')\' у предиката \"%1\".").arg(predicateName));
+   if (!reader_.HasSymbol(')'))
+      throw CException(reader_.Message(QString("Ожидалось \')\' у предиката \"%1\".").arg(predicateName)));
 
    return SPredicateTemplate(idxPredicate, vArguments);
 }
@@ -224,3 +216,24 @@ QString CParserTemplatePredicates::GetLetterDesignationByNumber(int value_)
 
    return result;
 }
+
+int CParserTemplatePredicates::GetNumberByLetterDesignation(QStringView designation_)
+{
+   if (designation_.size() == 1 && designation_[0] == '~')
+      return -1;
+
+   if (designation_.isEmpty() || designation_[0] < 'a' || designation_[0] > 'z')
+      return -2;
+
+   int number = 0;
+   if (designation_.size() > 1)
+   {
+      // Номер без ведущих нулей (как в GetLetterDesignationByNumber).
+      bool bOk = false;
+      number = designation_.mid(1).toInt(&bOk);
+      if (!bOk || number <= 0 || designation_[1] == '0' || number > (INT_MAX - 25) / 26)
+         return -2;
+   }
+
+   return number * 26 + (designation_[0].unicode() - 'a');
+}
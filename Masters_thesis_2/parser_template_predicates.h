@@ -3,6 +3,8 @@
 
 #include "predicate.h"
 
+class CTextReader;
+
 // Символ конца условия
 constexpr const char SYMBOL_COMPLETION_CONDEITION = ';';
 
@@ -48,11 +50,24 @@ public:
 
    SCondition Parse(const QString& condition_) const;
 
+   // Считывает одно условие из reader_ (до символа конца условия или конца раздела).
+   SCondition Parse(CTextReader& reader_) const;
+
+   // Считывает условие, записанное GetStringTemplatePredicate: аргументы - буквенные обозначения номеров
+   // (GetLetterDesignationByNumber), поэтому номера аргументов сохраняются, а не нумеруются по порядку появления.
+   SCondition ParseNumbered(const QString& condition_) const;
+
    QString GetStringTemplatePredicate(const SPredicateTemplate& predicate_) const;
 
    static QString GetLetterDesignationByNumber(int value_);
 
+   // Возвращает номер по буквенному обозначению (обратное GetLetterDesignationByNumber), -2 - если обозначение некорректно.
+   static int GetNumberByLetterDesignation(QStringView designation_);
+
 private:
 
-   SPredicateTemplate getPredicate(const QString& str_, qsizetype& index_, std::map<QString, int>& mapTemplateArgs_, int& maxArg_) const;
+   // pTemplateArgs_ - имена аргументов условия, nullptr - аргументы записаны буквенными обозначениями номеров.
+   SCondition parse(CTextReader& reader_, CSymbolTable* pTemplateArgs_) const;
+
+   SPredicateTemplate getPredicate(CTextReader& reader_, CSymbolTable* pTemplateArgs_, int& maxArg_) const;
 };
\ No newline at end of file
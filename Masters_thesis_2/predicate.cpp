@@ -1,10 +1,13 @@
+#include <algorithm>
 #include <cmath>
 
 #include <QTextStream>
 
 #include "predicate.h"
+#include "text_reader.h"
 #include "exception.h"
 #include "counter.h"
+#include "parallel.h"
 #include "global.h"
 
 // Неверный индекс предиката. #1 - кол-во предикатов, #2 - индекс к которому пытались обратиться.
@@ -16,6 +19,76 @@ static const CException EXC_CANT_ADD_VARIABLE("Невозможно измени
 
 constexpr const char RESERVED_CHARACTERS[] = "(),;";
 
+// Максимальный суммарный размер (в символах) пачки блоков предикатов, разбираемых параллельно.
+constexpr qsizetype PREDICATES_BATCH_SIZE = 8 * 1024 * 1024;
+
+struct CPredicatesStorage::SParsedPredicate
+{
+   QString name;           // имя предиката
+   SPredicate predicate;
+   STextPosition position; // позиция имени предиката
+};
+
+// Блок текста раздела предикатов, начинающийся с заголовка предиката.
+struct SPredicatesBlock
+{
+   QString text;
+   STextPosition start; // позиция начала блока в исходном тексте
+};
+
+// Возвращает true, если с текущего символа reader_ начинается заголовок предиката: имя, затем '('.
+static bool isPredicateHeader(CTextReader& reader_)
+{
+   qsizetype offset = 0;
+   for (QChar symb = reader_.Peek(); !symb.isNull(); symb = reader_.Peek(++offset))
+      if (symb.isSpace() || symb == SYMBOL_SECTION_SEPARATOR || CPredicatesStorage::isIllegalSymbol(symb))
+         break;
+
+   if (offset == 0)
+      return false;
+
+   while (reader_.Peek(offset).isSpace())
+      ++offset;
+
+   return reader_.Peek(offset) == '(';
+}
+
+// Считывает из текущего раздела reader_ блоки предикатов в blocks_.
+// Блок заканчивается перед заголовком следующего предиката, поэтому блоки можно разбирать независимо.
+// Чтение останавливается на границе блока, когда суммарный размер достигает PREDICATES_BATCH_SIZE.
+// Если раздел закончился, blocks_ будет пуст.
+static void readPredicatesBlocks(CTextReader& reader_, std::vector<SPredicatesBlock>& blocks_)
+{
+   blocks_.clear();
+
+   if (reader_.SkipSpace())
+      return;
+
+   qsizetype totalSize = 0;
+   blocks_.push_back({ QString(), reader_.Position() });
+
+   while (!reader_.AtEndOfSection())
+   {
+      const QChar symb = reader_.Peek();
+      if (symb.isSpace() || CPredicatesStorage::isIllegalSymbol(symb))
+      {
+         blocks_.back().text.append(reader_.Get());
+         continue;
+      }
+
+      if (!blocks_.back().text.isEmpty() && isPredicateHeader(reader_))
+      {
+         totalSize += blocks_.back().text.size();
+         if (totalSize >= PREDICATES_BATCH_SIZE)
+            return;
+
+         blocks_.push_back({ QString(), reader_.Position() });
+      }
+
+      blocks_.back().text.append(reader_.ReadName(CPredicatesStorage::isIllegalSymbol));
+   }
+}
+
 static size_t pow(size_t base_, size_t exp_)
 {
    size_t result = 1;
@@ -87,26 +160,24 @@ const std::vector<size_t> SPredicate::GetArgs(size_t countVariables_, size_t ind
 
 void CPredicatesStorage::SetVariables(const std::set<QString>& variables_)
 {
-   if (!m_mapPredicates.empty() || !m_vPredicates.empty())
+   if (!m_vPredicates.empty())
       throw EXC_CANT_ADD_VARIABLE;
 
+   m_variables.Clear();
+   m_variables.Reserve(variables_.size());
 
-   m_vVariables.resize(variables_.size());
-
-   size_t idx = 0;
    for (const auto& var : variables_)
    {
       if (var.isEmpty())
          throw CException("Некорректное имя переменной.", "Ошибка изменения переменых", "CPredicatesStorage::SetVariables");
 
-      m_vVariables[idx] = var;
-      m_mapVariables.emplace(var, idx++);
+      m_variables.Insert(var);
    }
 }
 
 bool CPredicatesStorage::SetVariables(const std::vector<QString>& variables_)
 {
-   if (!m_mapPredicates.empty() || !m_vPredicates.empty())
+   if (!m_vPredicates.empty())
       throw EXC_CANT_ADD_VARIABLE;
 
    std::set<QString> setName;
@@ -115,26 +186,31 @@ bool CPredicatesStorage::SetVariables(const std::vector<QString>& variables_)
 
    SetVariables(setName);
 
-   return variables_.size() == m_vVariables.size();
+   return variables_.size() == m_variables.Size();
 }
 
 void CPredicatesStorage::SetVariables(const QString& str_)
 {
-   if (!m_mapPredicates.empty() || !m_vPredicates.empty())
+   CTextReader reader(str_);
+   SetVariables(reader);
+}
+
+void CPredicatesStorage::SetVariables(CTextReader& reader_)
+{
+   if (!m_vPredicates.empty())
       throw EXC_CANT_ADD_VARIABLE;
 
    std::set<QString> setName;
 
-   for (qsizetype i = 0; i < str_.size(); /*++i*/)
+   while (!reader_.SkipSpace())
    {
-      skipSpace(str_, i);
-      QString name = highlightName(str_, i);
+      QStringView name = reader_.ReadName(isIllegalSymbol);
 
       if (name.isEmpty())
-         throw CException(QString("Ожидалось имя переменной. Встречен символ \'%1\'").arg(str_.at(i)), "Ошибка изменения переменых", "CPredicatesStorage::SetVariables");
+         throw CException(reader_.Message(QString("Ожидалось имя переменной. Встречен символ \'%1\'").arg(reader_.Peek())), "Ошибка изменения переменых", "CPredicatesStorage::SetVariables");
 
-      setName.emplace(name);
-      skipSpace(str_, i, ',');
+      setName.emplace(name.toString());
+      reader_.SkipSpace(',');
    }
 
    SetVariables(setName);
@@ -142,109 +218,163 @@ void CPredicatesStorage::SetVariables(const QString& str_)
 
 void CPredicatesStorage::AddPredicates(const QString& str_)
 {
-   if (m_vVariables.empty() || m_mapVariables.empty())
+   CTextReader reader(str_);
+   AddPredicates(reader);
+}
+
+void CPredicatesStorage::AddPredicates(CTextReader& reader_)
+{
+   if (m_variables.IsEmpty())
       throw CException("Невозможно создать предикат, список всех переменных пуст!", "Ошибка добавления предиката", "CPredicatesStorage::AddPredicates");
 
-   qsizetype length = str_.size();
+   std::vector<SPredicatesBlock> vBlocks;
+   std::vector<std::vector<SParsedPredicate>> vParsed;
+
+   for (readPredicatesBlocks(reader_, vBlocks); !vBlocks.empty(); readPredicatesBlocks(reader_, vBlocks))
+   {
+      vParsed.assign(vBlocks.size(), {});
+
+      ParallelFor(vBlocks.size(), [&](size_t iBlock)
+         {
+            CTextReader reader(vBlocks[iBlock].text, vBlocks[iBlock].start);
+            parsePredicates(reader, vParsed[iBlock]);
+         });
+
+      // добавление предикатов в таблицу предикатов (в порядке следования в тексте)
+      for (auto& vPredicates : vParsed)
+      {
+         for (auto& parsed : vPredicates)
+         {
+            if (m_predicates.Find(parsed.name) != SIZE_MAX)
+               throw CException(CTextReader::Message(QString("Попытка добавить предикат с уже существующим именем \"%1\".").arg(parsed.name), parsed.position), "Ошибка добавления предиката", "CPredicatesStorage::AddPredicates");
+
+            m_predicates.Insert(parsed.name);
+            m_vPredicates.push_back(std::move(parsed.predicate));
+         }
+      }
+   }
+}
+
+void CPredicatesStorage::AddPredicate(const QString& name_, SPredicate predicate_)
+{
+   if (m_variables.IsEmpty())
+      throw CException("Невозможно создать предикат, список всех переменных пуст!", "Ошибка добавления предиката", "CPredicatesStorage::AddPredicate");
+
+   if (name_.isEmpty() || std::any_of(name_.begin(), name_.end(), [](QChar symb) { return symb.isSpace() || symb == SYMBOL_SECTION_SEPARATOR || isIllegalSymbol(symb); }))
+      throw CException(QString("Некорректное имя предиката \"%1\".").arg(name_), "Ошибка добавления предиката", "CPredicatesStorage::AddPredicate");
+
+   const size_t countArg = intLog(m_variables.Size(), predicate_.table.size());
+   if (countArg == 0 || pow(m_variables.Size(), countArg) != predicate_.table.size())
+      throw CException(QString("Некорректный размер таблицы истинности у предиката \"%1\": %2.").arg(name_).arg(predicate_.table.size()), "Ошибка добавления предиката", "CPredicatesStorage::AddPredicate");
+
+   if (m_predicates.Find(name_) != SIZE_MAX)
+      throw CException(QString("Попытка добавить предикат с уже существующим именем \"%1\".").arg(name_), "Ошибка добавления предиката", "CPredicatesStorage::AddPredicate");
+
+   m_predicates.Insert(name_);
+   m_vPredicates.push_back(std::move(predicate_));
+}
+
+void CPredicatesStorage::parsePredicates(CTextReader& reader_, std::vector<SParsedPredicate>& predicates_) const
+{
    QString nameNextPredicate;
+   STextPosition positionNextPredicate;
 
    // Цикл по предикатам.
-   for (qsizetype i = 0; i < length; /*++i*/)
+   while (true)
    {
+      QString name;
       SPredicate predicate;
+      STextPosition position;
 
       // имя предиката
 
       if (nameNextPredicate.isEmpty())
       {
-
-         if (skipSpace(str_, i))
+         if (reader_.SkipSpace())
             break;
 
-         predicate.name = highlightName(str_, i);
+         position = reader_.Position();
+         name = reader_.ReadName(isIllegalSymbol).toString();
       }
       else
       {
-         predicate.name = nameNextPredicate;
+         name = std::move(nameNextPredicate);
+         position = positionNextPredicate;
          nameNextPredicate.clear();
       }
 
-      if (predicate.name.isEmpty())
-         throw CException("Некорректное имя предиката.", "Ошибка добавления предиката", "CPredicatesStorage::AddPredicates");
-
-      // проверка существования
-      auto it = m_mapPredicates.find(predicate.name);
-      if (it != m_mapPredicates.end())
-         throw CException(QString("Попытка добавить предикат с уже существующим именем \"%1\".").arg(predicate.name), "Ошибка добавления предиката", "CPredicatesStorage::AddPredicates");
+      if (name.isEmpty())
+         throw CException(reader_.Message("Некорректное имя предиката."), "Ошибка добавления предиката", "CPredicatesStorage::AddPredicates");
 
-      skipSpace(str_, i, '(');
+      reader_.SkipSpace('(');
 
-      if (skipSpace(str_, i))
-         throw CException(QString("Предикат \"%1\" не закончен. Нет количества аргументов и таблицы истинности.").arg(predicate.name), "Ошибка добавления предиката", "CPredicatesStorage::AddPredicates");
+      if (reader_.SkipSpace())
+         throw CException(reader_.Message(QString("Предикат \"%1\" не закончен. Нет количества аргументов и таблицы истинности.").arg(name)), "Ошибка добавления предиката", "CPredicatesStorage::AddPredicates");
 
       // число (кол-во аргументов)
 
       qint16 numberArg = 0;
 
-      while (i < length && str_.at(i).isDigit())
+      while (reader_.Peek().isDigit())
       {
          numberArg *= 10;
-         numberArg += str_.at(i).digitValue();
-         ++i;
+         numberArg += reader_.Get().digitValue();
       }
 
       if (numberArg == 0)
-         throw CException(QString("Ожидалось количество аргументов у предиката \"%1\". У предиката должо быть не менее 1 аргумента.").arg(predicate.name), "Ошибка добавления предиката", "CPredicatesStorage::AddPredicates");
+         throw CException(reader_.Message(QString("Ожидалось количество аргументов у предиката \"%1\". У предиката должо быть не менее 1 аргумента.").arg(name)), "Ошибка добавления предиката", "CPredicatesStorage::AddPredicates");
 
-      skipSpace(str_, i, ')');
+      reader_.SkipSpace(')');
 
       // таблица истинности
-      size_t tableSize = pow(m_vVariables.size(), static_cast<size_t>(numberArg));
+      size_t tableSize = pow(m_variables.Size(), static_cast<size_t>(numberArg));
       predicate.table.assign(tableSize, false);
-      while (i < length)
+      std::vector<size_t> vIdxVar(numberArg, 0);
+      while (!reader_.AtEndOfSection())
       {
          // переменные
          bool bHasVariables = false;
-         std::vector<size_t> vIdxVar(numberArg, 0);
          for (size_t iVar = 0; iVar < numberArg; ++iVar)
          {
-            if (skipSpace(str_, i))
+            if (reader_.SkipSpace())
             {
                if (iVar != 0)
-                  throw CException(QString("Недостаточно переменных в строке таблицы истинности у предиката \"%1\". Ожидалось %2 переменных, имеется %3.").arg(predicate.name).arg(numberArg).arg(iVar), "Ошибка добавления предиката", "CPredicatesStorage::AddPredicates");
+                  throw CException(reader_.Message(QString("Недостаточно переменных в строке таблицы истинности у предиката \"%1\". Ожидалось %2 переменных, имеется %3.").arg(name).arg(numberArg).arg(iVar)), "Ошибка добавления предиката", "CPredicatesStorage::AddPredicates");
 
                break;
             }
 
-            QString var = highlightName(str_, i);
+            const STextPosition positionVar = reader_.Position();
+            QStringView var = reader_.ReadName(isIllegalSymbol);
 
             if (var.isEmpty())
-               throw CException(QString("Некорректое имя переменной в таблице истинности у предиката \"%1\".").arg(predicate.name), "Ошибка добавления предиката", "CPredicatesStorage::AddPredicates");
+               throw CException(reader_.Message(QString("Некорректое имя переменной в таблице истинности у предиката \"%1\".").arg(name)), "Ошибка добавления предиката", "CPredicatesStorage::AddPredicates");
 
-            auto it = m_mapVariables.find(var);
-            if (it == m_mapVariables.end())
+            const size_t idxVar = m_variables.Find(var);
+            if (idxVar == SIZE_MAX)
             {
                if (iVar != 0)
-                  throw CException(QString("Переменной \"%1\" нет в списке переменных. Встречено в таблице истинности у предиката \"%2\".").arg(var).arg(predicate.name), "Ошибка добавления предиката", "CPredicatesStorage::AddPredicates");
+                  throw CException(CTextReader::Message(QString("Переменной \"%1\" нет в списке переменных. Встречено в таблице истинности у предиката \"%2\".").arg(var).arg(name), positionVar), "Ошибка добавления предиката", "CPredicatesStorage::AddPredicates");
                else
                {
-                  nameNextPredicate = var;
+                  nameNextPredicate = var.toString();
+                  positionNextPredicate = positionVar;
                   break;
                }
             }
 
-            vIdxVar[iVar] = it->second;
+            vIdxVar[iVar] = idxVar;
             bHasVariables = true;
 
-            skipSpace(str_, i, ',');
+            reader_.SkipSpace(',');
          }
 
          if (bHasVariables)
          {
-            skipSpace(str_, i, ';');
+            reader_.SkipSpace(';');
 
             // Всевозможные проверки таблицы
-            size_t foundIndex = predicate.GetIndex(static_cast<size_t>(m_vVariables.size()), vIdxVar);
+            size_t foundIndex = predicate.GetIndex(m_variables.Size(), vIdxVar);
             if (foundIndex >= tableSize)
                throw CException("Ошибка индексирования! Обратитесь к разработчику.", "Ошибка добавления предиката", "CPredicatesStorage::AddPredicates");
 
@@ -256,10 +386,7 @@ void CPredicatesStorage::AddPredicates(const QString& str_)
          }
       }
 
-      // добавление предиката в таблицу предикатов
-
-      m_vPredicates.push_back(predicate);
-      m_mapPredicates.emplace(predicate.name, m_vPredicates.size() - 1);
+      predicates_.push_back({ std::move(name), std::move(predicate), position });
    }
 }
 
@@ -267,11 +394,11 @@ QString CPredicatesStorage::StringVariables() const
 {
    QString strVariables;
 
-   if (m_vVariables.empty())
+   if (m_variables.IsEmpty())
       return strVariables;
 
-   for (const auto& var : m_vVariables)
-      strVariables += var + ", ";
+   for (size_t iVar = 0; iVar < m_variables.Size(); ++iVar)
+      strVariables.append(m_variables.Name(iVar)).append(", ");
 
    strVariables.chop(2);
 
@@ -282,39 +409,41 @@ QString CPredicatesStorage::StringPredicatesWithTable() const
 {
    QString strPredicates;
 
-   if (m_vPredicates.empty())
-      return strPredicates;
-
    for (size_t iPred = 0; iPred < m_vPredicates.size(); ++iPred)
    {
-      QString strPred = GetPredicateName(iPred) + '(' + QString().setNum(CountArguments(iPred)) + ")";
+      if (!strPredicates.isEmpty())
+         strPredicates.append(DOUBLE_NEW_LINE);
 
-      // таблица истинности
-      CCounter<size_t> counter(0, m_vVariables.size(), std::vector<size_t>(CountArguments(iPred), 0));
-      for (size_t iArg = 0; iArg < m_vPredicates.at(iPred).table.size(); ++iArg)
-      {
-         if (GetValuePredicate(iPred, iArg))
-         {
-            strPred.append(NEW_LINE);
+      strPredicates.append(StringPredicateWithTable(iPred));
+   }
 
-            const std::vector<size_t>& idxsVars = counter.get();
+   return strPredicates;
+}
 
-            for (const auto& iVar : idxsVars)
-               strPred += m_vVariables.at(iVar) + ", ";
+QString CPredicatesStorage::StringPredicateWithTable(size_t indexPredicate_) const
+{
+   QString strPred = GetPredicateName(indexPredicate_) + '(' + QString().setNum(CountArguments(indexPredicate_)) + ")";
 
-            strPred.chop(2);
-         }
+   // таблица истинности
+   CCounter<size_t> counter(0, m_variables.Size(), std::vector<size_t>(CountArguments(indexPredicate_), 0));
+   for (size_t iArg = 0; iArg < m_vPredicates.at(indexPredicate_).table.size(); ++iArg)
+   {
+      if (GetValuePredicate(indexPredicate_, iArg))
+      {
+         strPred.append(NEW_LINE);
 
-         ++counter;
-      }
+         const std::vector<size_t>& idxsVars = counter.get();
 
-      if (!strPredicates.isEmpty())
-         strPredicates.append(DOUBLE_NEW_LINE);
+         for (const auto& iVar : idxsVars)
+            strPred.append(m_variables.Name(iVar)).append(", ");
+
+         strPred.chop(2);
+      }
 
-      strPredicates.append(strPred);
+      ++counter;
    }
 
-   return strPredicates;
+   return strPred;
 }
 
 QString CPredicatesStorage::StringPredicateWithArg(size_t indexPredicate_, size_t indexArguments_) const
@@ -325,15 +454,15 @@ QString CPredicatesStorage::StringPredicateWithArg(size_t indexPredicate_, size_
    if (indexArguments_ >= m_vPredicates.at(indexPredicate_).table.size())
       throw CException(INVALID_TABLE.arg(GetPredicateName(indexPredicate_)).arg(m_vPredicates.at(indexPredicate_).table.size()).arg(indexArguments_), "Ошибка. Обратитесь к разработчику", "CPredicatesStorage::GetValuePredicate");
 
-   auto idxsVars = m_vPredicates.at(indexPredicate_).GetArgs(m_vVariables.size(), indexArguments_);
+   auto idxsVars = m_vPredicates.at(indexPredicate_).GetArgs(m_variables.Size(), indexArguments_);
 
    if (idxsVars.empty())
       throw CException("Обратитесь к разработчику.", "Непредвиденная ошибка", "CPredicatesStorage::StringPredicateWithArg");
 
-   QString strPred = m_vPredicates.at(indexPredicate_).name + '(';
+   QString strPred = m_predicates.Name(indexPredicate_).toString() + '(';
 
    for (const auto& iVar : idxsVars)
-      strPred += m_vVariables.at(iVar) + ", ";
+      strPred.append(m_variables.Name(iVar)).append(", ");
 
    strPred.chop(2);
    strPred.append(')');
@@ -341,18 +470,14 @@ QString CPredicatesStorage::StringPredicateWithArg(size_t indexPredicate_, size_
    return strPred;
 }
 
-const std::vector<QString>& CPredicatesStorage::GetVariables() const
+const CSymbolTable& CPredicatesStorage::GetVariables() const
 {
-   return m_vVariables;
+   return m_variables;
 }
 
-size_t CPredicatesStorage::GetIndexPredicate(const QString& namePredicate_) const
+size_t CPredicatesStorage::GetIndexPredicate(QStringView namePredicate_) const
 {
-   auto it = m_mapPredicates.find(namePredicate_);
-   if (it != m_mapPredicates.end())
-      return it->second;
-
-   return SIZE_MAX;
+   return m_predicates.Find(namePredicate_);
 }
 
 size_t CPredicatesStorage::GetIndexArgument(size_t indexPredicate_, const std::vector<QString>& arguments_) const
@@ -363,14 +488,12 @@ size_t CPredicatesStorage::GetIndexArgument(size_t indexPredicate_, const std::v
    std::vector<size_t> args(arguments_.size());
    for (size_t i = 0; i < arguments_.size(); ++i)
    {
-      const auto it = m_mapVariables.find(arguments_.at(i));
-      if (it == m_mapVariables.end())
+      args[i] = m_variables.Find(arguments_.at(i));
+      if (args[i] == SIZE_MAX)
          return SIZE_MAX;
-
-      args[i] = static_cast<size_t>(it->second);
    }
 
-   return m_vPredicates.at(indexPredicate_).GetIndex(static_cast<size_t>(m_vVariables.size()), args);
+   return m_vPredicates.at(indexPredicate_).GetIndex(m_variables.Size(), args);
 }
 
 const SPredicate& CPredicatesStorage::GetPredicate(size_t indexPredicate_) const
@@ -397,7 +520,7 @@ QString CPredicatesStorage::GetPredicateName(size_t indexPredicate_) const
    if (indexPredicate_ >= m_vPredicates.size())
       throw CException(INVALID_PREDICATE.arg(m_vPredicates.size()).arg(indexPredicate_), "Ошибка при получении имени предиката", "CPredicatesStorage::GetPredicateName");
 
-   return m_vPredicates.at(indexPredicate_).name;
+   return m_predicates.Name(indexPredicate_).toString();
 }
 
 std::vector<QString> CPredicatesStorage::GetArgumentVariables(size_t indexPredicate_, size_t indexArguments_) const
@@ -408,7 +531,7 @@ std::vector<QString> CPredicatesStorage::GetArgumentVariables(size_t indexPredic
    if (indexArguments_ >= m_vPredicates.at(indexPredicate_).table.size())
       throw CException(INVALID_TABLE.arg(GetPredicateName(indexPredicate_)).arg(m_vPredicates.at(indexPredicate_).table.size()).arg(indexArguments_), "Ошибка при получении имен переменных из таблицы истинности", "CPredicatesStorage::GetArgumentVariables");
 
-   auto vIdxVariable = m_vPredicates.at(indexPredicate_).GetArgs(m_vVariables.size(), indexArguments_);
+   auto vIdxVariable = m_vPredicates.at(indexPredicate_).GetArgs(m_variables.Size(), indexArguments_);
 
    if (vIdxVariable.empty())
       throw CException("Непредвиденная ошибка.", "Ошибка", "CPredicatesStorage::GetArgumentVariables");
@@ -416,14 +539,14 @@ std::vector<QString> CPredicatesStorage::GetArgumentVariables(size_t indexPredic
    std::vector<QString> vNameVariable(vIdxVariable.size());
 
    for (size_t i = 0; i < vIdxVariable.size(); ++i)
-      vNameVariable[i] = m_vVariables.at(vIdxVariable.at(i));
+      vNameVariable[i] = m_variables.Name(vIdxVariable.at(i)).toString();
 
    return vNameVariable;
 }
 
 bool CPredicatesStorage::IsEmpty() const
 {
-   return m_vPredicates.empty() || m_mapPredicates.empty();
+   return m_vPredicates.empty();
 }
 
 size_t CPredicatesStorage::CountPredicates() const
@@ -433,7 +556,7 @@ size_t CPredicatesStorage::CountPredicates() const
 
 size_t CPredicatesStorage::CountVariables() const
 {
-   return m_vVariables.size();
+   return m_variables.Size();
 }
 
 size_t CPredicatesStorage::CountArguments(size_t indexPredicate_) const
@@ -441,51 +564,59 @@ size_t CPredicatesStorage::CountArguments(size_t indexPredicate_) const
    if (indexPredicate_ >= m_vPredicates.size())
       throw CException(INVALID_PREDICATE.arg(m_vPredicates.size()).arg(indexPredicate_), "Ошибка. Обратитесь к разработчику", "CPredicatesStorage::GetCountArguments");
 
-   return intLog(m_vVariables.size(), m_vPredicates.at(indexPredicate_).table.size());
+   return intLog(m_variables.Size(), m_vPredicates.at(indexPredicate_).table.size());
 }
 
-void CPredicatesStorage::Clear()
+quint64 CPredicatesStorage::Fingerprint() const
 {
-   m_mapVariables.clear();
-   m_vVariables.clear();
-   m_mapPredicates.clear();
-   m_vPredicates.clear();
-}
+   quint64 hash = 14695981039346656037ULL;
+   auto add = [&hash](quint64 value_)
+   {
+      for (int iByte = 0; iByte < 8; ++iByte, value_ >>= 8)
+      {
+         hash ^= value_ & 0xFF;
+         hash *= 1099511628211ULL;
+      }
+   };
 
-bool CPredicatesStorage::isIllegalSymbol(QChar symb_)
-{
-   for (char ch : RESERVED_CHARACTERS)
-      if (symb_ == ch)
-         return true;
+   add(m_variables.Size());
+   add(m_vPredicates.size());
+   for (const auto& predicate : m_vPredicates)
+   {
+      add(predicate.table.size());
 
-   return false;
-}
+      // Таблица - по 64 значения за раз.
+      quint64 bits = 0;
+      for (size_t iArg = 0; iArg < predicate.table.size(); ++iArg)
+      {
+         if (predicate.table[iArg])
+            bits |= quint64(1) << (iArg % 64);
 
-QString CPredicatesStorage::highlightName(const QString& str_, qsizetype& index_)
-{
-   qsizetype start = index_;
+         if (iArg % 64 == 63)
+         {
+            add(bits);
+            bits = 0;
+         }
+      }
 
-   for (; index_ < str_.size(); ++index_)
-   {
-      const QChar& symb = str_.at(index_);
-      if (symb.isSpace() || isIllegalSymbol(symb))
-         break;
+      add(bits);
    }
 
-   return str_.mid(start, index_ - start);
+   return hash;
 }
 
-bool skipSpace(const QString& str_, qsizetype& index_)
+void CPredicatesStorage::Clear()
 {
-   while (index_ < str_.size() && str_.at(index_).isSpace())
-      ++index_;
-
-   return index_ >= str_.size();
+   m_variables.Clear();
+   m_predicates.Clear();
+   m_vPredicates.clear();
 }
 
-void skipSpace(const QString& str_, qsizetype& index_, QChar skipSymbol_)
+bool CPredicatesStorage::isIllegalSymbol(QChar symb_)
 {
-   if (!skipSpace(str_, index_))
-      if (str_.at(index_) == skipSymbol_)
-         ++index_;
+   for (char ch : RESERVED_CHARACTERS)
+      if (symb_ == ch)
+         return true;
+
+   return false;
 }
@@ -1,12 +1,16 @@
 #pragma once
 #include <vector>
-#include <map>
 #include <set>
 
 #include <QString>
+#include <QStringView>
+
+#include "symbol_table.h"
+
+class CTextReader;
 
 // Предикат.
-// Хранит имя предиката name и его таблицу истинности table.
+// Хранит таблицу истинности предиката table (имя хранится в таблице имен хранилища).
 // Таблица записывается по порядку переменных.
 // 
 // Пример:
@@ -23,7 +27,6 @@ size_t GetIndex(size_t countVariables_, const std::vector<size_t>& args_);
 
 struct SPredicate
 {
-   QString name;            // имя предиката
    std::vector<bool> table; // таблица истинности
 
    // Возвращает индекс таблицы истинности для набора переменных (точнее их индексов).
@@ -47,10 +50,9 @@ struct SPredicate
 // его таблица истинности будет уже не действительна.
 class CPredicatesStorage
 {
-   std::map<QString, size_t> m_mapVariables;
-   std::vector<QString> m_vVariables;
-
-   std::map<QString, size_t> m_mapPredicates;
+   // Идентификатор переменной - ее индекс, идентификатор имени предиката - индекс в m_vPredicates.
+   CSymbolTable m_variables;
+   CSymbolTable m_predicates;
    std::vector<SPredicate> m_vPredicates;
 
 public:
@@ -74,6 +76,10 @@ public:
    // !> exception если нет переменных в строке str_.
    void SetVariables(const QString& str_);
 
+   // Задает переменные, считывая текущий раздел из reader_.
+   // Форматирование как у SetVariables(const QString&), ошибки содержат строку и столбец.
+   void SetVariables(CTextReader& reader_);
+
    // Добавляет предикаты.
    // Форматирование: Первые символы до '(' или пробельного символа - имя предиката.
    // После имени (в скобках, а можно и без них) число принемаемых аргументов.
@@ -83,6 +89,18 @@ public:
    // !> exception если нет количества аргументов или недостаточное кол-во аргументов в строке таблицы.
    void AddPredicates(const QString& str_);
 
+   // Добавляет предикаты, считывая текущий раздел из reader_.
+   // Раздел делится на блоки по заголовкам предикатов (имя и '('), блоки разбираются параллельно
+   // пачками ограниченного размера, поэтому исходный текст целиком в памяти не хранится.
+   // Предикаты добавляются в порядке следования в тексте.
+   // Форматирование как у AddPredicates(const QString&), ошибки содержат строку и столбец.
+   void AddPredicates(CTextReader& reader_);
+
+   // Добавляет предикат с готовой таблицей истинности (размер таблицы - степень количества переменных).
+   // !> exception при некорректном имени предиката или размере таблицы.
+   // !> exception если предикат с таким именем уже существует.
+   void AddPredicate(const QString& name_, SPredicate predicate_);
+
    // ========================= Вывод данных в строку =========================
 
    // Возвращает строку с переменными.
@@ -91,6 +109,10 @@ public:
    // Возвращает строку с предикатами и их таблицами истинности.
    QString StringPredicatesWithTable() const;
 
+   // Возвращает строку с предикатом indexPredicate_ и его таблицей истинности.
+   // !> exception если нет предиката с индексом indexPredicate_.
+   QString StringPredicateWithTable(size_t indexPredicate_) const;
+
    // Возвращает имя предиката с аргументами по индксам.
    // indexPredicate_ - индекс предиката, indexArguments_ - индекс таблицы истинности.
    // !> exception если нет предиката с индексом indexPredicate_.
@@ -99,12 +121,12 @@ public:
 
    // =========================== Получение данных ============================
 
-   // Возвращает вектор переменных.
-   const std::vector<QString>& GetVariables() const;
+   // Возвращает таблицу имен переменных (идентификатор имени - индекс переменной).
+   const CSymbolTable& GetVariables() const;
 
    // Получить индекс предиката по его названию.
    // Если такого предиката нет - вернет SIZE_MAX.
-   size_t GetIndexPredicate(const QString& namePredicate_) const;
+   size_t GetIndexPredicate(QStringView namePredicate_) const;
 
    // Получить индекс таблицы истинности по переменным arguments_ для предиката с индексом indexPredicate_.
    // Если такого предиката или таких переменных нет - вернет SIZE_MAX.
@@ -144,6 +166,10 @@ public:
    // !> exception если индекс невалиден.
    size_t CountArguments(size_t indexPredicate_) const;
 
+   // Возвращает отпечаток данных (64-битный FNV-1a): количество переменных, порядок и таблицы истинности
+   // предикатов. Имена не учитываются - от них истинность условий не зависит.
+   quint64 Fingerprint() const;
+
    // ======================== Вспомогательные функции ========================
 
    // Очищает переменныи и предикаты.
@@ -154,18 +180,10 @@ public:
 
 private:
 
-   // Выделяет имя.
-   // Начинает с символа index_ и заканчивает пробельным символом или зарезервированным символом.
-   // index_ будет указывать на следующий символ, после имени.
-   static QString highlightName(const QString& str_, qsizetype& index_);
-};
-
-// Пропускает все пробельные символы, в строке, начиная с index_.
-// index_ становится равным первому не пробельному символу или str_.size().
-// Возвращает true, если был достигнут конец строки.
-bool skipSpace(const QString& str_, qsizetype& index_);
+   // Считанный предикат и позиция его имени в тексте.
+   struct SParsedPredicate;
 
-// Пропускает все пробельные символы, в строке, начиная с index_.
-// Затем пропускает, если есть символ skipSymbol_.
-// index_ становится равным следующему символу после skipSymbol_ или первому не пробельному или str_.size().
-void skipSpace(const QString& str_, qsizetype& index_, QChar skipSymbol_);
\ No newline at end of file
+   // Разбирает предикаты из reader_ в predicates_, не изменяя хранилище.
+   // Проверка имен на уникальность не выполняется.
+   void parsePredicates(CTextReader& reader_, std::vector<SParsedPredicate>& predicates_) const;
+};
\ No newline at end of file
@@ -0,0 +1,412 @@
+#include <algorithm>
+
+#include <QPersistentModelIndex>
+
+#include "result_model.h"
+#include "genetic_algorithm.h"
+#include "exception.h"
+
+// Количество элементов, добавляемых за один fetchMore.
+static constexpr size_t FETCH_ITEMS = 500;
+
+// Количество истинных значений предиката, добавляемых за один fetchMore.
+static constexpr size_t FETCH_PREDICATE_VALUES = 500;
+
+// Количество значений таблицы истинности, просматриваемых за один fetchMore (поток окна не блокируется
+// на больших разреженных таблицах).
+static constexpr size_t FETCH_PREDICATE_SCAN = 1 << 20;
+
+// Внутренний номер индекса: 0 - раздел, [1; eCountSections] - элемент раздела (номер раздела + 1),
+// далее - значение элемента (номер раздела и строка элемента-родителя).
+static constexpr quintptr ID_SECTION = 0;
+
+static quintptr itemId(int section_)
+{
+   return static_cast<quintptr>(section_) + 1;
+}
+
+static quintptr childId(int section_, int item_)
+{
+   return 1 + CResultModel::eCountSections + static_cast<quintptr>(item_) * CResultModel::eCountSections + section_;
+}
+
+static const QString SECTION_NAMES[CResultModel::eCountSections] = {
+   "Переменные",
+   "Предикаты",
+   "Ограничение целостности",
+   "Поколение"
+};
+
+CResultModel::CResultModel(const CGeneticAlgorithm* algorithm_, QObject* parent_)
+   : QAbstractItemModel(parent_), m_algorithm(algorithm_)
+{
+   UpdateData();
+}
+
+void CResultModel::UpdateData()
+{
+   beginResetModel();
+
+   m_snapshot = m_algorithm ? m_algorithm->Snapshot() : nullptr;
+   m_aLoaded.fill(0);
+   m_vPredicateRows.assign(countItems(ePredicates), SPredicateRows());
+   m_vTrueOriginal.assign(countItems(eIntegrityLimitation), -1);
+
+   endResetModel();
+}
+
+void CResultModel::UpdateGeneration()
+{
+   const QModelIndex section = index(eGeneration, eColumnValue);
+
+   if (m_aLoaded[eGeneration] > 0)
+   {
+      beginRemoveRows(section, 0, static_cast<int>(m_aLoaded[eGeneration]) - 1);
+      m_aLoaded[eGeneration] = 0;
+      endRemoveRows();
+   }
+
+   m_snapshot = m_algorithm ? m_algorithm->Snapshot() : nullptr;
+
+   // Раскрытый раздел сразу показывает новое поколение, остальное подгрузится по прокрутке.
+   if (canFetchMore(section))
+      fetchMore(section);
+}
+
+void CResultModel::SetCountIndividuals(size_t count_)
+{
+   if (count_ == m_countIndividuals)
+      return;
+
+   const QModelIndex section = index(eGeneration, eColumnValue);
+
+   if (count_ < m_aLoaded[eGeneration])
+   {
+      beginRemoveRows(section, static_cast<int>(count_), static_cast<int>(m_aLoaded[eGeneration]) - 1);
+      m_countIndividuals = count_;
+      m_aLoaded[eGeneration] = count_;
+      endRemoveRows();
+   }
+   else
+      m_countIndividuals = count_;
+}
+
+QModelIndex CResultModel::index(int row_, int column_, const QModelIndex& parent_) const
+{
+   if (row_ < 0 || column_ < 0 || column_ >= eCountColumns)
+      return QModelIndex();
+
+   if (!parent_.isValid())
+      return row_ < eCountSections ? createIndex(row_, column_, ID_SECTION) : QModelIndex();
+
+   int section = 0;
+   int item = 0;
+   switch (decode(parent_, section, item))
+   {
+   case eLevelSection:
+      return createIndex(row_, column_, itemId(section));
+   case eLevelItem:
+      return createIndex(row_, column_, childId(section, item));
+   default:
+      return QModelIndex();
+   }
+}
+
+QModelIndex CResultModel::parent(const QModelIndex& index_) const
+{
+   int section = 0;
+   int item = 0;
+   switch (decode(index_, section, item))
+   {
+   case eLevelItem:
+      return createIndex(section, eColumnValue, ID_SECTION);
+   case eLevelChild:
+      return createIndex(item, eColumnValue, itemId(section));
+   default:
+      return QModelIndex();
+   }
+}
+
+int CResultModel::rowCount(const QModelIndex& parent_) const
+{
+   if (!parent_.isValid())
+      return eCountSections;
+
+   if (parent_.column() != eColumnValue)
+      return 0;
+
+   int section = 0;
+   int item = 0;
+   switch (decode(parent_, section, item))
+   {
+   case eLevelSection:
+      return static_cast<int>(m_aLoaded[section]);
+   case eLevelItem:
+      if (section == ePredicates)
+         return static_cast<int>(m_vPredicateRows[item].vIdxArguments.size());
+
+      if (section == eGeneration && m_snapshot && static_cast<size_t>(item) < m_snapshot->best.size())
+         return static_cast<int>(m_snapshot->best[item].first.size());
+
+      return 0;
+   default:
+      return 0;
+   }
+}
+
+int CResultModel::columnCount(const QModelIndex& parent_) const
+{
+   Q_UNUSED(parent_);
+   return eCountColumns;
+}
+
+bool CResultModel::hasChildren(const QModelIndex& parent_) const
+{
+   if (!parent_.isValid())
+      return true;
+
+   if (parent_.column() != eColumnValue)
+      return false;
+
+   int section = 0;
+   int item = 0;
+   switch (decode(parent_, section, item))
+   {
+   case eLevelSection:
+      return countItems(section) > 0;
+   case eLevelItem:
+      if (section == ePredicates)
+      {
+         // Пока таблица не просмотрена до конца, истинные значения могут найтись.
+         const SPredicateRows& rows = m_vPredicateRows[item];
+         return !rows.vIdxArguments.empty() || rows.scanned < m_algorithm->GetStorage().GetPredicate(item).table.size();
+      }
+
+      return section == eGeneration;
+   default:
+      return false;
+   }
+}
+
+QVariant CResultModel::data(const QModelIndex& index_, int role_) const
+{
+   if (!index_.isValid() || role_ != Qt::DisplayRole)
+      return QVariant();
+
+   int section = 0;
+   int item = 0;
+   switch (decode(index_, section, item))
+   {
+   case eLevelSection:
+      return index_.column() == eColumnValue ? SECTION_NAMES[section] : QVariant();
+   case eLevelItem:
+      return itemText(section, index_.row(), index_.column());
+   case eLevelChild:
+      return childText(section, item, index_.row(), index_.column());
+   default:
+      return QVariant();
+   }
+}
+
+QVariant CResultModel::headerData(int section_, Qt::Orientation orientation_, int role_) const
+{
+   if (orientation_ != Qt::Horizontal || role_ != Qt::DisplayRole)
+      return QVariant();
+
+   switch (section_)
+   {
+   case eColumnValue:
+      return "Значение";
+   case eColumnFitness:
+      return "Фитнес";
+   case eColumnTrue:
+      return "Истинность";
+   default:
+      return QVariant();
+   }
+}
+
+bool CResultModel::canFetchMore(const QModelIndex& parent_) const
+{
+   if (!parent_.isValid() || parent_.column() != eColumnValue)
+      return false;
+
+   int section = 0;
+   int item = 0;
+   switch (decode(parent_, section, item))
+   {
+   case eLevelSection:
+      return m_aLoaded[section] < countItems(section);
+   case eLevelItem:
+      return section == ePredicates && m_vPredicateRows[item].scanned < m_algorithm->GetStorage().GetPredicate(item).table.size();
+   default:
+      return false;
+   }
+}
+
+void CResultModel::fetchMore(const QModelIndex& parent_)
+{
+   if (!canFetchMore(parent_))
+      return;
+
+   int section = 0;
+   int item = 0;
+   if (decode(parent_, section, item) == eLevelSection)
+   {
+      const size_t first = m_aLoaded[section];
+      const size_t last = std::min(first + FETCH_ITEMS, countItems(section));
+
+      beginInsertRows(parent_, static_cast<int>(first), static_cast<int>(last) - 1);
+      m_aLoaded[section] = last;
+      endInsertRows();
+      return;
+   }
+
+   // Количество истинных значений заранее неизвестно, поэтому таблица просматривается до вставки строк.
+   SPredicateRows& rows = m_vPredicateRows[item];
+   SPredicateRows found;
+   found.scanned = rows.scanned;
+   scanPredicate(item, FETCH_PREDICATE_VALUES, FETCH_PREDICATE_SCAN, found);
+
+   rows.scanned = found.scanned;
+   if (!found.vIdxArguments.empty())
+   {
+      const size_t first = rows.vIdxArguments.size();
+      beginInsertRows(parent_, static_cast<int>(first), static_cast<int>(first + found.vIdxArguments.size()) - 1);
+      rows.vIdxArguments.insert(rows.vIdxArguments.end(), found.vIdxArguments.begin(), found.vIdxArguments.end());
+      endInsertRows();
+   }
+
+   // Просмотр остановлен по количеству просмотренных значений - продолжается после обработки событий окна
+   // (представление может не запросить строки, если новых не добавилось).
+   if (found.vIdxArguments.size() < FETCH_PREDICATE_VALUES && canFetchMore(parent_))
+   {
+      QMetaObject::invokeMethod(this, [this, index = QPersistentModelIndex(parent_)]()
+         {
+            if (index.isValid())
+               fetchMore(index);
+         }, Qt::QueuedConnection);
+   }
+}
+
+size_t CResultModel::countItems(int section_) const
+{
+   if (!m_algorithm)
+      return 0;
+
+   switch (section_)
+   {
+   case eVariables:
+      return m_algorithm->GetStorage().CountVariables();
+   case ePredicates:
+      return m_algorithm->GetStorage().CountPredicates();
+   case eIntegrityLimitation:
+      return m_algorithm->GetOriginal().size();
+   case eGeneration:
+      return m_snapshot ? std::min(m_snapshot->best.size(), m_countIndividuals) : 0;
+   default:
+      return 0;
+   }
+}
+
+CResultModel::ELevel CResultModel::decode(const QModelIndex& index_, int& section_, int& item_) const
+{
+   const quintptr id = index_.internalId();
+   if (id == ID_SECTION)
+   {
+      section_ = index_.row();
+      item_ = -1;
+      return eLevelSection;
+   }
+
+   if (id <= eCountSections)
+   {
+      section_ = static_cast<int>(id - 1);
+      item_ = index_.row();
+      return eLevelItem;
+   }
+
+   const quintptr child = id - 1 - eCountSections;
+   section_ = static_cast<int>(child % eCountSections);
+   item_ = static_cast<int>(child / eCountSections);
+   return eLevelChild;
+}
+
+QString CResultModel::itemText(int section_, int item_, int column_) const
+{
+   const CPredicatesStorage& storage = m_algorithm->GetStorage();
+
+   switch (section_)
+   {
+   case eVariables:
+      return column_ == eColumnValue ? storage.GetVariables().Name(item_).toString() : QString();
+   case ePredicates:
+      return column_ == eColumnValue ? QString("%1(%2)").arg(storage.GetPredicateName(item_)).arg(storage.CountArguments(item_)) : QString();
+   case eIntegrityLimitation:
+   {
+      const SCondition& condition = m_algorithm->GetOriginal().at(item_);
+      if (column_ == eColumnValue)
+         return m_algorithm->StringCondition(condition);
+
+      if (column_ != eColumnTrue)
+         return QString();
+
+      // Истинность вычисляется только для показанных строк и запоминается.
+      signed char& bTrue = m_vTrueOriginal[item_];
+      if (bTrue < 0)
+      {
+         try
+         {
+            bTrue = m_algorithm->IsTrueCondition(condition) ? 1 : 0;
+         }
+         catch (const CException&)
+         {
+            return "?";
+         }
+      }
+
+      return bTrue ? "true" : "false";
+   }
+   case eGeneration:
+   {
+      if (!m_snapshot || static_cast<size_t>(item_) >= m_snapshot->best.size())
+         return QString();
+
+      if (column_ == eColumnValue)
+         return QString("#%1").arg(item_ + 1);
+
+      if (column_ == eColumnFitness)
+         return QString::number(m_snapshot->best[item_].second);
+
+      return QString();
+   }
+   default:
+      return QString();
+   }
+}
+
+QString CResultModel::childText(int section_, int item_, int row_, int column_) const
+{
+   if (column_ != eColumnValue)
+      return QString();
+
+   if (section_ == ePredicates)
+      return m_algorithm->GetStorage().StringPredicateWithArg(item_, m_vPredicateRows[item_].vIdxArguments.at(row_));
+
+   if (section_ == eGeneration && m_snapshot && static_cast<size_t>(item_) < m_snapshot->best.size())
+      return m_algorithm->StringCondition(m_snapshot->best[item_].first.at(row_));
+
+   return QString();
+}
+
+void CResultModel::scanPredicate(size_t idxPredicate_, size_t count_, size_t countScan_, SPredicateRows& rows_) const
+{
+   const std::vector<bool>& table = m_algorithm->GetStorage().GetPredicate(idxPredicate_).table;
+   const size_t end = std::min(table.size(), rows_.scanned + countScan_);
+
+   for (; rows_.scanned < end && rows_.vIdxArguments.size() < count_; ++rows_.scanned)
+   {
+      if (table[rows_.scanned])
+         rows_.vIdxArguments.push_back(rows_.scanned);
+   }
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <array>
+#include <memory>
+#include <vector>
+
+#include <QAbstractItemModel>
+
+#include "generation_snapshot.h"
+
+class CGeneticAlgorithm;
+
+// Модель данных алгоритма для окна просмотра (дерево из трех уровней).
+// Верхний уровень - разделы: переменные, предикаты, изначальное ограничение, последнее поколение.
+// Второй - элементы раздела, третий - истинные значения предиката или условия особи.
+// Строки формируются только при запросе видом (для видимых строк), элементы разделов и значения
+// предикатов подгружаются частями через canFetchMore/fetchMore.
+// Поколение берется из снимка алгоритма, поэтому модель можно обновлять во время работы алгоритма.
+class CResultModel : public QAbstractItemModel
+{
+   Q_OBJECT
+
+public:
+
+   enum ESection : int
+   {
+      eVariables,
+      ePredicates,
+      eIntegrityLimitation,
+      eGeneration,
+      eCountSections
+   };
+
+   enum EColumn : int
+   {
+      eColumnValue,   // имя / условие / особь
+      eColumnFitness, // фитнес особи
+      eColumnTrue,    // истинность условия изначального ограничения
+      eCountColumns
+   };
+
+   explicit CResultModel(const CGeneticAlgorithm* algorithm_, QObject* parent_ = nullptr);
+
+   // Перечитывает все данные алгоритма (после загрузки данных).
+   void UpdateData();
+
+   // Перечитывает только последнее поколение (после нового снимка).
+   void UpdateGeneration();
+
+   // Задает наибольшее количество выводимых особей.
+   void SetCountIndividuals(size_t count_);
+
+   QModelIndex index(int row_, int column_, const QModelIndex& parent_ = QModelIndex()) const override;
+   QModelIndex parent(const QModelIndex& index_) const override;
+   int rowCount(const QModelIndex& parent_ = QModelIndex()) const override;
+   int columnCount(const QModelIndex& parent_ = QModelIndex()) const override;
+   bool hasChildren(const QModelIndex& parent_ = QModelIndex()) const override;
+   QVariant data(const QModelIndex& index_, int role_ = Qt::DisplayRole) const override;
+   QVariant headerData(int section_, Qt::Orientation orientation_, int role_ = Qt::DisplayRole) const override;
+   bool canFetchMore(const QModelIndex& parent_) const override;
+   void fetchMore(const QModelIndex& parent_) override;
+
+private:
+
+   // Загруженные истинные значения предиката.
+   struct SPredicateRows
+   {
+      size_t scanned = 0;               // сколько значений таблицы истинности просмотрено
+      std::vector<size_t> vIdxArguments; // индексы истинных значений в таблице
+   };
+
+   // Уровень элемента.
+   enum ELevel
+   {
+      eLevelSection,
+      eLevelItem,
+      eLevelChild
+   };
+
+   const CGeneticAlgorithm* m_algorithm = nullptr;
+   std::shared_ptr<const SGenerationSnapshot> m_snapshot;
+   size_t m_countIndividuals = 100;
+
+   std::array<size_t, eCountSections> m_aLoaded = {}; // загружено элементов в разделе
+   std::vector<SPredicateRows> m_vPredicateRows;
+   mutable std::vector<signed char> m_vTrueOriginal; // истинность условий: -1 - не вычислена, 0, 1
+
+   // Возвращает количество элементов раздела section_.
+   size_t countItems(int section_) const;
+
+   // Возвращает уровень элемента и номера его раздела и элемента второго уровня.
+   ELevel decode(const QModelIndex& index_, int& section_, int& item_) const;
+
+   // Возвращает текст элемента второго уровня.
+   QString itemText(int section_, int item_, int column_) const;
+
+   // Возвращает текст элемента третьего уровня.
+   QString childText(int section_, int item_, int row_, int column_) const;
+
+   // Продолжает просмотр таблицы истинности предиката idxPredicate_ с позиции rows_.scanned,
+   // пока в rows_ не наберется count_ истинных значений, не будет просмотрено countScan_ значений
+   // или таблица не закончится.
+   void scanPredicate(size_t idxPredicate_, size_t count_, size_t countScan_, SPredicateRows& rows_) const;
+};
@@ -0,0 +1,357 @@
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+#include <QDataStream>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include "result_reader.h"
+#include "result_writer.h"
+#include "predicate.h"
+#include "exception.h"
+
+#define SPLITTER "===================="
+
+static const char* TITLE_IMPORT = "Ошибка импорта особей";
+
+// Сообщение о некорректном двоичном файле.
+static const QString INVALID_BINARY("Некорректный двоичный файл результата: %1");
+
+// Проверяет состояние потока после чтения.
+// !> exception при ошибке чтения.
+static void checkRead(const QDataStream& stream_, const QString& what_)
+{
+   if (stream_.status() != QDataStream::Ok)
+      throw CException(INVALID_BINARY.arg(what_), TITLE_IMPORT, "CResultReader::readBinary");
+}
+
+// Возвращает true, если данные device_ начинаются с сигнатуры двоичного результата. Позиция чтения не изменяется.
+static bool isBinaryResult(QIODevice* device_)
+{
+   const QByteArray head = device_->peek(sizeof(quint32));
+   if (head.size() != sizeof(quint32))
+      return false;
+
+   quint32 magic = 0;
+   QDataStream stream(head);
+   stream.setByteOrder(QDataStream::LittleEndian);
+   stream >> magic;
+
+   return magic == RESULT_BINARY_MAGIC;
+}
+
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-= Методы класса =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+CResultReader::CResultReader(const CPredicatesStorage& storage_)
+   : m_storage(storage_)
+{
+}
+
+std::vector<CResultReader::TIndividual> CResultReader::Read(const QString& fileName_, size_t countConditions_, size_t countIndividuals_) const
+{
+   QFile file(fileName_);
+   if (!file.open(QIODevice::ReadOnly))
+      throw CException("Не удалось открыть файл: " + fileName_, TITLE_IMPORT, "CResultReader::Read");
+
+   std::vector<TIndividual> vIndividuals;
+   if (isBinaryResult(&file))
+   {
+      readBinary(&file, countConditions_, countIndividuals_, vIndividuals);
+   }
+   else if (CResultWriter::FormatByFileName(fileName_) == CResultWriter::eJsonLines)
+   {
+      readJsonLines(&file, countConditions_, countIndividuals_, vIndividuals);
+   }
+   else
+   {
+      file.setTextModeEnabled(true);
+      readText(&file, countConditions_, countIndividuals_, vIndividuals);
+   }
+
+   return vIndividuals;
+}
+
+void CResultReader::readText(QIODevice* device_, size_t countConditions_, size_t countIndividuals_, std::vector<TIndividual>& vIndividuals_) const
+{
+   // Текст записан в локальной кодировке (CResultWriter::putText).
+   const QString text = QString::fromLocal8Bit(device_->readAll());
+
+   // Поколение - последний раздел, особи разделены пустыми строками (и строками "#N = фитнес").
+   const qsizetype idxSplitter = text.lastIndexOf(QString(SPLITTER));
+   const qsizetype idxGeneration = idxSplitter < 0 ? 0 : idxSplitter + qsizetype(std::strlen(SPLITTER));
+   const QStringList lines = text.mid(idxGeneration).split('\n');
+   const qsizetype firstLine = text.left(idxGeneration).count('\n') + 1;
+
+   CParserTemplatePredicates parser(&m_storage);
+   TIndividual individual;
+   qsizetype lineIndividual = 0; // строка начала особи
+
+   auto finishIndividual = [&]()
+   {
+      if (individual.empty())
+         return;
+
+      if (individual.size() != countConditions_)
+         throw CException(QString("Особь в строке %1: условий %2, а в изначальном ограничении %3.").arg(lineIndividual).arg(individual.size()).arg(countConditions_), TITLE_IMPORT, "CResultReader::readText");
+
+      vIndividuals_.push_back(std::move(individual));
+      individual.clear();
+   };
+
+   for (qsizetype iLine = 0; iLine < lines.size() && vIndividuals_.size() < countIndividuals_; ++iLine)
+   {
+      const QString line = lines[iLine].trimmed();
+      if (line.isEmpty() || line.startsWith('#'))
+      {
+         finishIndividual();
+         continue;
+      }
+
+      if (individual.empty())
+         lineIndividual = firstLine + iLine;
+
+      try
+      {
+         individual.push_back(parser.ParseNumbered(line));
+         checkArguments(individual.back());
+      }
+      catch (CException& error)
+      {
+         error.addToBeginningMessage(QString("Строка %1.").arg(firstLine + iLine), " ");
+         error.title(TITLE_IMPORT);
+         error.location("CResultReader::readText");
+         throw error;
+      }
+   }
+
+   if (vIndividuals_.size() < countIndividuals_)
+      finishIndividual();
+}
+
+void CResultReader::readJsonLines(QIODevice* device_, size_t countConditions_, size_t countIndividuals_, std::vector<TIndividual>& vIndividuals_) const
+{
+   CParserTemplatePredicates parser(&m_storage);
+
+   for (qsizetype iLine = 1; !device_->atEnd() && vIndividuals_.size() < countIndividuals_; ++iLine)
+   {
+      const QByteArray line = device_->readLine().trimmed();
+      if (line.isEmpty())
+         continue;
+
+      QJsonParseError parseError;
+      const QJsonDocument document = QJsonDocument::fromJson(line, &parseError);
+      if (parseError.error != QJsonParseError::NoError || !document.isObject())
+         throw CException(QString("Строка %1: некорректный JSON.").arg(iLine), TITLE_IMPORT, "CResultReader::readJsonLines");
+
+      const QJsonObject object = document.object();
+      if (object.value("type").toString() != "individual")
+         continue;
+
+      // Условия берутся из текста: индексы предикатов в файле могут не совпадать с текущими данными.
+      const QJsonArray conditions = object.value("conditions").toArray();
+      if (static_cast<size_t>(conditions.size()) != countConditions_)
+         throw CException(QString("Строка %1: условий %2, а в изначальном ограничении %3.").arg(iLine).arg(conditions.size()).arg(countConditions_), TITLE_IMPORT, "CResultReader::readJsonLines");
+
+      TIndividual individual;
+      individual.reserve(countConditions_);
+
+      try
+      {
+         for (const auto& condition : conditions)
+         {
+            individual.push_back(parser.ParseNumbered(condition.toObject().value("text").toString()));
+            checkArguments(individual.back());
+         }
+      }
+      catch (CException& error)
+      {
+         error.addToBeginningMessage(QString("Строка %1.").arg(iLine), " ");
+         error.title(TITLE_IMPORT);
+         error.location("CResultReader::readJsonLines");
+         throw error;
+      }
+
+      vIndividuals_.push_back(std::move(individual));
+   }
+}
+
+void CResultReader::checkArguments(const SCondition& condition_) const
+{
+   if (condition_.maxArgument >= 0 && static_cast<size_t>(condition_.maxArgument) >= m_storage.CountVariables())
+      throw CException(QString("Номер аргумента %1 в условии не меньше количества переменных %2.").arg(condition_.maxArgument).arg(m_storage.CountVariables()), TITLE_IMPORT, "CResultReader::checkArguments");
+}
+
+void CResultReader::readBinary(QIODevice* device_, size_t countConditions_, size_t countIndividuals_, std::vector<TIndividual>& vIndividuals_) const
+{
+   QDataStream stream(device_);
+   stream.setByteOrder(QDataStream::LittleEndian);
+   stream.setVersion(QDataStream::Qt_6_0);
+
+   quint32 magic = 0, version = 0, generation = 0, seed = 0;
+   quint8 sections = 0;
+   stream >> magic >> version >> sections >> generation >> seed;
+   checkRead(stream, "нет заголовка.");
+
+   if (version != RESULT_BINARY_VERSION)
+      throw CException(INVALID_BINARY.arg(QString("неподдерживаемая версия %1.").arg(version)), TITLE_IMPORT, "CResultReader::readBinary");
+
+   if (!(sections & eResultGeneration))
+      throw CException(INVALID_BINARY.arg("нет поколения."), TITLE_IMPORT, "CResultReader::readBinary");
+
+   size_t countVariables = m_storage.CountVariables();
+   if (sections & eResultVariables)
+   {
+      quint32 count = 0;
+      stream >> count;
+      checkRead(stream, "нет количества переменных.");
+
+      QString name;
+      for (quint32 iVar = 0; iVar < count; ++iVar)
+         stream >> name;
+
+      checkRead(stream, "не удалось считать имена переменных.");
+      countVariables = count;
+   }
+
+   // Индексы предикатов файла - индексы в текущем хранилище (без раздела предикатов - те же).
+   std::vector<size_t> vPredicates;
+   if (sections & eResultPredicates)
+   {
+      quint32 count = 0;
+      stream >> count;
+      checkRead(stream, "нет количества предикатов.");
+
+      QByteArray bits;
+      for (quint32 iPred = 0; iPred < count; ++iPred)
+      {
+         QString name;
+         quint8 countArg = 0;
+         stream >> name >> countArg;
+         checkRead(stream, QString("не удалось считать заголовок предиката %1.").arg(iPred));
+
+         const size_t idxPredicate = m_storage.GetIndexPredicate(name);
+         if (idxPredicate == SIZE_MAX || m_storage.CountArguments(idxPredicate) != countArg)
+            throw CException(QString("Предикат \"%1\" файла не совпадает с предикатами данных.").arg(name), TITLE_IMPORT, "CResultReader::readBinary");
+
+         vPredicates.push_back(idxPredicate);
+
+         // Таблица истинности пропускается.
+         size_t tableSize = 1;
+         for (quint8 iArg = 0; iArg < countArg; ++iArg)
+         {
+            if (countVariables == 0 || tableSize > SIZE_MAX / countVariables)
+               throw CException(INVALID_BINARY.arg(QString("слишком большая таблица истинности у предиката \"%1\".").arg(name)), TITLE_IMPORT, "CResultReader::readBinary");
+
+            tableSize *= countVariables;
+         }
+
+         const size_t countBytes = (tableSize + 7) / 8;
+         if (!device_->isSequential() && countBytes > static_cast<size_t>(device_->bytesAvailable()))
+            throw CException(INVALID_BINARY.arg(QString("таблица истинности предиката \"%1\" обрезана.").arg(name)), TITLE_IMPORT, "CResultReader::readBinary");
+
+         bits.resize(static_cast<qsizetype>(countBytes));
+         if (stream.readRawData(bits.data(), static_cast<int>(countBytes)) != static_cast<int>(countBytes))
+            throw CException(INVALID_BINARY.arg(QString("таблица истинности предиката \"%1\" обрезана.").arg(name)), TITLE_IMPORT, "CResultReader::readBinary");
+      }
+   }
+   else
+   {
+      for (size_t iPred = 0; iPred < m_storage.CountPredicates(); ++iPred)
+         vPredicates.push_back(iPred);
+   }
+
+   // Аргументы - переменные шаблона, их номера не больше количества переменных данных (maxArgument задает размеры подстановок).
+   const qint32 countDataVariables = static_cast<qint32>(std::min<size_t>(m_storage.CountVariables(), INT_MAX));
+
+   auto readPart = [&](TPartCondition& part_, quint16 size_)
+   {
+      for (quint16 iPred = 0; iPred < size_; ++iPred)
+      {
+         quint32 idxPredicate = 0;
+         quint8 countArg = 0;
+         stream >> idxPredicate >> countArg;
+         checkRead(stream, "не удалось считать предикат условия.");
+
+         if (idxPredicate >= vPredicates.size() || m_storage.CountArguments(vPredicates[idxPredicate]) != countArg)
+            throw CException(INVALID_BINARY.arg(QString("некорректный предикат %1 в условии.").arg(idxPredicate)), TITLE_IMPORT, "CResultReader::readBinary");
+
+         SPredicateTemplate predTempl;
+         predTempl.idxPredicate = vPredicates[idxPredicate];
+         predTempl.arguments.resize(countArg);
+         for (int& argument : predTempl.arguments)
+         {
+            qint32 value = 0;
+            stream >> value;
+            if (value < -1 || value >= countDataVariables)
+               throw CException(INVALID_BINARY.arg(QString("некорректный аргумент %1 в условии.").arg(value)), TITLE_IMPORT, "CResultReader::readBinary");
+
+            argument = value;
+         }
+
+         checkRead(stream, "не удалось считать аргументы предиката условия.");
+         part_.push_back(std::move(predTempl));
+      }
+   };
+
+   auto readCondition = [&]()
+   {
+      quint16 sizeLeft = 0, sizeRight = 0;
+      stream >> sizeLeft >> sizeRight;
+      checkRead(stream, "не удалось считать условие.");
+
+      SCondition condition;
+      readPart(condition.left, sizeLeft);
+      readPart(condition.right, sizeRight);
+      condition.RecalculateMaximum();
+      return condition;
+   };
+
+   if (sections & eResultIntegrityLimitation)
+   {
+      quint32 count = 0;
+      stream >> count;
+      checkRead(stream, "нет количества условий изначального ограничения.");
+
+      for (quint32 iCond = 0; iCond < count; ++iCond)
+      {
+         readCondition();
+         if (sections & eResultTrueCondition)
+         {
+            quint8 bTrue = 0;
+            stream >> bTrue;
+         }
+      }
+
+      checkRead(stream, "не удалось считать изначальное ограничение.");
+   }
+
+   quint32 countGeneration = 0;
+   stream >> countGeneration;
+   checkRead(stream, "нет количества особей.");
+
+   for (quint32 iGen = 0; iGen < countGeneration && vIndividuals_.size() < countIndividuals_; ++iGen)
+   {
+      if (sections & eResultFitness)
+      {
+         double fitness = 0;
+         stream >> fitness;
+      }
+
+      quint32 count = 0;
+      stream >> count;
+      checkRead(stream, QString("не удалось считать особь %1.").arg(iGen + 1));
+
+      if (count != countConditions_)
+         throw CException(QString("Особь %1: условий %2, а в изначальном ограничении %3.").arg(iGen + 1).arg(count).arg(countConditions_), TITLE_IMPORT, "CResultReader::readBinary");
+
+      TIndividual individual;
+      individual.reserve(count);
+      for (quint32 iCond = 0; iCond < count; ++iCond)
+         individual.push_back(readCondition());
+
+      vIndividuals_.push_back(std::move(individual));
+   }
+}
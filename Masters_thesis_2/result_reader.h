@@ -0,0 +1,39 @@
+#pragma once
+#include <vector>
+
+#include <QString>
+
+#include "parser_template_predicates.h"
+
+class QIODevice;
+class CPredicatesStorage;
+
+// Чтение особей поколения из файла результата (CResultWriter) для первого поколения следующего запуска.
+// Формат: двоичный - по сигнатуре, ".jsonl" - JSON lines, иначе текст (как StringCustom).
+// В тексте и JSON lines предикаты ищутся по имени, в двоичном - по имени, если записан раздел предикатов,
+// иначе по индексу. Номера аргументов сохраняются (буквенные обозначения, см. CParserTemplatePredicates::ParseNumbered)
+// и должны быть меньше количества переменных данных.
+class CResultReader
+{
+public:
+
+   using TIndividual = std::vector<SCondition>;
+
+   explicit CResultReader(const CPredicatesStorage& storage_);
+
+   // Считывает не больше countIndividuals_ первых особей из файла fileName_.
+   // Каждая особь должна состоять из countConditions_ условий.
+   // !> exception если не удалось открыть файл, при некорректных данных или другом количестве условий.
+   std::vector<TIndividual> Read(const QString& fileName_, size_t countConditions_, size_t countIndividuals_ = SIZE_MAX) const;
+
+private:
+
+   const CPredicatesStorage& m_storage;
+
+   void readText(QIODevice* device_, size_t countConditions_, size_t countIndividuals_, std::vector<TIndividual>& vIndividuals_) const;
+   void readJsonLines(QIODevice* device_, size_t countConditions_, size_t countIndividuals_, std::vector<TIndividual>& vIndividuals_) const;
+   void readBinary(QIODevice* device_, size_t countConditions_, size_t countIndividuals_, std::vector<TIndividual>& vIndividuals_) const;
+
+   // !> exception если номер аргумента условия condition_ не меньше количества переменных данных.
+   void checkArguments(const SCondition& condition_) const;
+};
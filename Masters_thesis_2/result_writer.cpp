@@ -0,0 +1,406 @@
+#include <algorithm>
+
+#include <QDataStream>
+#include <QFile>
+
+#include "result_writer.h"
+#include "genetic_algorithm.h"
+#include "exception.h"
+#include "global.h"
+
+#define SPLITTER "===================="
+
+// Возвращает строку в кавычках с экранированием для JSON.
+static QString jsonString(const QString& str_)
+{
+   QString result("\"");
+   result.reserve(str_.size() + 2);
+
+   for (QChar symb : str_)
+   {
+      switch (symb.unicode())
+      {
+      case '"':
+         result += "\\\"";
+         break;
+      case '\\':
+         result += "\\\\";
+         break;
+      case '\n':
+         result += "\\n";
+         break;
+      case '\r':
+         result += "\\r";
+         break;
+      case '\t':
+         result += "\\t";
+         break;
+      default:
+         if (symb.unicode() < 0x20)
+            result += QString("\\u%1").arg(symb.unicode(), 4, 16, QChar('0'));
+         else
+            result += symb;
+      }
+   }
+
+   return result.append('"');
+}
+
+// Возвращает часть условия в формате JSON: [{"predicate":индекс,"args":[...]}, ...].
+static QString jsonPart(const TPartCondition& part_)
+{
+   QString result("[");
+   for (const auto& predTempl : part_)
+   {
+      if (result.size() > 1)
+         result += ',';
+
+      result += QString("{\"predicate\":%1,\"args\":[").arg(predTempl.idxPredicate);
+      for (size_t iArg = 0; iArg < predTempl.arguments.size(); ++iArg)
+         result += QString(iArg == 0 ? "%1" : ",%1").arg(predTempl.arguments[iArg]);
+
+      result += "]}";
+   }
+
+   return result.append(']');
+}
+
+// Записывает часть условия в двоичном формате (без размера).
+static void writePart(QDataStream& stream_, const TPartCondition& part_)
+{
+   for (const auto& predTempl : part_)
+   {
+      stream_ << static_cast<quint32>(predTempl.idxPredicate) << static_cast<quint8>(predTempl.arguments.size());
+      for (int arg : predTempl.arguments)
+         stream_ << static_cast<qint32>(arg);
+   }
+}
+
+// Записывает условие в двоичном формате.
+static void writeCondition(QDataStream& stream_, const SCondition& condition_)
+{
+   stream_ << static_cast<quint16>(condition_.left.size()) << static_cast<quint16>(condition_.right.size());
+   writePart(stream_, condition_.left);
+   writePart(stream_, condition_.right);
+}
+
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-= Методы класса =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+CResultWriter::CResultWriter(const CGeneticAlgorithm& algorithm_)
+   : m_algorithm(algorithm_)
+{
+}
+
+CResultWriter::~CResultWriter() = default;
+
+CResultWriter::EFormat CResultWriter::FormatByFileName(const QString& fileName_)
+{
+   if (fileName_.endsWith(".jsonl", Qt::CaseInsensitive))
+      return eJsonLines;
+
+   if (fileName_.endsWith(".bin", Qt::CaseInsensitive))
+      return eBinary;
+
+   return eText;
+}
+
+void CResultWriter::Write(const QString& fileName_, quint8 sections_, size_t countIndividuals_)
+{
+   const EFormat format = FormatByFileName(fileName_);
+
+   QIODevice::OpenMode mode = QIODevice::WriteOnly | QIODevice::Truncate;
+   if (format == eText)
+      mode |= QIODevice::Text;
+
+   m_file = std::make_unique<QFile>(fileName_);
+   if (!m_file->open(mode))
+   {
+      m_file.reset();
+      throw CException("Не удалось открыть файл: " + fileName_, "Ошибка выгрузки данных", "CResultWriter::Write");
+   }
+
+   m_countWritten = 0;
+
+   try
+   {
+      switch (format)
+      {
+      case eJsonLines:
+         writeJsonLines(sections_, countIndividuals_);
+         break;
+      case eBinary:
+         writeBinary(sections_, countIndividuals_);
+         break;
+      default:
+         writeText(sections_, countIndividuals_);
+      }
+
+      if (!m_file->flush())
+         throw CException("Ошибка записи в файл: " + fileName_, "Ошибка выгрузки данных", "CResultWriter::Write");
+   }
+   catch (...)
+   {
+      m_file.reset();
+      throw;
+   }
+
+   m_file.reset();
+}
+
+void CResultWriter::writeText(quint8 sections_, size_t countIndividuals_)
+{
+   // Разделы и разделители те же, что и в CGeneticAlgorithm::StringCustom.
+   const CPredicatesStorage& storage = m_algorithm.GetStorage();
+   qint64 oldSize = 0;
+
+   if (sections_ & eResultVariables)
+      putText(storage.StringVariables());
+
+   if (sections_ & eResultPredicates)
+   {
+      if (oldSize < m_countWritten)
+      {
+         putText("\n\n");
+         oldSize = m_countWritten;
+      }
+
+      for (size_t iPred = 0; iPred < storage.CountPredicates(); ++iPred)
+      {
+         if (iPred > 0)
+            putText(DOUBLE_NEW_LINE);
+
+         putText(storage.StringPredicateWithTable(iPred));
+      }
+   }
+
+   if (sections_ & eResultIntegrityLimitation)
+   {
+      if (oldSize < m_countWritten)
+      {
+         putText("\n\n");
+         oldSize = m_countWritten;
+      }
+
+      if (m_countWritten != 0)
+      {
+         putText(SPLITTER "\n\n");
+         oldSize = m_countWritten;
+      }
+
+      const auto& original = m_algorithm.GetOriginal();
+      for (size_t iCond = 0; iCond < original.size(); ++iCond)
+      {
+         QString str = m_algorithm.StringCondition(original[iCond]);
+         if (sections_ & eResultTrueCondition)
+            str += m_algorithm.IsTrueCondition(original[iCond]) ? " (true)" : " (false)";
+
+         if (iCond > 0)
+            str.prepend(NEW_LINE);
+
+         putText(str);
+      }
+   }
+
+   if (sections_ & eResultGeneration)
+   {
+      if (oldSize < m_countWritten)
+         putText("\n\n" SPLITTER "\n\n");
+      else if (m_countWritten != 0 && !(sections_ & eResultIntegrityLimitation))
+         putText(SPLITTER "\n\n");
+
+      const std::shared_ptr<const SGenerationSnapshot> snapshot = m_algorithm.Snapshot();
+      if (!snapshot)
+         return;
+
+      const size_t count = std::min(countIndividuals_, snapshot->best.size());
+      for (size_t iGen = 0; iGen < count; ++iGen)
+      {
+         const auto& individual = snapshot->best[iGen];
+
+         // Пустая строка между особями ставится перед следующей особью, поэтому после последней ее нет.
+         QString str = iGen > 0 ? QString(NEW_LINE) : QString();
+         if (sections_ & eResultFitness)
+            str += QString("#%1 = %2%3").arg(iGen + 1).arg(individual.second).arg(NEW_LINE);
+
+         for (const auto& condition : individual.first)
+            str += m_algorithm.StringCondition(condition) + NEW_LINE;
+
+         putText(str);
+      }
+   }
+}
+
+void CResultWriter::writeJsonLines(quint8 sections_, size_t countIndividuals_)
+{
+   const CPredicatesStorage& storage = m_algorithm.GetStorage();
+   const std::shared_ptr<const SGenerationSnapshot> snapshot = m_algorithm.Snapshot();
+
+   put(QString("{\"type\":\"header\",\"version\":%1,\"generation\":%2,\"countIndividuals\":%3,\"seed\":%4}\n")
+      .arg(RESULT_BINARY_VERSION)
+      .arg(snapshot ? snapshot->generation : 0)
+      .arg(snapshot ? snapshot->countIndividuals : 0)
+      .arg(m_algorithm.GetSeed())
+      .toUtf8());
+
+   if (sections_ & eResultVariables)
+   {
+      const CSymbolTable& variables = storage.GetVariables();
+      for (size_t iVar = 0; iVar < variables.Size(); ++iVar)
+         put(QString("{\"type\":\"variable\",\"index\":%1,\"name\":%2}\n").arg(iVar).arg(jsonString(variables.Name(iVar).toString())).toUtf8());
+   }
+
+   if (sections_ & eResultPredicates)
+   {
+      const size_t countVariables = storage.CountVariables();
+      for (size_t iPred = 0; iPred < storage.CountPredicates(); ++iPred)
+      {
+         const SPredicate& predicate = storage.GetPredicate(iPred);
+
+         // Истинные значения - наборы индексов переменных.
+         QString values;
+         for (size_t iArg = 0; iArg < predicate.table.size(); ++iArg)
+         {
+            if (!predicate.table[iArg])
+               continue;
+
+            if (!values.isEmpty())
+               values += ',';
+
+            values += '[';
+            const std::vector<size_t> args = predicate.GetArgs(countVariables, iArg);
+            for (size_t i = 0; i < args.size(); ++i)
+               values += QString(i == 0 ? "%1" : ",%1").arg(args[i]);
+
+            values += ']';
+         }
+
+         // Одна подстановка всех аргументов: '%' в имени предиката не должен приниматься за место подстановки.
+         put(QString("{\"type\":\"predicate\",\"index\":%1,\"name\":%2,\"arity\":%3,\"true\":[%4]}\n")
+            .arg(QString::number(iPred), jsonString(storage.GetPredicateName(iPred)), QString::number(storage.CountArguments(iPred)), values)
+            .toUtf8());
+      }
+   }
+
+   if (sections_ & eResultIntegrityLimitation)
+   {
+      const auto& original = m_algorithm.GetOriginal();
+      for (size_t iCond = 0; iCond < original.size(); ++iCond)
+      {
+         QString line = QString("{\"type\":\"condition\",\"index\":%1,%2").arg(iCond).arg(jsonCondition(original[iCond]));
+         if (sections_ & eResultTrueCondition)
+            line += m_algorithm.IsTrueCondition(original[iCond]) ? ",\"true\":true" : ",\"true\":false";
+
+         put(line.append("}\n").toUtf8());
+      }
+   }
+
+   if ((sections_ & eResultGeneration) && snapshot)
+   {
+      const size_t count = std::min(countIndividuals_, snapshot->best.size());
+      for (size_t iGen = 0; iGen < count; ++iGen)
+      {
+         const auto& individual = snapshot->best[iGen];
+
+         QString line = QString("{\"type\":\"individual\",\"rank\":%1").arg(iGen + 1);
+         if (sections_ & eResultFitness)
+            line += QString(",\"fitness\":%1").arg(individual.second, 0, 'g', 17);
+
+         line += ",\"conditions\":[";
+         for (size_t iCond = 0; iCond < individual.first.size(); ++iCond)
+            line += QString(iCond == 0 ? "{%1}" : ",{%1}").arg(jsonCondition(individual.first[iCond]));
+
+         put(line.append("]}\n").toUtf8());
+      }
+   }
+}
+
+void CResultWriter::writeBinary(quint8 sections_, size_t countIndividuals_)
+{
+   const CPredicatesStorage& storage = m_algorithm.GetStorage();
+   const std::shared_ptr<const SGenerationSnapshot> snapshot = m_algorithm.Snapshot();
+
+   QDataStream stream(m_file.get());
+   stream.setByteOrder(QDataStream::LittleEndian);
+   stream.setVersion(QDataStream::Qt_6_0);
+
+   stream << RESULT_BINARY_MAGIC << RESULT_BINARY_VERSION << sections_;
+   stream << static_cast<quint32>(snapshot ? snapshot->generation : 0) << static_cast<quint32>(m_algorithm.GetSeed());
+
+   if (sections_ & eResultVariables)
+   {
+      const CSymbolTable& variables = storage.GetVariables();
+      stream << static_cast<quint32>(variables.Size());
+      for (size_t iVar = 0; iVar < variables.Size(); ++iVar)
+         stream << variables.Name(iVar).toString();
+   }
+
+   if (sections_ & eResultPredicates)
+   {
+      stream << static_cast<quint32>(storage.CountPredicates());
+
+      QByteArray bits;
+      for (size_t iPred = 0; iPred < storage.CountPredicates(); ++iPred)
+      {
+         const std::vector<bool>& table = storage.GetPredicate(iPred).table;
+
+         stream << storage.GetPredicateName(iPred) << static_cast<quint8>(storage.CountArguments(iPred));
+
+         bits.fill('\0', static_cast<qsizetype>((table.size() + 7) / 8));
+         for (size_t iArg = 0; iArg < table.size(); ++iArg)
+            if (table[iArg])
+               bits[iArg / 8] = static_cast<char>(bits[iArg / 8] | (1 << (iArg % 8)));
+
+         stream.writeRawData(bits.constData(), static_cast<int>(bits.size()));
+      }
+   }
+
+   if (sections_ & eResultIntegrityLimitation)
+   {
+      const auto& original = m_algorithm.GetOriginal();
+      stream << static_cast<quint32>(original.size());
+      for (const auto& condition : original)
+      {
+         writeCondition(stream, condition);
+         if (sections_ & eResultTrueCondition)
+            stream << static_cast<quint8>(m_algorithm.IsTrueCondition(condition) ? 1 : 0);
+      }
+   }
+
+   if (sections_ & eResultGeneration)
+   {
+      const size_t count = snapshot ? std::min(countIndividuals_, snapshot->best.size()) : 0;
+      stream << static_cast<quint32>(count);
+      for (size_t iGen = 0; iGen < count; ++iGen)
+      {
+         const auto& individual = snapshot->best[iGen];
+         if (sections_ & eResultFitness)
+            stream << individual.second;
+
+         stream << static_cast<quint32>(individual.first.size());
+         for (const auto& condition : individual.first)
+            writeCondition(stream, condition);
+      }
+   }
+
+   if (stream.status() != QDataStream::Ok)
+      throw CException("Ошибка записи двоичного файла результата.", "Ошибка выгрузки данных", "CResultWriter::writeBinary");
+}
+
+void CResultWriter::putText(const QString& text_)
+{
+   m_countWritten += text_.size();
+   put(text_.toLocal8Bit());
+}
+
+void CResultWriter::put(const QByteArray& data_)
+{
+   if (m_file->write(data_) != data_.size())
+      throw CException("Ошибка записи в файл: " + m_file->fileName(), "Ошибка выгрузки данных", "CResultWriter::put");
+}
+
+QString CResultWriter::jsonCondition(const SCondition& condition_) const
+{
+   // Одна подстановка всех аргументов: '%' в именах из текста условия не должен приниматься за место подстановки.
+   return QString("\"text\":%1,\"left\":%2,\"right\":%3")
+      .arg(jsonString(m_algorithm.StringCondition(condition_)), jsonPart(condition_.left), jsonPart(condition_.right));
+}
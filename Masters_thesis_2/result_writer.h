@@ -0,0 +1,88 @@
+#pragma once
+#include <memory>
+
+#include <QString>
+
+#include "parser_template_predicates.h"
+
+class QFile;
+class CGeneticAlgorithm;
+
+// Двоичный формат результата. Порядок байт - little-endian, строки - QDataStream (Qt_6_0).
+//
+// quint32 сигнатура (RESULT_BINARY_MAGIC), quint32 версия, quint8 флаги разделов (EResultSection)
+// quint32 номер поколения снимка, quint32 зерно
+// [переменные] quint32 количество, имена
+// [предикаты] quint32 количество, для каждого: имя, quint8 количество аргументов,
+//    таблица истинности по биту на значение (младший бит первый), размер - (N^M + 7) / 8 байт
+// [изначальное ограничение] quint32 количество условий, условия, [quint8 истинность условия]
+// [поколение] quint32 количество особей, для каждой: [double фитнес], quint32 количество условий, условия
+//
+// Условие: quint16 размер левой части, quint16 размер правой части, затем предикаты обеих частей:
+//    quint32 индекс предиката, quint8 количество аргументов, qint32 аргументы (-1 - любая переменная '~').
+
+// Сигнатура двоичного файла результата ("MT2R").
+constexpr quint32 RESULT_BINARY_MAGIC = 0x5232544D;
+constexpr quint32 RESULT_BINARY_VERSION = 1;
+
+// Разделы результата (флаги).
+enum EResultSection : quint8
+{
+   eResultVariables = 1 << 0,
+   eResultPredicates = 1 << 1,
+   eResultIntegrityLimitation = 1 << 2,
+   eResultGeneration = 1 << 3,
+   eResultFitness = 1 << 4,
+   eResultTrueCondition = 1 << 5
+};
+
+// Потоковая запись результата алгоритма в файл.
+// Каждый раздел и каждая особь форматируются и сразу записываются в файл (запись буферизуется QFile),
+// поэтому весь отчет в памяти не собирается.
+// Формат определяется по расширению: ".jsonl" - JSON lines (по объекту на строку), ".bin" - двоичный,
+// иначе текст (как StringCustom).
+// Поколение берется из последнего опубликованного снимка алгоритма.
+class CResultWriter
+{
+public:
+
+   enum EFormat
+   {
+      eText,
+      eJsonLines,
+      eBinary
+   };
+
+   explicit CResultWriter(const CGeneticAlgorithm& algorithm_);
+   ~CResultWriter();
+
+   // Возвращает формат по расширению файла.
+   static EFormat FormatByFileName(const QString& fileName_);
+
+   // Записывает разделы sections_ (флаги EResultSection) в файл fileName_ (перезаписывает существующий).
+   // countIndividuals_ - количество первых особей поколения.
+   // !> exception если не удалось открыть файл или при ошибке записи.
+   void Write(const QString& fileName_, quint8 sections_, size_t countIndividuals_ = SIZE_MAX);
+
+private:
+
+   const CGeneticAlgorithm& m_algorithm;
+
+   std::unique_ptr<QFile> m_file;
+   qint64 m_countWritten = 0; // количество записанных символов (для разделителей текстового формата)
+
+   void writeText(quint8 sections_, size_t countIndividuals_);
+   void writeJsonLines(quint8 sections_, size_t countIndividuals_);
+   void writeBinary(quint8 sections_, size_t countIndividuals_);
+
+   // Записывает текст в локальной кодировке (как прежняя запись отчета).
+   // !> exception при ошибке записи.
+   void putText(const QString& text_);
+
+   // Записывает данные в файл.
+   // !> exception при ошибке записи.
+   void put(const QByteArray& data_);
+
+   // Возвращает условие в формате JSON (текст и части условия).
+   QString jsonCondition(const SCondition& condition_) const;
+};
@@ -0,0 +1,54 @@
+#pragma once
+#include <QString>
+
+// Параметры одного запуска алгоритма (CGeneticAlgorithm::Start).
+// Значения по умолчанию совпадают со значениями в окне программы.
+struct SRunSettings
+{
+   quint32 seed = 0; // зерно генератора случайных чисел
+   int countIndividuals = 100;
+   int countIterations = 100;
+   double percentMutationArguments = 10;
+   int countSkipMutationArg = 5;
+   double percentMutationPredicates = 0;
+   int countSkipMutationPred = 0;
+   double percentIndividualsUndergoingMutation = 25;
+   double limitOfArgumentsChange = 0.75; // нижняя граница цены измененных аргументов
+   double costAddingPredicate = 0.2;     // цена добавления предиката
+   int countLocalSearch = 0;             // количество лучших особей для локального поиска (0 - без него)
+};
+
+// Создание первого поколения (CGeneticAlgorithm::SetInitialization).
+// Сначала в поколение попадают особи из файла результата importFile (не больше количества особей),
+// затем percentSeeded процентов оставшихся мест занимают копии изначального ограничения, в каждом условии
+// которых сделано от minEdits до maxEdits случайных правок (замена аргумента, удаление или добавление предиката).
+// Остальные особи - случайные. По умолчанию все особи случайные.
+struct SInitialization
+{
+   double percentSeeded = 0; // процент копий изначального ограничения с правками [0; 100]
+   int minEdits = 1;         // наименьшее количество правок одного условия копии
+   int maxEdits = 3;         // наибольшее количество правок одного условия копии
+   QString importFile;       // файл результата предыдущего запуска (пусто - без импорта)
+};
+
+// Итог одного запуска портфеля (CGeneticAlgorithm::StartPortfolio).
+struct SPortfolioRun
+{
+   SRunSettings settings;
+   double bestFitness = 0;
+   quint64 countFitnessEvaluations = 0; // количество вычислений фитнеса
+   qint64 runTime = 0;                  // время работы запуска (мс)
+   bool bInterrupted = false; // запуск остановлен (запросом или по времени)
+   bool bHasGeneration = false; // есть вычисленное поколение (иначе bestFitness не определен)
+   QString error;             // сообщение об ошибке (пусто - без ошибок)
+};
+
+// Итог точного поиска исправления одного условия (CGeneticAlgorithm::StartExact).
+struct SExactRepair
+{
+   double fitness = 0;       // фитнес лучшего найденного условия (FC)
+   int countEdits = 0;       // количество правок изначального условия в лучшем условии
+   size_t countCandidates = 0; // количество различных условий-кандидатов
+   size_t countChecked = 0;    // из них проверено на истинность
+   bool bComplete = false;     // перебраны все условия на расстоянии правок (лучшее доказано)
+};
@@ -0,0 +1,106 @@
+#include <QHashFunctions>
+
+#include "symbol_table.h"
+
+// Пустая ячейка хеш-таблицы.
+constexpr size_t EMPTY_SLOT = SIZE_MAX;
+
+// Минимальное количество ячеек хеш-таблицы.
+constexpr size_t MIN_COUNT_SLOTS = 16;
+
+size_t CSymbolTable::Insert(QStringView name_)
+{
+   const size_t hash = qHash(name_);
+
+   if (!m_vSlots.empty())
+   {
+      const size_t id = m_vSlots[findSlot(name_, hash)];
+      if (id != EMPTY_SLOT)
+         return id;
+   }
+
+   // Таблица заполнена не более чем наполовину.
+   if ((m_vSymbols.size() + 1) * 2 > m_vSlots.size())
+      rehash(qMax(MIN_COUNT_SLOTS, m_vSlots.size() * 2));
+
+   const size_t id = m_vSymbols.size();
+   m_vSlots[findSlot(name_, hash)] = id;
+   m_vSymbols.push_back({ m_arena.size(), name_.size(), hash });
+   m_arena.append(name_);
+
+   return id;
+}
+
+size_t CSymbolTable::Find(QStringView name_) const
+{
+   if (m_vSlots.empty())
+      return SIZE_MAX;
+
+   return m_vSlots[findSlot(name_, qHash(name_))];
+}
+
+QStringView CSymbolTable::Name(size_t id_) const
+{
+   const SSymbol& symbol = m_vSymbols.at(id_);
+   return QStringView(m_arena).mid(symbol.offset, symbol.length);
+}
+
+size_t CSymbolTable::Size() const
+{
+   return m_vSymbols.size();
+}
+
+bool CSymbolTable::IsEmpty() const
+{
+   return m_vSymbols.empty();
+}
+
+void CSymbolTable::Reserve(size_t count_)
+{
+   m_vSymbols.reserve(count_);
+
+   size_t countSlots = qMax(MIN_COUNT_SLOTS, m_vSlots.size());
+   while (countSlots < count_ * 2)
+      countSlots *= 2;
+
+   if (countSlots != m_vSlots.size())
+      rehash(countSlots);
+}
+
+void CSymbolTable::Clear()
+{
+   m_arena.clear();
+   m_vSymbols.clear();
+   m_vSlots.clear();
+}
+
+size_t CSymbolTable::findSlot(QStringView name_, size_t hash_) const
+{
+   const size_t mask = m_vSlots.size() - 1;
+
+   for (size_t slot = hash_ & mask; ; slot = (slot + 1) & mask)
+   {
+      const size_t id = m_vSlots[slot];
+      if (id == EMPTY_SLOT)
+         return slot;
+
+      const SSymbol& symbol = m_vSymbols[id];
+      if (symbol.hash == hash_ && QStringView(m_arena).mid(symbol.offset, symbol.length) == name_)
+         return slot;
+   }
+}
+
+void CSymbolTable::rehash(size_t countSlots_)
+{
+   m_vSlots.assign(countSlots_, EMPTY_SLOT);
+
+   const size_t mask = countSlots_ - 1;
+   for (size_t id = 0; id < m_vSymbols.size(); ++id)
+   {
+      size_t slot = m_vSymbols[id].hash & mask;
+      while (m_vSlots[slot] != EMPTY_SLOT)
+         slot = (slot + 1) & mask;
+
+      m_vSlots[slot] = id;
+   }
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <vector>
+
+#include <QString>
+#include <QStringView>
+
+// Таблица имен.
+// Каждому уникальному имени сопоставляется плотный идентификатор (0, 1, 2, ... в порядке добавления).
+// Символы всех имен хранятся один раз в общем буфере, поиск - хеш-таблица с открытой адресацией
+// (линейное пробирование), поэтому поиск по QStringView не выделяет память.
+class CSymbolTable
+{
+   // Имя в буфере.
+   struct SSymbol
+   {
+      qsizetype offset = 0; // начало в m_arena
+      qsizetype length = 0; // длина
+      size_t hash = 0;      // хеш имени
+   };
+
+   QString m_arena;                 // символы всех имен подряд
+   std::vector<SSymbol> m_vSymbols; // имена по идентификаторам
+   std::vector<size_t> m_vSlots;    // хеш-таблица: идентификатор имени или SIZE_MAX (пустая ячейка)
+
+public:
+
+   // Добавляет имя, если его еще нет.
+   // Возвращает идентификатор имени.
+   size_t Insert(QStringView name_);
+
+   // Возвращает идентификатор имени.
+   // Если такого имени нет - вернет SIZE_MAX.
+   size_t Find(QStringView name_) const;
+
+   // Возвращает имя по идентификатору. Действительно до следующего добавления.
+   // !> exception std::out_of_range если идентификатор невалиден.
+   QStringView Name(size_t id_) const;
+
+   // Возвращает количество имен.
+   size_t Size() const;
+
+   // Возвращает true, если нет ни одного имени.
+   bool IsEmpty() const;
+
+   // Резервирует память под count_ имен.
+   void Reserve(size_t count_);
+
+   void Clear();
+
+private:
+
+   // Возвращает индекс ячейки с именем name_, если его нет - индекс пустой ячейки, куда его можно добавить.
+   size_t findSlot(QStringView name_, size_t hash_) const;
+
+   // Перестраивает хеш-таблицу с количеством ячеек countSlots_ (степень двойки).
+   void rehash(size_t countSlots_);
+};
@@ -0,0 +1,150 @@
+#include <QIODevice>
+
+#include "text_reader.h"
+#include "global.h"
+
+CTextReader::CTextReader(QIODevice* device_, qint64 chunkSize_) :
+   m_device(device_), m_chunkSize(chunkSize_ > 0 ? chunkSize_ : DEFAULT_CHUNK_SIZE), m_decoder(QStringDecoder::Utf8)
+{
+}
+
+CTextReader::CTextReader(QStringView text_, const STextPosition& start_) :
+   m_text(text_), m_position(start_)
+{
+}
+
+QChar CTextReader::Peek(qsizetype offset_)
+{
+   if (!ensure(offset_ + 1))
+      return QChar();
+
+   return m_text.at(m_index + offset_);
+}
+
+QChar CTextReader::Get()
+{
+   if (!ensure(1))
+      return QChar();
+
+   const QChar symb = m_text.at(m_index++);
+
+   if (symb == '\n')
+   {
+      ++m_position.line;
+      m_position.column = 1;
+   }
+   else
+   {
+      ++m_position.column;
+   }
+
+   return symb;
+}
+
+bool CTextReader::AtEnd()
+{
+   return !ensure(1);
+}
+
+bool CTextReader::AtEndOfSection()
+{
+   return !ensure(1) || m_text.at(m_index) == SYMBOL_SECTION_SEPARATOR;
+}
+
+bool CTextReader::SkipSpace()
+{
+   while (ensure(1) && m_text.at(m_index).isSpace())
+      Get();
+
+   return AtEndOfSection();
+}
+
+void CTextReader::SkipSpace(QChar skipSymbol_)
+{
+   if (!SkipSpace())
+      HasSymbol(skipSymbol_);
+}
+
+bool CTextReader::HasSymbol(QChar symbol_)
+{
+   if (ensure(1) && m_text.at(m_index) == symbol_)
+   {
+      Get();
+      return true;
+   }
+
+   return false;
+}
+
+QStringView CTextReader::ReadName(bool (*isIllegalSymbol_)(QChar))
+{
+   qsizetype length = 0;
+
+   while (ensure(length + 1))
+   {
+      const QChar symb = m_text.at(m_index + length);
+      if (symb.isSpace() || symb == SYMBOL_SECTION_SEPARATOR || isIllegalSymbol_(symb))
+         break;
+
+      ++length;
+   }
+
+   // Имя не содержит переводов строки, поэтому меняется только столбец.
+   const QStringView name = m_text.mid(m_index, length);
+   m_index += length;
+   m_position.column += length;
+
+   return name;
+}
+
+bool CTextReader::NextSection()
+{
+   while (!AtEndOfSection())
+      Get();
+
+   return HasSymbol(SYMBOL_SECTION_SEPARATOR);
+}
+
+const STextPosition& CTextReader::Position() const
+{
+   return m_position;
+}
+
+QString CTextReader::Message(const QString& message_) const
+{
+   return Message(message_, m_position);
+}
+
+QString CTextReader::Message(const QString& message_, const STextPosition& position_)
+{
+   return message_ + NEW_LINE + QString("Строка %1, столбец %2.").arg(position_.line).arg(position_.column);
+}
+
+bool CTextReader::ensure(qsizetype count_)
+{
+   while (m_index + count_ > m_text.size())
+   {
+      if (!m_device)
+         return false;
+
+      // Отбрасываем уже разобранную часть текста, чтобы буфер не рос вместе с файлом.
+      if (m_index > 0)
+      {
+         m_buffer.remove(0, m_index);
+         m_index = 0;
+      }
+
+      const QByteArray chunk = m_device->read(m_chunkSize);
+      if (chunk.isEmpty())
+      {
+         m_text = m_buffer;
+         return false;
+      }
+
+      const QString decoded = m_decoder.decode(chunk);
+      m_buffer.append(decoded);
+      m_text = m_buffer;
+   }
+
+   return true;
+}
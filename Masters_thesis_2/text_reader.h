@@ -0,0 +1,98 @@
+#pragma once
+#include <QString>
+#include <QStringView>
+#include <QStringDecoder>
+
+class QIODevice;
+
+// Символ разделения разделов файла данных (переменные $ предикаты $ ограничения).
+constexpr const char SYMBOL_SECTION_SEPARATOR = '$';
+
+// Позиция в тексте (нумерация с 1).
+struct STextPosition
+{
+   qsizetype line = 1;   // строка
+   qsizetype column = 1; // столбец
+};
+
+// Потоковое чтение текста.
+// Устройство читается блоками фиксированного размера, в памяти хранится только
+// еще не разобранный остаток текста. Ведется учет строки и столбца для сообщений об ошибках.
+//
+// Раздел - часть текста до символа SYMBOL_SECTION_SEPARATOR (или до конца текста).
+// Все функции чтения не выходят за пределы текущего раздела, переход к следующему - NextSection().
+//
+// QStringView, которые возвращают функции чтения, действительны до следующего вызова любой функции читателя.
+class CTextReader
+{
+   QIODevice* m_device = nullptr;
+   qint64 m_chunkSize = 0;
+   QStringDecoder m_decoder;
+   QString m_buffer;
+
+   QStringView m_text;   // доступный текст (m_buffer или внешняя строка)
+   qsizetype m_index = 0; // индекс текущего символа в m_text
+   STextPosition m_position;
+
+public:
+   // Размер блока чтения по умолчанию (в байтах).
+   static constexpr qint64 DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+   // Чтение из открытого на чтение устройства device_ (текст в кодировке UTF-8).
+   explicit CTextReader(QIODevice* device_, qint64 chunkSize_ = DEFAULT_CHUNK_SIZE);
+
+   // Чтение из строки text_. Строка должна существовать все время работы читателя.
+   // start_ - позиция начала строки в исходном тексте (для сообщений об ошибках).
+   explicit CTextReader(QStringView text_, const STextPosition& start_ = STextPosition());
+
+   CTextReader(const CTextReader&) = delete;
+   CTextReader& operator=(const CTextReader&) = delete;
+
+   // Возвращает символ со смещением offset_ от текущего, не сдвигая позицию.
+   // Если текст закончился возвращает нулевой символ.
+   QChar Peek(qsizetype offset_ = 0);
+
+   // Возвращает текущий символ и переходит к следующему.
+   // Если текст закончился возвращает нулевой символ.
+   QChar Get();
+
+   // Возвращает true, если достигнут конец текста.
+   bool AtEnd();
+
+   // Возвращает true, если достигнут конец раздела (или конец текста).
+   bool AtEndOfSection();
+
+   // Пропускает все пробельные символы.
+   // Возвращает true, если был достигнут конец раздела.
+   bool SkipSpace();
+
+   // Пропускает все пробельные символы, затем пропускает, если есть, символ skipSymbol_.
+   void SkipSpace(QChar skipSymbol_);
+
+   // Возвращает true и переходит к следующему символу, если текущий символ - symbol_, иначе false.
+   bool HasSymbol(QChar symbol_);
+
+   // Выделяет имя.
+   // Имя заканчивается пробельным символом, символом для которого isIllegalSymbol_ вернет true или концом раздела.
+   // Позиция будет указывать на следующий символ, после имени.
+   QStringView ReadName(bool (*isIllegalSymbol_)(QChar));
+
+   // Пропускает остаток текущего раздела и разделитель.
+   // Возвращает false, если следующего раздела нет.
+   bool NextSection();
+
+   // Возвращает позицию текущего символа.
+   const STextPosition& Position() const;
+
+   // Возвращает сообщение message_ дополненное текущей позицией в тексте.
+   QString Message(const QString& message_) const;
+
+   // Возвращает сообщение message_ дополненное позицией position_ в тексте.
+   static QString Message(const QString& message_, const STextPosition& position_);
+
+private:
+
+   // Проверяет, что доступно count_ символов начиная с текущего, при необходимости читает следующие блоки.
+   // Возвращает false, если текст закончился раньше.
+   bool ensure(qsizetype count_);
+};
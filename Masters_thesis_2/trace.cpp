@@ -0,0 +1,88 @@
+#include <algorithm>
+
+#include <QFile>
+
+#include "trace.h"
+#include "exception.h"
+
+CTrace::CTrace() = default;
+
+CTrace::~CTrace()
+{
+   Close();
+}
+
+void CTrace::Open(const QString& fileName_)
+{
+   Close();
+
+   m_file = std::make_unique<QFile>(fileName_);
+   if (!m_file->open(QIODevice::WriteOnly | QIODevice::Truncate))
+   {
+      m_file.reset();
+      throw CException("Не удалось открыть файл трассировки: " + fileName_, "Ошибка записи трассировки", "CTrace::Open");
+   }
+
+   m_vThreads.clear();
+   m_bFirstEvent = true;
+   m_file->write("[\n");
+   m_timer.start();
+}
+
+void CTrace::Close()
+{
+   std::lock_guard<std::mutex> lock(m_mutex);
+   if (!m_file)
+      return;
+
+   m_file->write("\n]\n");
+   m_file.reset();
+}
+
+qint64 CTrace::Now() const
+{
+   return m_timer.nsecsElapsed();
+}
+
+void CTrace::Complete(const char* name_, qint64 start_, qint64 duration_, const STraceArg* args_, size_t countArgs_)
+{
+   // Время в формате trace_event - в микросекундах.
+   QString event = QString("{\"name\":\"%1\",\"cat\":\"ga\",\"ph\":\"X\",\"ts\":%2,\"dur\":%3,\"pid\":1,\"tid\":%4")
+      .arg(name_)
+      .arg(start_ / 1000.0, 0, 'f', 3)
+      .arg(duration_ / 1000.0, 0, 'f', 3);
+
+   std::lock_guard<std::mutex> lock(m_mutex);
+   if (!m_file)
+      return;
+
+   event = event.arg(threadNumber());
+
+   if (countArgs_ > 0)
+   {
+      event += ",\"args\":{";
+      for (size_t iArg = 0; iArg < countArgs_; ++iArg)
+         event += QString("%1\"%2\":%3").arg(iArg == 0 ? "" : ",").arg(args_[iArg].name).arg(args_[iArg].value);
+
+      event += "}";
+   }
+
+   event += "}";
+
+   if (!m_bFirstEvent)
+      m_file->write(",\n");
+
+   m_bFirstEvent = false;
+   m_file->write(event.toUtf8());
+}
+
+size_t CTrace::threadNumber()
+{
+   const std::thread::id thread = std::this_thread::get_id();
+   auto it = std::find(m_vThreads.begin(), m_vThreads.end(), thread);
+   if (it != m_vThreads.end())
+      return static_cast<size_t>(it - m_vThreads.begin());
+
+   m_vThreads.push_back(thread);
+   return m_vThreads.size() - 1;
+}
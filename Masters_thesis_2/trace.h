@@ -0,0 +1,93 @@
+#pragma once
+#include <array>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <QElapsedTimer>
+#include <QString>
+
+class QFile;
+
+// Числовой аргумент события.
+struct STraceArg
+{
+   const char* name = nullptr;
+   qint64 value = 0;
+};
+
+// Запись событий в формате Chrome trace_event (JSON массив из событий "X"),
+// файл открывается в Perfetto (ui.perfetto.dev) и chrome://tracing.
+// События пишутся в файл по мере поступления, запись из нескольких потоков безопасна.
+class CTrace
+{
+   std::unique_ptr<QFile> m_file;
+   QElapsedTimer m_timer;
+
+   std::mutex m_mutex;
+   std::vector<std::thread::id> m_vThreads; // номер потока в файле - индекс
+   bool m_bFirstEvent = true;
+
+public:
+
+   CTrace();
+   ~CTrace();
+
+   // Открывает файл fileName_ (перезаписывает существующий), время событий отсчитывается от открытия.
+   // !> exception если не удалось открыть файл.
+   void Open(const QString& fileName_);
+
+   // Завершает JSON массив и закрывает файл.
+   void Close();
+
+   // Возвращает время от открытия (нс).
+   qint64 Now() const;
+
+   // Записывает событие name_ длительностью duration_ (нс), начавшееся в start_ (нс от открытия).
+   void Complete(const char* name_, qint64 start_, qint64 duration_, const STraceArg* args_, size_t countArgs_);
+
+private:
+
+   // Возвращает номер текущего потока. Вызывается под m_mutex.
+   size_t threadNumber();
+};
+
+// Событие на время жизни объекта.
+// Если trace_ == nullptr (трассировка выключена), то ничего не делает и не замеряет время.
+class CTraceScope
+{
+   CTrace* m_trace;
+   const char* m_name;
+   qint64 m_start = 0;
+
+   std::array<STraceArg, 2> m_args;
+   size_t m_countArgs = 0;
+
+public:
+
+   CTraceScope(CTrace* trace_, const char* name_)
+      : m_trace(trace_), m_name(name_)
+   {
+      if (m_trace)
+         m_start = m_trace->Now();
+   }
+
+   CTraceScope(const CTraceScope&) = delete;
+   CTraceScope& operator=(const CTraceScope&) = delete;
+
+   ~CTraceScope()
+   {
+      if (m_trace)
+         m_trace->Complete(m_name, m_start, m_trace->Now() - m_start, m_args.data(), m_countArgs);
+   }
+
+   // Добавляет аргумент события (не более двух, лишние игнорируются).
+   CTraceScope& Arg(const char* name_, qint64 value_)
+   {
+      if (m_trace && m_countArgs < m_args.size())
+         m_args[m_countArgs++] = { name_, value_ };
+
+      return *this;
+   }
+};
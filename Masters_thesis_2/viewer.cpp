@@ -1,18 +1,19 @@
 #include "viewer.h"
 #include "ui_viewer.h"
+#include "result_model.h"
 
 CViewer::CViewer(QWidget* parent_, const CGeneticAlgorithm* algorithm_) :
    QWidget(parent_), m_algorithm(algorithm_), ui(new Ui::Viewer())
 {
    ui->setupUi(this);
-   UpdateText();
-   connect(ui->cbVariables, &QCheckBox::checkStateChanged, this, &CViewer::UpdateText);
-   connect(ui->cbPredicates, &QCheckBox::checkStateChanged, this, &CViewer::UpdateText);
-   connect(ui->cbIntegrityLimitation, &QCheckBox::checkStateChanged, this, &CViewer::UpdateText);
-   connect(ui->cbGeneration, &QCheckBox::checkStateChanged, this, &CViewer::UpdateText);
-   connect(ui->cbFitness, &QCheckBox::checkStateChanged, this, &CViewer::UpdateText);
-   connect(ui->chTrueCondition, &QCheckBox::checkStateChanged, this, &CViewer::UpdateText);
-   connect(ui->sbCountGeneration, &QSpinBox::valueChanged, this, &CViewer::UpdateText);
+   SetAlgorithm(algorithm_);
+   connect(ui->cbVariables, &QCheckBox::checkStateChanged, this, &CViewer::updateVisibility);
+   connect(ui->cbPredicates, &QCheckBox::checkStateChanged, this, &CViewer::updateVisibility);
+   connect(ui->cbIntegrityLimitation, &QCheckBox::checkStateChanged, this, &CViewer::updateVisibility);
+   connect(ui->cbGeneration, &QCheckBox::checkStateChanged, this, &CViewer::updateVisibility);
+   connect(ui->cbFitness, &QCheckBox::checkStateChanged, this, &CViewer::updateVisibility);
+   connect(ui->chTrueCondition, &QCheckBox::checkStateChanged, this, &CViewer::updateVisibility);
+   connect(ui->sbCountGeneration, &QSpinBox::valueChanged, this, [this](int value_) { m_model->SetCountIndividuals(value_); });
 }
 
 CViewer::~CViewer()
@@ -23,18 +24,34 @@ CViewer::~CViewer()
 void CViewer::SetAlgorithm(const CGeneticAlgorithm* algorithm)
 {
    m_algorithm = algorithm;
+
+   // Модель формирует строки только для видимой части дерева, поэтому окно не зависит от размера данных.
+   CResultModel* model = new CResultModel(m_algorithm, this);
+   model->SetCountIndividuals(ui->sbCountGeneration->value());
+   ui->tvResult->setModel(model);
+
+   delete m_model;
+   m_model = model;
+   updateVisibility();
+}
+
+void CViewer::UpdateData()
+{
+   m_model->UpdateData();
+   updateVisibility();
+}
+
+void CViewer::UpdateGeneration()
+{
+   m_model->UpdateGeneration();
 }
 
-void CViewer::UpdateText() const
+void CViewer::updateVisibility()
 {
-   if (m_algorithm)
-      ui->textBrowser->setText(m_algorithm->StringCustom(
-         ui->cbVariables->isChecked(),
-         ui->cbPredicates->isChecked(),
-         ui->cbIntegrityLimitation->isChecked(),
-         ui->cbGeneration->isChecked(),
-         ui->cbFitness->isChecked(),
-         ui->chTrueCondition->isChecked(),
-         ui->sbCountGeneration->value()
-      ));
+   ui->tvResult->setRowHidden(CResultModel::eVariables, QModelIndex(), !ui->cbVariables->isChecked());
+   ui->tvResult->setRowHidden(CResultModel::ePredicates, QModelIndex(), !ui->cbPredicates->isChecked());
+   ui->tvResult->setRowHidden(CResultModel::eIntegrityLimitation, QModelIndex(), !ui->cbIntegrityLimitation->isChecked());
+   ui->tvResult->setRowHidden(CResultModel::eGeneration, QModelIndex(), !ui->cbGeneration->isChecked());
+   ui->tvResult->setColumnHidden(CResultModel::eColumnFitness, !ui->cbFitness->isChecked());
+   ui->tvResult->setColumnHidden(CResultModel::eColumnTrue, !ui->chTrueCondition->isChecked());
 }
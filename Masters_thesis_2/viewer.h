@@ -4,6 +4,8 @@
 
 namespace Ui { class Viewer; }
 
+class CResultModel;
+
 class CViewer : public QWidget
 {
    Q_OBJECT
@@ -13,9 +15,18 @@ public:
    ~CViewer();
 
    void SetAlgorithm(const CGeneticAlgorithm* algorithm);
-   void UpdateText() const;
+
+   // Перечитывает все данные алгоритма (после загрузки данных).
+   void UpdateData();
+
+   // Перечитывает последнее поколение (снимок алгоритма).
+   void UpdateGeneration();
 
 private:
    Ui::Viewer* ui = nullptr;
    const CGeneticAlgorithm* m_algorithm;
+   CResultModel* m_model = nullptr;
+
+   // Скрывает разделы и столбцы по флажкам.
+   void updateVisibility();
 };
\ No newline at end of file
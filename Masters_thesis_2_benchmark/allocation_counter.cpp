@@ -0,0 +1,49 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "allocation_counter.h"
+
+// Замена глобальных operator new/delete для подсчета выделений памяти.
+
+static std::atomic<size_t> s_countAllocations = 0;
+
+size_t CountAllocations()
+{
+   return s_countAllocations.load(std::memory_order_relaxed);
+}
+
+void* operator new(size_t size_)
+{
+   s_countAllocations.fetch_add(1, std::memory_order_relaxed);
+
+   if (void* ptr = std::malloc(size_ ? size_ : 1))
+      return ptr;
+
+   throw std::bad_alloc();
+}
+
+void* operator new[](size_t size_)
+{
+   return operator new(size_);
+}
+
+void operator delete(void* ptr_) noexcept
+{
+   std::free(ptr_);
+}
+
+void operator delete[](void* ptr_) noexcept
+{
+   std::free(ptr_);
+}
+
+void operator delete(void* ptr_, size_t) noexcept
+{
+   std::free(ptr_);
+}
+
+void operator delete[](void* ptr_, size_t) noexcept
+{
+   std::free(ptr_);
+}
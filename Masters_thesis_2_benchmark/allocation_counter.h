@@ -0,0 +1,6 @@
+#pragma once
+#include <cstddef>
+
+// Возвращает количество выделений динамической памяти с начала работы программы.
+// Считаются все вызовы глобального operator new (во всех потоках).
+size_t CountAllocations();
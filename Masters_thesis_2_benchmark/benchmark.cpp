@@ -0,0 +1,415 @@
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+
+#include "benchmark.h"
+#include "allocation_counter.h"
+#include "genetic_algorithm.h"
+#include "batch_evaluator.h"
+#include "counter.h"
+#include "exception.h"
+#include "random.h"
+
+// Количество особей (мутантов исходного ограничения) для замеров фитнеса и операторов.
+constexpr size_t COUNT_INDIVIDUALS = 32;
+
+// Максимальное количество повторов операции в одном замере.
+constexpr size_t MAX_ITERATIONS = size_t(1) << 30;
+
+// Результаты операций складываются сюда, чтобы компилятор не выбросил вычисления.
+static volatile size_t s_sink = 0;
+
+template<class T>
+static void keep(const T& value_)
+{
+   s_sink = s_sink + static_cast<size_t>(value_);
+}
+
+// Возвращает литерал предиката idxPredicate_ с arity_ аргументами.
+// Сначала используются еще не встречавшиеся переменные шаблона (по порядку), затем случайные.
+static SPredicateTemplate makeLiteral(size_t idxPredicate_, size_t arity_, int countTemplateVariables_, int& nextArgument_, CRandom& rand_)
+{
+   SPredicateTemplate predTempl;
+   predTempl.idxPredicate = idxPredicate_;
+   predTempl.arguments.resize(arity_);
+
+   for (int& arg : predTempl.arguments)
+      arg = nextArgument_ < countTemplateVariables_ ? nextArgument_++ : static_cast<int>(rand_.Generate(0, countTemplateVariables_ - 1));
+
+   return predTempl;
+}
+
+// Возвращает условие вида P(..) P(..) -> P(..) T(..), где T - всегда истинный предикат с индексом idxAlwaysTrue_.
+// В условии используются все переменные шаблона, при bAnyArgument в левую часть добавляется литерал с '~'.
+static SCondition makeCondition(const SBenchmarkCase& case_, size_t idxAlwaysTrue_, CRandom& rand_)
+{
+   const int countTemplate = static_cast<int>(case_.countTemplateVariables);
+   const size_t idxLastPredicate = case_.countPredicates - 1;
+   int nextArgument = 0;
+
+   SCondition cond;
+   cond.left.push_back(makeLiteral(rand_.Generate(0, idxLastPredicate), case_.arity, countTemplate, nextArgument, rand_));
+   cond.left.push_back(makeLiteral(rand_.Generate(0, idxLastPredicate), case_.arity, countTemplate, nextArgument, rand_));
+   cond.right.push_back(makeLiteral(rand_.Generate(0, idxLastPredicate), case_.arity, countTemplate, nextArgument, rand_));
+   cond.right.push_back(makeLiteral(idxAlwaysTrue_, case_.arity, countTemplate, nextArgument, rand_));
+
+   while (nextArgument < countTemplate)
+      cond.left.push_back(makeLiteral(rand_.Generate(0, idxLastPredicate), case_.arity, countTemplate, nextArgument, rand_));
+
+   if (case_.bAnyArgument && case_.arity > 1)
+   {
+      cond.left.push_back(makeLiteral(rand_.Generate(0, idxLastPredicate), case_.arity, countTemplate, nextArgument, rand_));
+      cond.left.back().arguments.back() = -1;
+   }
+
+   cond.RecalculateMaximum();
+   return cond;
+}
+
+// Возвращает список через запятую.
+template<class T>
+static QString join(const std::vector<T>& values_)
+{
+   QString str;
+   for (const auto& value : values_)
+      str += QString::number(value) + ',';
+
+   str.chop(1);
+   return str;
+}
+
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-= Методы класса =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+QString SBenchmarkCase::Name() const
+{
+   return QString("vars=%1 arity=%2 templ=%3 any=%4").arg(countVariables).arg(arity).arg(countTemplateVariables).arg(bAnyArgument && arity > 1 ? 1 : 0);
+}
+
+void CBenchmark::SetSeed(quint32 seed_)
+{
+   m_seed = seed_;
+}
+
+void CBenchmark::SetMinTime(qint64 milliseconds_)
+{
+   m_minTime = qMax(milliseconds_, qint64(1)) * 1'000'000;
+}
+
+void CBenchmark::SetFilter(const QString& filter_)
+{
+   m_filter = filter_;
+}
+
+void CBenchmark::Run(const std::vector<SBenchmarkCase>& cases_)
+{
+   m_vResults.clear();
+
+   for (const auto& benchCase : cases_)
+      runCase(benchCase);
+}
+
+QByteArray CBenchmark::Json() const
+{
+   QJsonArray results;
+   for (const auto& result : m_vResults)
+   {
+      QJsonObject object;
+      object["operation"] = result.operation;
+      object["variables"] = static_cast<qint64>(result.params.countVariables);
+      object["arity"] = static_cast<qint64>(result.params.arity);
+      object["templateVariables"] = static_cast<qint64>(result.params.countTemplateVariables);
+      object["anyArgument"] = result.params.bAnyArgument && result.params.arity > 1;
+      object["predicates"] = static_cast<qint64>(result.params.countPredicates);
+      object["density"] = result.params.density;
+      object["iterations"] = static_cast<qint64>(result.iterations);
+      object["nsPerOp"] = result.nsPerOp;
+      object["allocationsPerOp"] = result.allocationsPerOp;
+      object["substitutionsPerSecond"] = result.substitutionsPerSecond;
+      results.append(object);
+   }
+
+   QJsonObject root;
+   root["seed"] = static_cast<qint64>(m_seed);
+   root["minTimeMs"] = static_cast<qint64>(m_minTime / 1'000'000);
+   root["results"] = results;
+
+   return QJsonDocument(root).toJson();
+}
+
+QString CBenchmark::StringTable() const
+{
+   QString str;
+   QTextStream out(&str);
+
+   out << QString("%1 %2 %3 %4 %5 %6")
+      .arg("operation", -24)
+      .arg("case", -36)
+      .arg("iterations", 12)
+      .arg("ns/op", 14)
+      .arg("allocs/op", 10)
+      .arg("subst/s", 12) << Qt::endl;
+
+   for (const auto& result : m_vResults)
+   {
+      out << QString("%1 %2 %3 %4 %5 %6")
+         .arg(result.operation, -24)
+         .arg(result.params.Name(), -36)
+         .arg(result.iterations, 12)
+         .arg(result.nsPerOp, 14, 'f', 1)
+         .arg(result.allocationsPerOp, 10, 'f', 1)
+         .arg(result.substitutionsPerSecond > 0 ? QString::number(result.substitutionsPerSecond, 'g', 4) : QString("-"), 12) << Qt::endl;
+   }
+
+   return str;
+}
+
+std::vector<SBenchmarkCase> CBenchmark::DefaultCases()
+{
+   const SBenchmarkCase base;
+   std::vector<SBenchmarkCase> vCases{ base };
+
+   for (size_t countVariables : { 8, 32, 64 })
+   {
+      vCases.push_back(base);
+      vCases.back().countVariables = countVariables;
+   }
+
+   for (size_t arity : { 1, 3 })
+   {
+      vCases.push_back(base);
+      vCases.back().arity = arity;
+   }
+
+   for (size_t countTemplate : { 2, 4, 5 })
+   {
+      vCases.push_back(base);
+      vCases.back().countTemplateVariables = countTemplate;
+   }
+
+   vCases.push_back(base);
+   vCases.back().bAnyArgument = true;
+
+   return vCases;
+}
+
+std::vector<SBenchmarkCase> CBenchmark::GridCases(const std::vector<size_t>& variables_, const std::vector<size_t>& arity_, const std::vector<size_t>& templateVariables_, const std::vector<bool>& anyArgument_)
+{
+   std::vector<SBenchmarkCase> vCases;
+
+   for (size_t countVariables : variables_)
+      for (size_t arity : arity_)
+         for (size_t countTemplate : templateVariables_)
+            for (bool bAny : anyArgument_)
+            {
+               SBenchmarkCase benchCase;
+               benchCase.countVariables = countVariables;
+               benchCase.arity = arity;
+               benchCase.countTemplateVariables = countTemplate;
+               benchCase.bAnyArgument = bAny;
+               vCases.push_back(benchCase);
+            }
+
+   return vCases;
+}
+
+void CBenchmark::runCase(const SBenchmarkCase& case_)
+{
+   if (case_.countVariables < case_.countTemplateVariables || case_.countTemplateVariables == 0 || case_.arity == 0 || case_.countPredicates == 0)
+      throw CException("Некорректные параметры случая: " + case_.Name(), "Ошибка замера", "CBenchmark::runCase");
+
+   CGeneticAlgorithm algorithm;
+   const QString textPredicates = prepare(algorithm, case_);
+
+   std::vector<QString> vVariables(algorithm.m_storage->CountVariables());
+   for (size_t iVar = 0; iVar < vVariables.size(); ++iVar)
+      vVariables[iVar] = algorithm.m_storage->GetVariables().Name(iVar).toString();
+
+   // Особи - мутанты исходного ограничения.
+   std::vector<CGeneticAlgorithm::TIntegrityLimitation> vIndividuals(COUNT_INDIVIDUALS);
+   for (auto& individual : vIndividuals)
+   {
+      individual = algorithm.m_original;
+      algorithm.MutationPredicates(individual, 0.3);
+      algorithm.MutationArguments(individual, 0.3);
+   }
+
+   const SCondition& condition = algorithm.m_original.front();
+
+   // Условие истинно по построению, значит перебираются все подстановки.
+   const double substitutions = algorithm.IsTrueCondition(condition) ? static_cast<double>(NumberOfPlacements(case_.countVariables, condition.maxArgument + 1)) : 0.;
+
+   measure("IsTrueCondition", case_, [&](size_t)
+      {
+         keep(algorithm.IsTrueCondition(condition));
+      }, substitutions);
+
+   // Блок условий с тем же количеством переменных шаблона: по одному и за один перебор подстановок.
+   CBatchEvaluator evaluator(*algorithm.m_storage);
+   std::vector<const SCondition*> vBlock{ &condition };
+   for (const auto& individual : vIndividuals)
+      for (const SCondition& cond : individual)
+         if (vBlock.size() < CBatchEvaluator::MAX_CONDITIONS && cond.maxArgument == condition.maxArgument && algorithm.IsCorrectCondition(cond) && evaluator.IsSupported(cond))
+            vBlock.push_back(&cond);
+
+   measure("IsTrueCondition block", case_, [&](size_t)
+      {
+         for (const SCondition* pCond : vBlock)
+            keep(algorithm.IsTrueCondition(*pCond));
+      });
+
+   measure("CBatchEvaluator block", case_, [&](size_t)
+      {
+         SEvaluationCounts counts;
+         keep(evaluator.Evaluate(vBlock, counts));
+      });
+
+   measure("EvaluatePrefixes block", case_, [&](size_t)
+      {
+         SEvaluationCounts counts;
+         const std::vector<bool> vTrue = evaluator.EvaluatePrefixes(vBlock, counts);
+         keep(std::count(vTrue.begin(), vTrue.end(), true));
+      });
+
+   measure("FitnessFunction", case_, [&](size_t iteration_)
+      {
+         keep(algorithm.FitnessFunction(vIndividuals[iteration_ % COUNT_INDIVIDUALS]));
+      });
+
+   measure("quantitativeAssessment", case_, [&](size_t iteration_)
+      {
+         keep(algorithm.quantitativeAssessment(condition.left, algorithm.m_vOriginalIndex.front()[0], vIndividuals[iteration_ % COUNT_INDIVIDUALS].front().left).matchPred);
+      });
+
+   measure("CrossingOnlyPredicates", case_, [&](size_t iteration_)
+      {
+         keep(algorithm.CrossingOnlyPredicates(vIndividuals[iteration_ % COUNT_INDIVIDUALS], vIndividuals[(iteration_ + 1) % COUNT_INDIVIDUALS]).size());
+      });
+
+   // Мутации изменяют особь, поэтому в замер входит ее копирование.
+   measure("MutationArguments", case_, [&](size_t iteration_)
+      {
+         auto individual = vIndividuals[iteration_ % COUNT_INDIVIDUALS];
+         algorithm.MutationArguments(individual, 0.1);
+         keep(individual.size());
+      });
+
+   measure("MutationPredicates", case_, [&](size_t iteration_)
+      {
+         auto individual = vIndividuals[iteration_ % COUNT_INDIVIDUALS];
+         algorithm.MutationPredicates(individual, 0.1);
+         keep(individual.size());
+      });
+
+   measure("AddPredicates", case_, [&](size_t)
+      {
+         CPredicatesStorage storage;
+         storage.SetVariables(vVariables);
+         storage.AddPredicates(textPredicates);
+         keep(storage.CountPredicates());
+      });
+}
+
+void CBenchmark::measure(const QString& name_, const SBenchmarkCase& case_, const std::function<void(size_t)>& operation_, double substitutionsPerOp_)
+{
+   if (!m_filter.isEmpty() && !name_.contains(m_filter))
+      return;
+
+   // Прогрев.
+   operation_(0);
+
+   size_t count = 1;
+   qint64 elapsed = 0;
+   size_t allocations = 0;
+
+   while (true)
+   {
+      const size_t allocationsBefore = CountAllocations();
+
+      QElapsedTimer timer;
+      timer.start();
+
+      for (size_t i = 0; i < count; ++i)
+         operation_(i);
+
+      elapsed = timer.nsecsElapsed();
+      allocations = CountAllocations() - allocationsBefore;
+
+      if (elapsed >= m_minTime || count >= MAX_ITERATIONS)
+         break;
+
+      count *= 2;
+   }
+
+   SBenchmarkResult result;
+   result.operation = name_;
+   result.params = case_;
+   result.iterations = count;
+   result.nsPerOp = static_cast<double>(elapsed) / count;
+   result.allocationsPerOp = static_cast<double>(allocations) / count;
+
+   if (substitutionsPerOp_ > 0 && elapsed > 0)
+      result.substitutionsPerSecond = substitutionsPerOp_ * count * 1e9 / elapsed;
+
+   m_vResults.push_back(result);
+
+   QTextStream(stderr) << name_ << " [" << case_.Name() << "]: " << QString::number(result.nsPerOp, 'f', 1) << " ns/op" << Qt::endl;
+}
+
+QString CBenchmark::prepare(CGeneticAlgorithm& algorithm_, const SBenchmarkCase& case_) const
+{
+   CRandom rand;
+   rand.SetSeed(m_seed);
+
+   // Имена с ведущими нулями, чтобы порядок переменных в хранилище совпадал с номерами.
+   std::vector<QString> vVariables(case_.countVariables);
+   for (size_t iVar = 0; iVar < vVariables.size(); ++iVar)
+      vVariables[iVar] = QString("c%1").arg(iVar, 3, 10, QChar('0'));
+
+   size_t tableSize = 1;
+   for (size_t iArg = 0; iArg < case_.arity; ++iArg)
+      tableSize *= case_.countVariables;
+
+   QString text;
+   std::vector<size_t> vArgs(case_.arity);
+   auto appendPredicate = [&](const QString& name_, bool bAlwaysTrue_)
+      {
+         text += QString("%1(%2)\n").arg(name_).arg(case_.arity);
+
+         for (size_t index = 0; index < tableSize; ++index)
+         {
+            if (!bAlwaysTrue_ && rand.Generate(0, 999) >= case_.density * 1000)
+               continue;
+
+            size_t rest = index;
+            for (size_t iArg = case_.arity; iArg-- > 0;)
+            {
+               vArgs[iArg] = rest % case_.countVariables;
+               rest /= case_.countVariables;
+            }
+
+            for (size_t iArg = 0; iArg < case_.arity; ++iArg)
+               text += vVariables[vArgs[iArg]] + (iArg + 1 < case_.arity ? ", " : "\n");
+         }
+
+         text += '\n';
+      };
+
+   for (size_t iPred = 0; iPred < case_.countPredicates; ++iPred)
+      appendPredicate(QString("P%1").arg(iPred), false);
+
+   appendPredicate("T", true);
+
+   algorithm_.Clear();
+   algorithm_.SetSeed(m_seed);
+   algorithm_.m_storage->SetVariables(vVariables);
+   algorithm_.m_storage->AddPredicates(text);
+
+   // Исходное ограничение целостности из двух условий.
+   for (size_t iCond = 0; iCond < 2; ++iCond)
+      algorithm_.m_original.push_back(makeCondition(case_, case_.countPredicates, rand));
+
+   algorithm_.indexOriginal();
+   return text;
+}
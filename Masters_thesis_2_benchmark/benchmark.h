@@ -0,0 +1,82 @@
+#pragma once
+#include <functional>
+#include <vector>
+
+#include <QByteArray>
+#include <QString>
+
+class CGeneticAlgorithm;
+
+// Параметры синтетических данных для одного случая.
+struct SBenchmarkCase
+{
+   size_t countVariables = 16;        // количество переменных (констант)
+   size_t arity = 2;                  // количество аргументов у предикатов
+   size_t countTemplateVariables = 3; // количество переменных шаблона в условии (maxArgument + 1)
+   bool bAnyArgument = false;         // есть ли в условии аргумент '~' (только при arity > 1)
+   size_t countPredicates = 6;        // количество предикатов (кроме всегда истинного)
+   double density = 0.3;              // доля истинных значений в таблицах истинности
+
+   // Возвращает краткое описание случая.
+   QString Name() const;
+};
+
+// Результат замера одной операции.
+struct SBenchmarkResult
+{
+   QString operation;
+   SBenchmarkCase params;
+   size_t iterations = 0;
+   double nsPerOp = 0;
+   double allocationsPerOp = 0;
+   double substitutionsPerSecond = 0; // 0 - для операции не применимо
+};
+
+// Замеры производительности вычисления истинности, фитнес функции, генетических операторов
+// и загрузки предикатов на синтетических данных.
+//
+// Условия строятся так, что их правая часть содержит всегда истинный предикат, поэтому
+// IsTrueCondition перебирает все подстановки и их количество известно заранее.
+class CBenchmark
+{
+   quint32 m_seed = 1;
+   qint64 m_minTime = 200'000'000; // минимальное время замера одной операции (нс)
+   QString m_filter;               // замеряются только операции, содержащие строку
+
+   std::vector<SBenchmarkResult> m_vResults;
+
+public:
+
+   void SetSeed(quint32 seed_);
+   void SetMinTime(qint64 milliseconds_);
+   void SetFilter(const QString& filter_);
+
+   // Выполняет замеры всех операций для всех случаев.
+   // !> exception при ошибке подготовки данных.
+   void Run(const std::vector<SBenchmarkCase>& cases_);
+
+   // Возвращает результаты в формате JSON.
+   QByteArray Json() const;
+
+   // Возвращает результаты в виде таблицы.
+   QString StringTable() const;
+
+   // Возвращает случаи по умолчанию: базовый случай и изменения по одному параметру от него.
+   static std::vector<SBenchmarkCase> DefaultCases();
+
+   // Возвращает все сочетания заданных значений параметров.
+   static std::vector<SBenchmarkCase> GridCases(const std::vector<size_t>& variables_, const std::vector<size_t>& arity_, const std::vector<size_t>& templateVariables_, const std::vector<bool>& anyArgument_);
+
+private:
+
+   // Выполняет замеры всех операций для одного случая.
+   void runCase(const SBenchmarkCase& case_);
+
+   // Замеряет операцию. operation_ получает номер повтора.
+   // substitutionsPerOp_ - количество подстановок за одну операцию (0 - не применимо).
+   void measure(const QString& name_, const SBenchmarkCase& case_, const std::function<void(size_t)>& operation_, double substitutionsPerOp_ = 0);
+
+   // Заполняет algorithm_ синтетическими данными случая case_.
+   // Возвращает текст раздела предикатов (для замера загрузки).
+   QString prepare(CGeneticAlgorithm& algorithm_, const SBenchmarkCase& case_) const;
+};
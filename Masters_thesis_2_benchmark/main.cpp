@@ -0,0 +1,126 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QTextStream>
+
+#include "benchmark.h"
+#include "exception.h"
+
+// Разбирает список чисел через запятую из параметра name_ (пустой - если параметр не задан).
+// !> exception при некорректном значении.
+static std::vector<size_t> readList(const QCommandLineParser& parser_, const QString& name_)
+{
+   std::vector<size_t> values;
+   if (!parser_.isSet(name_))
+      return values;
+
+   for (const QString& item : parser_.value(name_).split(',', Qt::SkipEmptyParts))
+   {
+      bool bOk = false;
+      const size_t value = item.trimmed().toULongLong(&bOk);
+      if (!bOk)
+         throw CException("Некорректное значение параметра --" + name_ + ": " + item, "Ошибка аргументов", "readList");
+
+      values.push_back(value);
+   }
+
+   return values;
+}
+
+int main(int argc, char* argv[])
+{
+   QCoreApplication a(argc, argv);
+   QCoreApplication::setApplicationName("Masters_thesis_2_benchmark");
+
+   QCommandLineParser parser;
+   parser.setApplicationDescription("Замеры производительности вычисления истинности условий, фитнес функции и генетических операторов.");
+   parser.addHelpOption();
+   parser.addOptions({
+      { "json", "Записать результаты в формате JSON в файл (\"-\" - стандартный вывод).", "file" },
+      { "filter", "Замерять только операции, содержащие строку.", "text" },
+      { "min-time", "Минимальное время замера одной операции (мс).", "ms", "200" },
+      { "seed", "Зерно генератора случайных чисел.", "seed", "1" },
+      { "variables", "Количества переменных через запятую.", "list" },
+      { "arity", "Количества аргументов предикатов через запятую.", "list" },
+      { "template", "Количества переменных шаблона в условии через запятую.", "list" },
+      { "any", "Значения наличия аргумента '~' через запятую (0/1).", "list" },
+   });
+   parser.process(a);
+
+   CBenchmark benchmark;
+   std::vector<SBenchmarkCase> vCases;
+
+   try
+   {
+      bool bOk = false;
+      benchmark.SetMinTime(parser.value("min-time").toLongLong(&bOk));
+      if (!bOk)
+         throw CException("Некорректное значение параметра --min-time", "Ошибка аргументов", "main");
+
+      benchmark.SetSeed(parser.value("seed").toUInt(&bOk));
+      if (!bOk)
+         throw CException("Некорректное значение параметра --seed", "Ошибка аргументов", "main");
+
+      benchmark.SetFilter(parser.value("filter"));
+
+      std::vector<size_t> vVariables = readList(parser, "variables");
+      std::vector<size_t> vArity = readList(parser, "arity");
+      std::vector<size_t> vTemplate = readList(parser, "template");
+      const std::vector<size_t> vAny = readList(parser, "any");
+
+      if (vVariables.empty() && vArity.empty() && vTemplate.empty() && vAny.empty())
+         vCases = CBenchmark::DefaultCases();
+      else
+      {
+         // Незаданные параметры берутся из базового случая.
+         const SBenchmarkCase base;
+         if (vVariables.empty())
+            vVariables.push_back(base.countVariables);
+         if (vArity.empty())
+            vArity.push_back(base.arity);
+         if (vTemplate.empty())
+            vTemplate.push_back(base.countTemplateVariables);
+
+         std::vector<bool> vAnyArgument;
+         for (size_t any : vAny)
+            vAnyArgument.push_back(any != 0);
+         if (vAnyArgument.empty())
+            vAnyArgument.push_back(base.bAnyArgument);
+
+         vCases = CBenchmark::GridCases(vVariables, vArity, vTemplate, vAnyArgument);
+      }
+
+      benchmark.Run(vCases);
+   }
+   catch (const CException& error)
+   {
+      QTextStream(stderr) << error.title() << ": " << error.what() << Qt::endl;
+      return 2;
+   }
+
+   // JSON в стандартном выводе должен читаться целиком, таблица тогда выводится в поток ошибок.
+   const bool bJsonStdout = parser.isSet("json") && parser.value("json") == "-";
+   QTextStream(bJsonStdout ? stderr : stdout) << benchmark.StringTable();
+
+   if (parser.isSet("json"))
+   {
+      const QString fileName = parser.value("json");
+      QFile file;
+
+      if (fileName == "-")
+         file.open(stdout, QIODevice::WriteOnly);
+      else
+      {
+         file.setFileName(fileName);
+         if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+         {
+            QTextStream(stderr) << "Не удалось открыть файл: " << fileName << Qt::endl;
+            return 1;
+         }
+      }
+
+      file.write(benchmark.Json());
+   }
+
+   return 0;
+}
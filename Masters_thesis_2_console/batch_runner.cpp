@@ -0,0 +1,664 @@
+#include <algorithm>
+#include <climits>
+#include <mutex>
+#include <type_traits>
+
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QTextStream>
+
+#include "batch_runner.h"
+#include "genetic_algorithm.h"
+#include "exception.h"
+#include "parallel.h"
+
+static const char* TITLE_ARGUMENTS = "Ошибка в аргументах";
+
+// Параметры задания.
+static const QString OPT_INDIVIDUALS("individuals");
+static const QString OPT_ITERATIONS("iterations");
+static const QString OPT_MUTATION_ARGUMENTS("mutation-arguments");
+static const QString OPT_SKIP_MUTATION_ARGUMENTS("skip-mutation-arguments");
+static const QString OPT_MUTATION_PREDICATES("mutation-predicates");
+static const QString OPT_SKIP_MUTATION_PREDICATES("skip-mutation-predicates");
+static const QString OPT_MUTATION_INDIVIDUALS("mutation-individuals");
+static const QString OPT_COST_ARGUMENTS("cost-arguments");
+static const QString OPT_COST_ADDING("cost-adding");
+static const QString OPT_LOCAL_SEARCH("local-search");
+static const QString OPT_LOCAL_SEARCH_NEIGHBORS("local-search-neighbors");
+static const QString OPT_SCRIPT_GENOME("script-genome");
+static const QString OPT_INIT_SEEDED("init-seeded");
+static const QString OPT_INIT_EDITS("init-edits");
+static const QString OPT_INIT_IMPORT("init-import");
+static const QString OPT_SEED("seed");
+static const QString OPT_TOP("top");
+static const QString OPT_RESULT_FORMAT("result-format");
+static const QString OPT_STATS("stats");
+static const QString OPT_TRACE("trace");
+static const QString OPT_TIME_LIMIT("time-limit");
+static const QString OPT_PORTFOLIO("portfolio");
+static const QString OPT_PORTFOLIO_INDIVIDUALS("portfolio-individuals");
+static const QString OPT_PORTFOLIO_MUTATION_ARGUMENTS("portfolio-mutation-arguments");
+static const QString OPT_EXACT("exact");
+static const QString OPT_EXACT_CANDIDATES("exact-candidates");
+static const QString OPT_BEAM("beam");
+static const QString OPT_BEAM_DEPTH("beam-depth");
+static const QString OPT_CACHE_DIR("cache-dir");
+static const QString OPT_SWEEP("sweep");
+static const QString OPT_SWEEP_RANDOM("sweep-random");
+static const QString OPT_SWEEP_SEEDS("sweep-seeds");
+static const QString OPT_SWEEP_ETA("sweep-eta");
+static const QString OPT_SWEEP_RUNGS("sweep-rungs");
+
+// Параметры пакетного запуска (только в командной строке).
+static const QString OPT_THREADS("threads");
+static const QString OPT_OUTPUT_DIR("output-dir");
+static const QString OPT_JOBS_FILE("jobs-file");
+static const QString OPT_SUMMARY("summary");
+
+// Возвращает сообщение о некорректном значении параметра name_.
+static QString invalidValue(const QCommandLineParser& parser_, const QString& name_)
+{
+   return QString("Некорректное значение параметра --%1: \"%2\".").arg(name_).arg(parser_.value(name_));
+}
+
+// Возвращает целое значение параметра name_, не меньшее min_.
+// !> exception при некорректном значении.
+static int intValue(const QCommandLineParser& parser_, const QString& name_, int min_)
+{
+   bool bOk = false;
+   const int value = parser_.value(name_).toInt(&bOk);
+   if (!bOk || value < min_)
+      throw CException(invalidValue(parser_, name_), TITLE_ARGUMENTS, "CBatchRunner::readJobOptions");
+
+   return value;
+}
+
+// Возвращает вещественное значение параметра name_ из отрезка [min_; max_] (bOpen_ - из интервала (min_; max_)).
+// !> exception при некорректном значении.
+static double doubleValue(const QCommandLineParser& parser_, const QString& name_, double min_, double max_, bool bOpen_ = false)
+{
+   bool bOk = false;
+   const double value = parser_.value(name_).toDouble(&bOk);
+   if (!bOk || value < min_ || value > max_ || (bOpen_ && (value == min_ || value == max_)))
+      throw CException(invalidValue(parser_, name_), TITLE_ARGUMENTS, "CBatchRunner::readJobOptions");
+
+   return value;
+}
+
+// Возвращает список значений параметра name_ (через запятую), каждое не меньше min_ и не больше max_.
+// !> exception при некорректном значении.
+template<typename T>
+static std::vector<T> listValue(const QCommandLineParser& parser_, const QString& name_, T min_, T max_)
+{
+   std::vector<T> vValues;
+   for (const QString& item : parser_.value(name_).split(',', Qt::SkipEmptyParts))
+   {
+      bool bOk = false;
+      const T value = std::is_integral_v<T> ? static_cast<T>(item.trimmed().toInt(&bOk)) : static_cast<T>(item.trimmed().toDouble(&bOk));
+      if (!bOk || value < min_ || value > max_)
+         throw CException(invalidValue(parser_, name_), TITLE_ARGUMENTS, "CBatchRunner::readJobOptions");
+
+      vValues.push_back(value);
+   }
+
+   if (vValues.empty())
+      throw CException(invalidValue(parser_, name_), TITLE_ARGUMENTS, "CBatchRunner::readJobOptions");
+
+   return vValues;
+}
+
+// Возвращает строку без переводов строк и табуляций (для итоговой таблицы).
+static QString singleLine(QString str_)
+{
+   for (QChar& symb : str_)
+      if (symb == '\n' || symb == '\r' || symb == '\t')
+         symb = ' ';
+
+   return str_.simplified();
+}
+
+void CBatchRunner::ParseArguments(const QStringList& arguments_)
+{
+   QCommandLineParser parser;
+   parser.setApplicationDescription("Пакетный запуск генетического алгоритма без графического интерфейса.\n"
+      "Для каждого файла с данными создается задание, задания выполняются параллельно.\n"
+      "Строка файла заданий - параметры задания и файлы с данными (пустые строки и строки с '#' пропускаются).");
+   parser.addHelpOption();
+   parser.addPositionalArgument("files", "Файлы с данными.", "[files...]");
+
+   addJobOptions(parser);
+   parser.addOption(QCommandLineOption({ "j", OPT_THREADS }, "Количество потоков (0 - по количеству ядер), делятся между одновременными заданиями.", "N", "0"));
+   parser.addOption(QCommandLineOption({ "o", OPT_OUTPUT_DIR }, "Папка для файлов результатов.", "dir", "."));
+   parser.addOption(QCommandLineOption(OPT_JOBS_FILE, "Файл заданий.", "file"));
+   parser.addOption(QCommandLineOption(OPT_SUMMARY, "Файл итоговой таблицы (по умолчанию summary.tsv в папке результатов).", "file"));
+
+   parser.process(arguments_);
+
+   m_vJobs.clear();
+   m_countThreads = intValue(parser, OPT_THREADS, 0);
+   m_outputDir = parser.value(OPT_OUTPUT_DIR);
+   m_summaryFile = parser.isSet(OPT_SUMMARY) ? parser.value(OPT_SUMMARY) : QDir(m_outputDir).filePath("summary.tsv");
+
+   SJob defaults;
+   readJobOptions(parser, defaults);
+   addJobs(parser.positionalArguments(), defaults);
+
+   if (parser.isSet(OPT_JOBS_FILE))
+      readJobsFile(parser.value(OPT_JOBS_FILE), defaults);
+
+   if (m_vJobs.empty())
+      throw CException("Нет заданий. Укажите файлы с данными или файл заданий (--jobs-file).", TITLE_ARGUMENTS, "CBatchRunner::ParseArguments");
+}
+
+size_t CBatchRunner::Run()
+{
+   QDir().mkpath(m_outputDir);
+   m_vResults.assign(m_vJobs.size(), SJobResult());
+
+   std::mutex mutexOutput;
+   size_t countFinished = 0;
+
+   QElapsedTimer timer;
+   timer.start();
+
+   // Потоки делятся между одновременно выполняемыми заданиями, чтобы параллельные задания (портфель,
+   // подбор параметров, точный и лучевой поиск) не запускали каждое по потоку на ядро.
+   const int countThreads = m_countThreads > 0 ? m_countThreads : QThread::idealThreadCount();
+   const size_t countConcurrentJobs = std::min(m_vJobs.size(), static_cast<size_t>(qMax(countThreads, 1)));
+   const int countJobThreads = qMax(countThreads / static_cast<int>(countConcurrentJobs), 1);
+
+   ParallelFor(m_vJobs.size(), [&](size_t iJob)
+      {
+         m_vResults[iJob] = runJob(m_vJobs[iJob], countJobThreads);
+         const SJobResult& result = m_vResults[iJob];
+
+         std::lock_guard<std::mutex> lock(mutexOutput);
+         QTextStream out(stdout);
+         out << QString("[%1/%2] %3: ").arg(++countFinished).arg(m_vJobs.size()).arg(m_vJobs[iJob].inputFile);
+
+         if (result.bSuccess)
+         {
+            out << QString("фитнес %1, загрузка %2 мс, алгоритм %3 мс").arg(result.bestFitness).arg(result.loadTime).arg(result.runTime);
+            if (result.bInterrupted)
+               out << " (остановлен по времени)";
+         }
+         else
+            out << "ошибка. " << singleLine(result.error);
+
+         out << Qt::endl;
+      }, countThreads);
+
+   const size_t countFailed = std::count_if(m_vResults.begin(), m_vResults.end(), [](const SJobResult& result_) { return !result_.bSuccess; });
+
+   QTextStream out(stdout);
+   out << QString("Заданий: %1, с ошибкой: %2, общее время %3 мс.").arg(m_vJobs.size()).arg(countFailed).arg(timer.elapsed()) << Qt::endl;
+
+   QFile file(m_summaryFile);
+   if (file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+      file.write(StringSummary().toUtf8());
+   else
+      QTextStream(stderr) << "Не удалось открыть файл итоговой таблицы: " << m_summaryFile << Qt::endl;
+
+   return countFailed;
+}
+
+QString CBatchRunner::StringSummary() const
+{
+   QString str("job\tinput\toutput\tstatus\tseed\tindividuals\titerations\tload_ms\trun_ms\tbest_fitness\t"
+      "condition_checks\tfalse_conditions\tplacements\tleft_false_exits\tright_true_exits\tany_map_ms\tportfolio_run\terror\n");
+
+   for (size_t iJob = 0; iJob < m_vJobs.size() && iJob < m_vResults.size(); ++iJob)
+   {
+      const SJob& job = m_vJobs.at(iJob);
+      const SJobResult& result = m_vResults.at(iJob);
+
+      str += QString("%1\t%2\t%3\t%4\t%5\t%6\t%7\t%8\t%9\t")
+         .arg(iJob + 1)
+         .arg(job.inputFile)
+         .arg(job.outputFile)
+         .arg(result.bSuccess ? (result.bInterrupted ? "stopped" : "ok") : "error")
+         .arg(result.seed)
+         .arg(result.countIndividuals > 0 ? result.countIndividuals : job.countIndividuals)
+         .arg(job.countIterations)
+         .arg(result.loadTime)
+         .arg(result.runTime);
+      str += QString("%1\t%2\t%3\t%4\t%5\t%6\t%7\t%8\t%9\n")
+         .arg(result.bestFitness)
+         .arg(result.evaluation.evaluations)
+         .arg(result.evaluation.falseResults)
+         .arg(result.evaluation.placements)
+         .arg(result.evaluation.leftFalseExits)
+         .arg(result.evaluation.rightTrueExits)
+         .arg(result.evaluation.anyMapTime / 1000000)
+         .arg(result.bestRun == SIZE_MAX ? QString() : QString::number(result.bestRun + 1))
+         .arg(singleLine(result.error));
+   }
+
+   return str;
+}
+
+void CBatchRunner::addJobOptions(QCommandLineParser& parser_)
+{
+   parser_.addOption(QCommandLineOption({ "i", OPT_INDIVIDUALS }, "Количество особей (по умолчанию 100).", "N"));
+   parser_.addOption(QCommandLineOption({ "n", OPT_ITERATIONS }, "Количество итераций (по умолчанию 100).", "N"));
+   parser_.addOption(QCommandLineOption(OPT_MUTATION_ARGUMENTS, "Процент мутаций аргументов (по умолчанию 10, 0 - без мутаций).", "percent"));
+   parser_.addOption(QCommandLineOption(OPT_SKIP_MUTATION_ARGUMENTS, "Количество последних итераций без мутаций аргументов (по умолчанию 5).", "N"));
+   parser_.addOption(QCommandLineOption(OPT_MUTATION_PREDICATES, "Процент мутаций предикатов (по умолчанию 0 - без мутаций).", "percent"));
+   parser_.addOption(QCommandLineOption(OPT_SKIP_MUTATION_PREDICATES, "Количество последних итераций без мутаций предикатов (по умолчанию 0).", "N"));
+   parser_.addOption(QCommandLineOption(OPT_MUTATION_INDIVIDUALS, "Процент особей, подвергаемых мутациям (по умолчанию 25).", "percent"));
+   parser_.addOption(QCommandLineOption(OPT_COST_ARGUMENTS, "Нижняя граница цены измененных аргументов (0; 1) (по умолчанию 0.75).", "value"));
+   parser_.addOption(QCommandLineOption(OPT_COST_ADDING, "Цена добавления предиката [0; 1] (по умолчанию 0.2).", "value"));
+   parser_.addOption(QCommandLineOption(OPT_LOCAL_SEARCH, "Количество лучших особей, улучшаемых локальным поиском после каждого поколения (по умолчанию 0 - без локального поиска).", "N"));
+   parser_.addOption(QCommandLineOption(OPT_LOCAL_SEARCH_NEIGHBORS, "Наибольшее количество соседей одной особи в локальном поиске (по умолчанию 200).", "N"));
+   parser_.addOption(QCommandLineOption(OPT_SCRIPT_GENOME, "Особи - правки изначального ограничения, а не условия целиком (скрещивание, мутации и фитнес по правкам)."));
+   parser_.addOption(QCommandLineOption(OPT_INIT_SEEDED, "Процент особей первого поколения - копий изначального ограничения с правками (по умолчанию 0 - все случайные).", "percent"));
+   parser_.addOption(QCommandLineOption(OPT_INIT_EDITS, "Количество правок одного условия копии: \"min,max\" или одно число (по умолчанию 1,3).", "range"));
+   parser_.addOption(QCommandLineOption(OPT_INIT_IMPORT, "Файл результата предыдущего запуска, особи которого попадают в первое поколение.", "file"));
+   parser_.addOption(QCommandLineOption({ "s", OPT_SEED }, "Зерно генератора случайных чисел (по умолчанию случайное).", "N"));
+   parser_.addOption(QCommandLineOption({ "t", OPT_TOP }, "Количество лучших особей в файле результата (по умолчанию 10).", "N"));
+   parser_.addOption(QCommandLineOption(OPT_RESULT_FORMAT, "Формат файла результата: txt, jsonl или bin (по умолчанию txt).", "format"));
+   parser_.addOption(QCommandLineOption(OPT_STATS, "Записывать статистику поколений в формате csv или jsonl.", "format"));
+   parser_.addOption(QCommandLineOption(OPT_TRACE, "Записывать трассировку запуска (Chrome trace_event, открывается в Perfetto)."));
+   parser_.addOption(QCommandLineOption(OPT_TIME_LIMIT, "Ограничение времени работы алгоритма в мс (по умолчанию 0 - без ограничения).", "ms"));
+   parser_.addOption(QCommandLineOption(OPT_PORTFOLIO, "Количество независимых запусков портфеля с зернами seed, seed + 1, ... (по умолчанию 0 - один запуск).", "N"));
+   parser_.addOption(QCommandLineOption(OPT_PORTFOLIO_INDIVIDUALS, "Количества особей запусков портфеля через запятую (по кругу).", "list"));
+   parser_.addOption(QCommandLineOption(OPT_PORTFOLIO_MUTATION_ARGUMENTS, "Проценты мутаций аргументов запусков портфеля через запятую (по кругу).", "list"));
+   parser_.addOption(QCommandLineOption(OPT_EXACT, "Точный поиск лучших условий не более чем в K правках от изначальных вместо генетического алгоритма.", "K"));
+   parser_.addOption(QCommandLineOption(OPT_EXACT_CANDIDATES, "Наибольшее количество кандидатов точного поиска на одно условие (по умолчанию 200000).", "N"));
+   parser_.addOption(QCommandLineOption(OPT_BEAM, "Поиск лучом шириной B вместо генетического алгоритма.", "B"));
+   parser_.addOption(QCommandLineOption(OPT_BEAM_DEPTH, "Наибольшая глубина поиска лучом (по умолчанию 3).", "N"));
+   parser_.addOption(QCommandLineOption(OPT_CACHE_DIR, "Каталог файлов кэша истинности условий, общих для запусков на тех же данных.", "dir"));
+   parser_.addOption(QCommandLineOption(OPT_SWEEP, "Перебор параметров вместо одного запуска: \"имя=значение,значение;имя=min:max:шаг;имя=min:max\" "
+      "(имена - individuals, mutation-arguments, skip-mutation-arguments, mutation-predicates, skip-mutation-predicates, "
+      "mutation-individuals, cost-arguments, cost-adding, local-search; отрезок min:max - только для --sweep-random).", "space"));
+   parser_.addOption(QCommandLineOption(OPT_SWEEP_RANDOM, "Количество случайных конфигураций перебора (по умолчанию 0 - вся сетка).", "N"));
+   parser_.addOption(QCommandLineOption(OPT_SWEEP_SEEDS, "Количество запусков (зерен seed, seed + 1, ...) на конфигурацию (по умолчанию 3).", "N"));
+   parser_.addOption(QCommandLineOption(OPT_SWEEP_ETA, "После каждой ступени перебора остается 1/eta лучших конфигураций (по умолчанию 3, 1 - без отсева).", "eta"));
+   parser_.addOption(QCommandLineOption(OPT_SWEEP_RUNGS, "Количество ступеней перебора, на ступени r из R итераций iterations / eta^(R - r) (по умолчанию 3).", "N"));
+}
+
+void CBatchRunner::readJobOptions(const QCommandLineParser& parser_, SJob& job_)
+{
+   if (parser_.isSet(OPT_INDIVIDUALS))
+      job_.countIndividuals = intValue(parser_, OPT_INDIVIDUALS, 2);
+
+   if (parser_.isSet(OPT_ITERATIONS))
+      job_.countIterations = intValue(parser_, OPT_ITERATIONS, 1);
+
+   if (parser_.isSet(OPT_MUTATION_ARGUMENTS))
+      job_.percentMutationArguments = doubleValue(parser_, OPT_MUTATION_ARGUMENTS, 0, 100);
+
+   if (parser_.isSet(OPT_SKIP_MUTATION_ARGUMENTS))
+      job_.countSkipMutationArg = intValue(parser_, OPT_SKIP_MUTATION_ARGUMENTS, 0);
+
+   if (parser_.isSet(OPT_MUTATION_PREDICATES))
+      job_.percentMutationPredicates = doubleValue(parser_, OPT_MUTATION_PREDICATES, 0, 100);
+
+   if (parser_.isSet(OPT_SKIP_MUTATION_PREDICATES))
+      job_.countSkipMutationPred = intValue(parser_, OPT_SKIP_MUTATION_PREDICATES, 0);
+
+   if (parser_.isSet(OPT_MUTATION_INDIVIDUALS))
+      job_.percentIndividualsUndergoingMutation = doubleValue(parser_, OPT_MUTATION_INDIVIDUALS, 0, 100);
+
+   if (parser_.isSet(OPT_COST_ARGUMENTS))
+      job_.limitOfArgumentsChange = doubleValue(parser_, OPT_COST_ARGUMENTS, 0, 1, true);
+
+   if (parser_.isSet(OPT_COST_ADDING))
+      job_.costAddingPredicate = doubleValue(parser_, OPT_COST_ADDING, 0, 1);
+
+   if (parser_.isSet(OPT_LOCAL_SEARCH))
+      job_.countLocalSearch = intValue(parser_, OPT_LOCAL_SEARCH, 0);
+
+   if (parser_.isSet(OPT_LOCAL_SEARCH_NEIGHBORS))
+      job_.countLocalSearchNeighbors = intValue(parser_, OPT_LOCAL_SEARCH_NEIGHBORS, 1);
+
+   if (parser_.isSet(OPT_SCRIPT_GENOME))
+      job_.bScriptGenome = true;
+
+   if (parser_.isSet(OPT_INIT_SEEDED))
+      job_.initialization.percentSeeded = doubleValue(parser_, OPT_INIT_SEEDED, 0, 100);
+
+   if (parser_.isSet(OPT_INIT_EDITS))
+   {
+      const std::vector<int> vEdits = listValue<int>(parser_, OPT_INIT_EDITS, 0, INT_MAX);
+      if (vEdits.size() > 2 || vEdits.front() > vEdits.back())
+         throw CException(invalidValue(parser_, OPT_INIT_EDITS), TITLE_ARGUMENTS, "CBatchRunner::readJobOptions");
+
+      job_.initialization.minEdits = vEdits.front();
+      job_.initialization.maxEdits = vEdits.back();
+   }
+
+   if (parser_.isSet(OPT_INIT_IMPORT))
+      job_.initialization.importFile = parser_.value(OPT_INIT_IMPORT);
+
+   if (parser_.isSet(OPT_SEED))
+   {
+      bool bOk = false;
+      job_.seed = parser_.value(OPT_SEED).toUInt(&bOk);
+      if (!bOk)
+         throw CException(invalidValue(parser_, OPT_SEED), TITLE_ARGUMENTS, "CBatchRunner::readJobOptions");
+
+      job_.bSeed = true;
+   }
+
+   if (parser_.isSet(OPT_TOP))
+      job_.countResults = static_cast<size_t>(intValue(parser_, OPT_TOP, 1));
+
+   if (parser_.isSet(OPT_RESULT_FORMAT))
+   {
+      job_.resultFormat = parser_.value(OPT_RESULT_FORMAT).toLower();
+      if (job_.resultFormat != "txt" && job_.resultFormat != "jsonl" && job_.resultFormat != "bin")
+         throw CException(invalidValue(parser_, OPT_RESULT_FORMAT), TITLE_ARGUMENTS, "CBatchRunner::readJobOptions");
+   }
+
+   if (parser_.isSet(OPT_STATS))
+   {
+      job_.statsFormat = parser_.value(OPT_STATS).toLower();
+      if (job_.statsFormat != "csv" && job_.statsFormat != "jsonl")
+         throw CException(invalidValue(parser_, OPT_STATS), TITLE_ARGUMENTS, "CBatchRunner::readJobOptions");
+   }
+
+   if (parser_.isSet(OPT_TRACE))
+      job_.bTrace = true;
+
+   if (parser_.isSet(OPT_TIME_LIMIT))
+      job_.timeBudget = intValue(parser_, OPT_TIME_LIMIT, 0);
+
+   if (parser_.isSet(OPT_PORTFOLIO))
+      job_.countPortfolio = intValue(parser_, OPT_PORTFOLIO, 0);
+
+   if (parser_.isSet(OPT_PORTFOLIO_INDIVIDUALS))
+      job_.vPortfolioIndividuals = listValue<int>(parser_, OPT_PORTFOLIO_INDIVIDUALS, 2, INT_MAX);
+
+   if (parser_.isSet(OPT_PORTFOLIO_MUTATION_ARGUMENTS))
+      job_.vPortfolioMutationArguments = listValue<double>(parser_, OPT_PORTFOLIO_MUTATION_ARGUMENTS, 0, 100);
+
+   if (parser_.isSet(OPT_EXACT))
+      job_.exactEdits = intValue(parser_, OPT_EXACT, 0);
+
+   if (parser_.isSet(OPT_EXACT_CANDIDATES))
+      job_.exactCandidates = static_cast<size_t>(intValue(parser_, OPT_EXACT_CANDIDATES, 1));
+
+   if (parser_.isSet(OPT_BEAM))
+      job_.beamWidth = intValue(parser_, OPT_BEAM, 1);
+
+   if (parser_.isSet(OPT_BEAM_DEPTH))
+      job_.beamDepth = intValue(parser_, OPT_BEAM_DEPTH, 0);
+
+   if (parser_.isSet(OPT_CACHE_DIR))
+      job_.cacheDir = parser_.value(OPT_CACHE_DIR);
+
+   if (parser_.isSet(OPT_SWEEP))
+   {
+      job_.bSweep = true;
+      job_.sweep.vRanges = CParameterSweep::ParseSpace(parser_.value(OPT_SWEEP));
+   }
+
+   if (parser_.isSet(OPT_SWEEP_RANDOM))
+      job_.sweep.countRandom = intValue(parser_, OPT_SWEEP_RANDOM, 0);
+
+   if (parser_.isSet(OPT_SWEEP_SEEDS))
+      job_.sweep.countSeeds = intValue(parser_, OPT_SWEEP_SEEDS, 1);
+
+   if (parser_.isSet(OPT_SWEEP_ETA))
+      job_.sweep.eta = intValue(parser_, OPT_SWEEP_ETA, 1);
+
+   if (parser_.isSet(OPT_SWEEP_RUNGS))
+      job_.sweep.countRungs = intValue(parser_, OPT_SWEEP_RUNGS, 1);
+}
+
+void CBatchRunner::addJobs(const QStringList& files_, const SJob& job_)
+{
+   for (const auto& file : files_)
+   {
+      SJob job = job_;
+      job.inputFile = file;
+
+      // Номер задания в имени, чтобы запуски одного файла с разными параметрами не перезаписывали друг друга.
+      job.outputFile = QDir(m_outputDir).filePath(QString("%1.%2.result.%3").arg(QFileInfo(file).completeBaseName()).arg(m_vJobs.size() + 1).arg(job.resultFormat));
+      if (!job.statsFormat.isEmpty())
+         job.statsFile = QDir(m_outputDir).filePath(QString("%1.%2.stats.%3").arg(QFileInfo(file).completeBaseName()).arg(m_vJobs.size() + 1).arg(job.statsFormat));
+
+      if (job.bTrace)
+         job.traceFile = QDir(m_outputDir).filePath(QString("%1.%2.trace.json").arg(QFileInfo(file).completeBaseName()).arg(m_vJobs.size() + 1));
+
+      if (job.bSweep)
+         job.sweepFile = QDir(m_outputDir).filePath(QString("%1.%2.sweep.tsv").arg(QFileInfo(file).completeBaseName()).arg(m_vJobs.size() + 1));
+
+      m_vJobs.push_back(std::move(job));
+   }
+}
+
+void CBatchRunner::readJobsFile(const QString& fileName_, const SJob& defaults_)
+{
+   QFile file(fileName_);
+   if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+      throw CException("Не удалось открыть файл заданий: " + fileName_, TITLE_ARGUMENTS, "CBatchRunner::readJobsFile");
+
+   // Относительные пути к файлам с данными отсчитываются от папки файла заданий.
+   const QDir dir = QFileInfo(fileName_).absoluteDir();
+
+   QTextStream in(&file);
+   for (int iLine = 1; !in.atEnd(); ++iLine)
+   {
+      const QString line = in.readLine().trimmed();
+      if (line.isEmpty() || line.startsWith('#'))
+         continue;
+
+      QCommandLineParser parser;
+      addJobOptions(parser);
+
+      if (!parser.parse(QStringList{ "job" } + QProcess::splitCommand(line)))
+         throw CException(QString("Строка %1 файла заданий: %2").arg(iLine).arg(parser.errorText()), TITLE_ARGUMENTS, "CBatchRunner::readJobsFile");
+
+      SJob job = defaults_;
+
+      try
+      {
+         readJobOptions(parser, job);
+      }
+      catch (CException& error)
+      {
+         error.addToBeginningMessage(QString("Строка %1 файла заданий:").arg(iLine), " ");
+         throw error;
+      }
+
+      QStringList files = parser.positionalArguments();
+      if (files.isEmpty())
+         throw CException(QString("Строка %1 файла заданий: не указан файл с данными.").arg(iLine), TITLE_ARGUMENTS, "CBatchRunner::readJobsFile");
+
+      for (auto& fileData : files)
+         fileData = dir.filePath(fileData);
+
+      addJobs(files, job);
+   }
+}
+
+SJobResult CBatchRunner::runJob(const SJob& job_, int countThreads_)
+{
+   SJobResult result;
+   CGeneticAlgorithm algorithm;
+
+   // Алгоритм сообщает об ошибках сигналом, запоминаем первую.
+   QObject::connect(&algorithm, &CGeneticAlgorithm::signalError, [&result](const CException& error_)
+      {
+         if (result.error.isEmpty())
+            result.error = QString(error_.title()) + ". " + error_.what();
+      });
+
+   if (job_.bSeed)
+      algorithm.SetSeed(job_.seed);
+
+   result.seed = algorithm.GetSeed();
+
+   algorithm.SetLimitOfArgumentsChange(job_.limitOfArgumentsChange);
+   algorithm.SetCostAddingPredicate(job_.costAddingPredicate);
+   algorithm.SetStatsFile(job_.statsFile);
+   algorithm.SetTraceFile(job_.traceFile);
+   algorithm.SetTimeBudget(job_.timeBudget);
+   algorithm.SetLocalSearch(job_.countLocalSearch, job_.countLocalSearchNeighbors);
+   algorithm.SetInitialization(job_.initialization);
+   algorithm.SetScriptGenome(job_.bScriptGenome);
+   if (!result.error.isEmpty())
+      return result;
+
+   QElapsedTimer timer;
+   timer.start();
+
+   algorithm.FillDataInFile(job_.inputFile);
+   if (!result.error.isEmpty())
+      return result;
+
+   // Кэш в файле открывается после загрузки данных: имя файла - отпечаток хранилища.
+   std::shared_ptr<CEvaluationCache> cache;
+   if (!job_.cacheDir.isEmpty())
+   {
+      try
+      {
+         const quint64 fingerprint = algorithm.GetStorage().Fingerprint();
+         QDir().mkpath(job_.cacheDir);
+
+         cache = std::make_shared<CEvaluationCache>();
+         cache->Open(QDir(job_.cacheDir).filePath(QString("%1.cache").arg(fingerprint, 16, 16, QChar('0'))), fingerprint);
+         algorithm.SetEvaluationCache(cache);
+      }
+      catch (const CException& error)
+      {
+         result.error = QString(error.title()) + ". " + error.what();
+         return result;
+      }
+   }
+
+   result.loadTime = timer.restart();
+   result.countIndividuals = job_.countIndividuals;
+
+   if (job_.exactEdits >= 0)
+   {
+      algorithm.StartExact(job_.exactEdits, job_.exactCandidates, countThreads_);
+      result.runTime = timer.elapsed();
+      if (!result.error.isEmpty())
+         return result;
+
+      result.countIndividuals = 1;
+   }
+   else if (job_.beamWidth > 0)
+   {
+      algorithm.StartBeam(job_.beamWidth, job_.beamDepth, countThreads_);
+      result.runTime = timer.elapsed();
+      if (!result.error.isEmpty())
+         return result;
+
+      result.countIndividuals = job_.beamWidth;
+   }
+   else if (job_.bSweep)
+   {
+      CParameterSweep sweep;
+      SSweepSettings sweepSettings = job_.sweep;
+      sweepSettings.countThreads = countThreads_;
+
+      try
+      {
+         sweep.Run(algorithm, runSettings(job_, result.seed), sweepSettings);
+      }
+      catch (const CException& error)
+      {
+         if (result.error.isEmpty())
+            result.error = QString(error.title()) + ". " + error.what();
+      }
+
+      result.runTime = timer.elapsed();
+
+      QFile file(job_.sweepFile);
+      if (!sweep.Rows().empty() && file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+         file.write(sweep.StringTable().toUtf8());
+
+      if (!result.error.isEmpty())
+         return result;
+
+      // Результат - поколение лучшего запуска последней ступени.
+      const SRunSettings& best = algorithm.PortfolioRuns().at(algorithm.BestPortfolioRun()).settings;
+      result.seed = best.seed;
+      result.countIndividuals = best.countIndividuals;
+   }
+   else if (job_.countPortfolio > 0)
+   {
+      const SRunSettings base = runSettings(job_, result.seed);
+
+      std::vector<SRunSettings> vSettings(job_.countPortfolio, base);
+      for (size_t iRun = 0; iRun < vSettings.size(); ++iRun)
+      {
+         vSettings[iRun].seed = result.seed + static_cast<quint32>(iRun);
+         if (!job_.vPortfolioIndividuals.empty())
+            vSettings[iRun].countIndividuals = job_.vPortfolioIndividuals[iRun % job_.vPortfolioIndividuals.size()];
+         if (!job_.vPortfolioMutationArguments.empty())
+            vSettings[iRun].percentMutationArguments = job_.vPortfolioMutationArguments[iRun % job_.vPortfolioMutationArguments.size()];
+      }
+
+      algorithm.StartPortfolio(vSettings, countThreads_);
+      result.runTime = timer.elapsed();
+      if (!result.error.isEmpty())
+         return result;
+
+      result.bestRun = algorithm.BestPortfolioRun();
+      const SRunSettings& best = algorithm.PortfolioRuns().at(result.bestRun).settings;
+      result.seed = best.seed;
+      result.countIndividuals = best.countIndividuals;
+   }
+   else
+   {
+      algorithm.Start(job_.countIndividuals,
+         job_.countIterations,
+         job_.percentMutationArguments,
+         job_.countSkipMutationArg,
+         job_.percentMutationPredicates,
+         job_.countSkipMutationPred,
+         job_.percentIndividualsUndergoingMutation);
+      result.runTime = timer.elapsed();
+      if (!result.error.isEmpty())
+         return result;
+   }
+
+   result.bInterrupted = algorithm.WasInterrupted();
+   result.bestFitness = algorithm.BestFitness();
+   result.evaluation = algorithm.EvaluationStats().Total();
+
+   algorithm.WriteInFile(job_.outputFile, false, false, true, true, true, false, job_.countResults);
+
+   if (cache)
+   {
+      try
+      {
+         cache->Close();
+      }
+      catch (const CException& error)
+      {
+         if (result.error.isEmpty())
+            result.error = QString(error.title()) + ". " + error.what();
+      }
+   }
+
+   result.bSuccess = result.error.isEmpty();
+   return result;
+}
+
+SRunSettings CBatchRunner::runSettings(const SJob& job_, quint32 seed_)
+{
+   SRunSettings settings;
+   settings.seed = seed_;
+   settings.countIndividuals = job_.countIndividuals;
+   settings.countIterations = job_.countIterations;
+   settings.percentMutationArguments = job_.percentMutationArguments;
+   settings.countSkipMutationArg = job_.countSkipMutationArg;
+   settings.percentMutationPredicates = job_.percentMutationPredicates;
+   settings.countSkipMutationPred = job_.countSkipMutationPred;
+   settings.percentIndividualsUndergoingMutation = job_.percentIndividualsUndergoingMutation;
+   settings.limitOfArgumentsChange = job_.limitOfArgumentsChange;
+   settings.costAddingPredicate = job_.costAddingPredicate;
+   settings.countLocalSearch = job_.countLocalSearch;
+   return settings;
+}
@@ -0,0 +1,136 @@
+#pragma once
+#include <vector>
+
+#include <QString>
+#include <QStringList>
+
+#include "evaluation_counters.h"
+#include "parameter_sweep.h"
+
+class QCommandLineParser;
+
+// Задание - один запуск алгоритма на одном файле данных.
+// Значения по умолчанию совпадают со значениями в окне программы.
+struct SJob
+{
+   QString inputFile;  // файл с данными
+   QString outputFile; // файл для результата
+   QString resultFormat = "txt"; // формат файла результата ("txt", "jsonl", "bin")
+   QString statsFormat; // формат статистики поколений ("csv", "jsonl"), пусто - не записывать
+   QString statsFile;   // файл статистики поколений
+   bool bTrace = false; // записывать ли трассировку (Chrome trace_event)
+   QString traceFile;   // файл трассировки
+
+   int countIndividuals = 100;
+   int countIterations = 100;
+   double percentMutationArguments = 10;
+   int countSkipMutationArg = 5;
+   double percentMutationPredicates = 0;
+   int countSkipMutationPred = 0;
+   double percentIndividualsUndergoingMutation = 25;
+
+   double limitOfArgumentsChange = 0.75;
+   double costAddingPredicate = 0.2;
+
+   int countLocalSearch = 0;        // количество лучших особей для локального поиска (0 - без него)
+   int countLocalSearchNeighbors = 200; // наибольшее количество соседей одной особи
+
+   bool bScriptGenome = false; // особи - правки изначального ограничения (CGeneticAlgorithm::SetScriptGenome)
+   SInitialization initialization; // создание первого поколения
+
+   bool bSeed = false; // задано ли зерно (иначе - случайное)
+   quint32 seed = 0;
+
+   size_t countResults = 10; // количество лучших особей в файле результата
+   qint64 timeBudget = 0;    // ограничение времени работы алгоритма (мс), 0 - без ограничения
+
+   // Портфель запусков (CGeneticAlgorithm::StartPortfolio), 0 - один обычный запуск.
+   // Запуск i получает зерно seed + i, количество особей и процент мутаций аргументов по кругу из списков
+   // (пустой список - значение задания).
+   int countPortfolio = 0;
+   std::vector<int> vPortfolioIndividuals;
+   std::vector<double> vPortfolioMutationArguments;
+
+   // Перебор параметров (CParameterSweep) вместо одного запуска, таблица перебора пишется в sweepFile.
+   bool bSweep = false;
+   SSweepSettings sweep;
+   QString sweepFile;
+
+   // Точный поиск (CGeneticAlgorithm::StartExact) не более чем в exactEdits правках, -1 - генетический алгоритм.
+   int exactEdits = -1;
+   size_t exactCandidates = 200000; // наибольшее количество кандидатов на одно условие
+
+   // Поиск лучом (CGeneticAlgorithm::StartBeam) шириной beamWidth, 0 - генетический алгоритм.
+   int beamWidth = 0;
+   int beamDepth = 3;
+
+   // Каталог файлов кэша истинности условий (CEvaluationCache::Open), пусто - кэш только в памяти.
+   // Файл на каждый набор данных (по отпечатку хранилища), общий для заданий и запусков программы.
+   QString cacheDir;
+};
+
+// Результат выполнения задания.
+struct SJobResult
+{
+   bool bSuccess = false;
+   bool bInterrupted = false; // алгоритм остановлен по времени (результат - последнее полное поколение)
+   QString error;        // сообщение об ошибке
+   quint32 seed = 0;     // использованное зерно
+   qint64 loadTime = 0;  // время загрузки данных (мс)
+   qint64 runTime = 0;   // время работы алгоритма (мс)
+   double bestFitness = 0;
+   int countIndividuals = 0;     // количество особей запуска с результатом
+   size_t bestRun = SIZE_MAX;    // номер запуска портфеля с результатом (SIZE_MAX - без портфеля)
+   SEvaluationCounts evaluation; // счетчики проверки условий за запуск
+};
+
+// Пакетный запуск алгоритма без графического интерфейса.
+// Задания берутся из аргументов командной строки (по одному на каждый файл данных)
+// и из файла заданий (по одному на строку, формат строки - те же аргументы).
+// Задания выполняются параллельно, для каждого пишется файл результата и строка итоговой таблицы.
+class CBatchRunner
+{
+   std::vector<SJob> m_vJobs;
+   std::vector<SJobResult> m_vResults;
+
+   int m_countThreads = 0;  // 0 - по количеству ядер
+   QString m_outputDir;
+   QString m_summaryFile;
+
+public:
+
+   // Разбирает аргументы командной строки и файл заданий.
+   // При --help/--version выводит справку и завершает программу.
+   // !> exception при некорректных аргументах или ошибке чтения файла заданий.
+   void ParseArguments(const QStringList& arguments_);
+
+   // Выполняет все задания и записывает итоговую таблицу.
+   // Возвращает количество заданий, завершившихся с ошибкой.
+   size_t Run();
+
+   // Возвращает итоговую таблицу (значения разделены табуляцией).
+   QString StringSummary() const;
+
+private:
+
+   // Добавляет в parser_ параметры задания.
+   static void addJobOptions(QCommandLineParser& parser_);
+
+   // Заполняет параметры задания job_ из заданных в parser_ значений.
+   // !> exception при некорректном значении.
+   static void readJobOptions(const QCommandLineParser& parser_, SJob& job_);
+
+   // Добавляет задания для файлов files_ с параметрами job_.
+   void addJobs(const QStringList& files_, const SJob& job_);
+
+   // Считывает задания из файла fileName_. defaults_ - параметры по умолчанию.
+   // !> exception при ошибке чтения или некорректной строке.
+   void readJobsFile(const QString& fileName_, const SJob& defaults_);
+
+   // Выполняет одно задание. countThreads_ - количество потоков задания (для портфеля, подбора параметров,
+   // точного и лучевого поиска).
+   static SJobResult runJob(const SJob& job_, int countThreads_);
+
+   // Возвращает параметры запуска алгоритма из параметров задания job_ (зерно - seed_).
+   static SRunSettings runSettings(const SJob& job_, quint32 seed_);
+};
@@ -0,0 +1,25 @@
+#include <QCoreApplication>
+#include <QTextStream>
+
+#include "batch_runner.h"
+#include "exception.h"
+
+int main(int argc, char* argv[])
+{
+   QCoreApplication a(argc, argv);
+   QCoreApplication::setApplicationName("Masters_thesis_2_console");
+
+   CBatchRunner runner;
+
+   try
+   {
+      runner.ParseArguments(QCoreApplication::arguments());
+   }
+   catch (const CException& error)
+   {
+      QTextStream(stderr) << error.title() << ": " << error.what() << Qt::endl;
+      return 2;
+   }
+
+   return runner.Run() == 0 ? 0 : 1;
+}
@@ -0,0 +1,412 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#include <QIODevice>
+#include <QTextStream>
+
+#include "dataset_generator.h"
+#include "dataset_binary.h"
+#include "exception.h"
+#include "text_reader.h"
+
+// Наибольший размер таблицы истинности одного предиката.
+constexpr size_t MAX_TABLE_SIZE = size_t(1) << 32;
+
+// Количество переменных в одной строке раздела переменных текстового файла.
+constexpr size_t VARIABLES_PER_LINE = 16;
+
+// Возвращает имя с номером number_, дополненным нулями до количества цифр в count_ - 1.
+static QString numberedName(char prefix_, size_t number_, size_t count_)
+{
+   const int width = static_cast<int>(QString::number(qMax(count_, size_t(1)) - 1).size());
+   return QChar(prefix_) + QString("%1").arg(number_, width, 10, QChar('0'));
+}
+
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-= Методы класса =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+CDatasetGenerator::CDatasetGenerator(const SGeneratorSettings& settings_) : m_settings(settings_)
+{
+}
+
+void CDatasetGenerator::Generate()
+{
+   checkSettings();
+
+   m_rand.SetSeed(m_settings.seed);
+   m_storage.Clear();
+   m_vPlanted.clear();
+
+   // Имена с ведущими нулями, поэтому порядок переменных в хранилище совпадает с номерами.
+   std::vector<QString> vVariables(m_settings.countConstants);
+   for (size_t iVar = 0; iVar < vVariables.size(); ++iVar)
+      vVariables[iVar] = numberedName('c', iVar, vVariables.size());
+
+   std::vector<SPredicate> vTables(m_settings.countRelations);
+   std::vector<size_t> vArity(m_settings.countRelations);
+   for (size_t iRel = 0; iRel < vTables.size(); ++iRel)
+   {
+      vArity[iRel] = m_rand.Generate(m_settings.minArity, m_settings.maxArity);
+      vTables[iRel] = generateTable(vArity[iRel]);
+   }
+
+   // Правая часть условия - предикат, не встречавшийся в предыдущих условиях,
+   // поэтому заложенные ранее условия не нарушаются.
+   std::vector<bool> vUsed(m_settings.countRelations, false);
+   for (size_t iCond = 0; iCond < m_settings.countConstraints; ++iCond)
+   {
+      std::vector<size_t> vLeft(m_settings.countLeftPredicates);
+      for (size_t& idxLeft : vLeft)
+         idxLeft = m_rand.Generate(0, m_settings.countRelations - 1);
+
+      std::vector<size_t> vCandidates;
+      for (size_t iRel = 0; iRel < m_settings.countRelations; ++iRel)
+         if (!vUsed[iRel] && std::find(vLeft.begin(), vLeft.end(), iRel) == vLeft.end())
+            vCandidates.push_back(iRel);
+
+      if (vCandidates.empty())
+         throw CException(QString("Недостаточно предикатов для %1 заложенных условий.").arg(m_settings.countConstraints), "Ошибка генерации данных", "CDatasetGenerator::Generate");
+
+      const size_t idxRight = vCandidates[m_rand.Generate(0, vCandidates.size() - 1)];
+
+      SPlantedCondition planted;
+      planted.condition = generateCondition(vLeft, idxRight, vArity);
+      plantCondition(planted, vTables);
+      m_vPlanted.push_back(std::move(planted));
+
+      for (size_t idxLeft : vLeft)
+         vUsed[idxLeft] = true;
+
+      vUsed[idxRight] = true;
+   }
+
+   m_storage.SetVariables(vVariables);
+   for (size_t iRel = 0; iRel < vTables.size(); ++iRel)
+      m_storage.AddPredicate(numberedName('R', iRel, vTables.size()), std::move(vTables[iRel]));
+}
+
+const CPredicatesStorage& CDatasetGenerator::GetStorage() const
+{
+   return m_storage;
+}
+
+const std::vector<SPlantedCondition>& CDatasetGenerator::GetPlanted() const
+{
+   return m_vPlanted;
+}
+
+QString CDatasetGenerator::StringConditions() const
+{
+   CParserTemplatePredicates parser(&m_storage);
+   QString str;
+
+   for (const auto& planted : m_vPlanted)
+   {
+      for (const auto& predTempl : planted.condition.left)
+         str += parser.GetStringTemplatePredicate(predTempl) + ' ';
+
+      str.append("->");
+
+      for (const auto& predTempl : planted.condition.right)
+         str += ' ' + parser.GetStringTemplatePredicate(predTempl);
+
+      str.append(";\n");
+   }
+
+   return str;
+}
+
+QString CDatasetGenerator::StringReport() const
+{
+   size_t countTrue = 0, countValues = 0;
+   for (size_t iPred = 0; iPred < m_storage.CountPredicates(); ++iPred)
+   {
+      const std::vector<bool>& table = m_storage.GetPredicate(iPred).table;
+      countTrue += std::count(table.begin(), table.end(), true);
+      countValues += table.size();
+   }
+
+   QString str = QString("Переменных: %1, предикатов: %2, истинных значений: %3 из %4 (%5%).\n")
+      .arg(m_storage.CountVariables())
+      .arg(m_storage.CountPredicates())
+      .arg(countTrue)
+      .arg(countValues)
+      .arg(countValues > 0 ? 100. * countTrue / countValues : 0., 0, 'f', 2);
+
+   const QStringList conditions = StringConditions().split('\n', Qt::SkipEmptyParts);
+   for (size_t iCond = 0; iCond < m_vPlanted.size(); ++iCond)
+   {
+      str += QString("%1 следствий: %2, нарушено: %3.\n")
+         .arg(conditions.at(static_cast<qsizetype>(iCond)))
+         .arg(m_vPlanted[iCond].countImplied)
+         .arg(m_vPlanted[iCond].countViolated);
+   }
+
+   return str;
+}
+
+void CDatasetGenerator::WriteText(QIODevice* device_) const
+{
+   QTextStream out(device_);
+   out.setEncoding(QStringConverter::Utf8);
+
+   const CSymbolTable& variables = m_storage.GetVariables();
+   for (size_t iVar = 0; iVar < variables.Size(); ++iVar)
+   {
+      out << variables.Name(iVar);
+      if (iVar + 1 < variables.Size())
+         out << ((iVar + 1) % VARIABLES_PER_LINE == 0 ? ",\n" : ", ");
+   }
+
+   out << "\n\n" << SYMBOL_SECTION_SEPARATOR << "\n\n";
+
+   for (size_t iPred = 0; iPred < m_storage.CountPredicates(); ++iPred)
+   {
+      const std::vector<bool>& table = m_storage.GetPredicate(iPred).table;
+      const size_t countArg = m_storage.CountArguments(iPred);
+
+      out << m_storage.GetPredicateName(iPred) << '(' << countArg << ")\n";
+
+      std::vector<size_t> vArgs(countArg, 0);
+      for (size_t iArg = 0; iArg < table.size(); ++iArg)
+      {
+         if (table[iArg])
+         {
+            for (size_t i = 0; i < countArg; ++i)
+               out << variables.Name(vArgs[i]) << (i + 1 < countArg ? ", " : "\n");
+         }
+
+         // следующий набор аргументов (по порядку таблицы истинности)
+         for (size_t i = countArg; i-- > 0;)
+         {
+            if (++vArgs[i] < variables.Size())
+               break;
+
+            vArgs[i] = 0;
+         }
+      }
+
+      out << '\n';
+   }
+
+   out << SYMBOL_SECTION_SEPARATOR << "\n\n" << StringConditions();
+   out.flush();
+
+   if (out.status() != QTextStream::Ok)
+      throw CException("Ошибка записи текстового файла данных.", "Ошибка сохранения данных", "CDatasetGenerator::WriteText");
+}
+
+void CDatasetGenerator::WriteBinary(QIODevice* device_) const
+{
+   WriteBinaryDataset(device_, m_storage, StringConditions());
+}
+
+void CDatasetGenerator::checkSettings() const
+{
+   QString error;
+
+   if (m_settings.countConstants < 2)
+      error = "Количество переменных должно быть не меньше 2.";
+   else if (m_settings.countRelations < 1)
+      error = "Количество предикатов должно быть не меньше 1.";
+   else if (m_settings.minArity < 1 || m_settings.minArity > m_settings.maxArity)
+      error = "Некорректное количество аргументов предикатов.";
+   else if (m_settings.density < 0 || m_settings.density > 1)
+      error = "Плотность должна быть в пределах [0; 1].";
+   else if (m_settings.skew < 0)
+      error = "Показатель распределения Ципфа должен быть неотрицательным.";
+   else if (m_settings.violationRate < 0 || m_settings.violationRate > 1)
+      error = "Доля нарушений должна быть в пределах [0; 1].";
+   else if (m_settings.countConstraints > 0 && (m_settings.countLeftPredicates < 1 || m_settings.countTemplateVariables < 1))
+      error = "В условии должен быть хотя бы один предикат и одна переменная шаблона в левой части.";
+   else if (m_settings.countTemplateVariables > m_settings.countConstants)
+      error = "Переменных шаблона не может быть больше, чем переменных.";
+
+   size_t tableSize = 1;
+   for (size_t iArg = 0; iArg < m_settings.maxArity && error.isEmpty(); ++iArg)
+   {
+      tableSize *= m_settings.countConstants;
+      if (tableSize > MAX_TABLE_SIZE)
+         error = QString("Таблица истинности больше %1 значений.").arg(MAX_TABLE_SIZE);
+   }
+
+   if (!error.isEmpty())
+      throw CException(error, "Ошибка параметров генерации", "CDatasetGenerator::checkSettings");
+}
+
+double CDatasetGenerator::uniform()
+{
+   constexpr quint64 MAX_VALUE = (quint64(1) << 53) - 1;
+   return static_cast<double>(m_rand.Generate(0, MAX_VALUE)) / static_cast<double>(MAX_VALUE + 1);
+}
+
+SPredicate CDatasetGenerator::generateTable(size_t arity_)
+{
+   const size_t countVariables = m_settings.countConstants;
+
+   // Веса рангов по Ципфу, нормированные к среднему 1: при skew = 0 все веса равны 1.
+   std::vector<double> vZipf(countVariables);
+   double sum = 0;
+   for (size_t rank = 0; rank < countVariables; ++rank)
+      sum += vZipf[rank] = 1. / std::pow(static_cast<double>(rank + 1), m_settings.skew);
+
+   for (double& weight : vZipf)
+      weight *= countVariables / sum;
+
+   // У каждого столбца свои частые значения.
+   std::vector<std::vector<double>> vWeights(arity_, vZipf);
+   for (auto& vColumn : vWeights)
+      for (size_t i = countVariables - 1; i > 0; --i)
+         std::swap(vColumn[i], vColumn[m_rand.Generate(0, i)]);
+
+   size_t tableSize = 1;
+   for (size_t iArg = 0; iArg < arity_; ++iArg)
+      tableSize *= countVariables;
+
+   SPredicate predicate;
+   predicate.table.assign(tableSize, false);
+
+   std::vector<size_t> vArgs(arity_, 0);
+   for (size_t index = 0; index < tableSize; ++index)
+   {
+      double probability = m_settings.density;
+      for (size_t iArg = 0; iArg < arity_; ++iArg)
+         probability *= vWeights[iArg][vArgs[iArg]];
+
+      predicate.table[index] = uniform() < probability;
+
+      for (size_t iArg = arity_; iArg-- > 0;)
+      {
+         if (++vArgs[iArg] < countVariables)
+            break;
+
+         vArgs[iArg] = 0;
+      }
+   }
+
+   return predicate;
+}
+
+SCondition CDatasetGenerator::generateCondition(const std::vector<size_t>& vLeft_, size_t idxRight_, const std::vector<size_t>& vArity_)
+{
+   size_t sumArity = 0;
+   for (size_t idxLeft : vLeft_)
+      sumArity += vArity_[idxLeft];
+
+   const int countTemplate = static_cast<int>(qMin(m_settings.countTemplateVariables, sumArity));
+
+   // Сначала используются еще не встречавшиеся переменные шаблона (по порядку), затем случайные,
+   // поэтому предикаты левой части связаны общими переменными.
+   SCondition cond;
+   int nextArgument = 0;
+   for (size_t idxLeft : vLeft_)
+   {
+      SPredicateTemplate predTempl;
+      predTempl.idxPredicate = idxLeft;
+      predTempl.arguments.resize(vArity_[idxLeft]);
+
+      for (int& arg : predTempl.arguments)
+         arg = nextArgument < countTemplate ? nextArgument++ : static_cast<int>(m_rand.Generate(0, countTemplate - 1));
+
+      cond.left.push_back(std::move(predTempl));
+   }
+
+   // В правой части - только переменные левой, по возможности различные.
+   std::vector<int> vTemplate(countTemplate);
+   for (int i = 0; i < countTemplate; ++i)
+      vTemplate[i] = i;
+
+   for (size_t i = vTemplate.size() - 1; i > 0; --i)
+      std::swap(vTemplate[i], vTemplate[m_rand.Generate(0, i)]);
+
+   SPredicateTemplate predTempl;
+   predTempl.idxPredicate = idxRight_;
+   predTempl.arguments.resize(vArity_[idxRight_]);
+   for (size_t iArg = 0; iArg < predTempl.arguments.size(); ++iArg)
+      predTempl.arguments[iArg] = iArg < vTemplate.size() ? vTemplate[iArg] : static_cast<int>(m_rand.Generate(0, countTemplate - 1));
+
+   cond.right.push_back(std::move(predTempl));
+
+   cond.RecalculateMaximum();
+   return cond;
+}
+
+void CDatasetGenerator::plantCondition(SPlantedCondition& planted_, std::vector<SPredicate>& vTables_)
+{
+   const SCondition& cond = planted_.condition;
+   const SPredicateTemplate& right = cond.right.front();
+   const size_t countVariables = m_settings.countConstants;
+
+   // Подстановки без повторов (как в CGeneticAlgorithm::IsTrueCondition), при которых левая часть истинна.
+   // Перебор с возвратом: переменные шаблона связываются по мере обхода аргументов левой части.
+   std::vector<size_t> vValues(cond.maxArgument + 1, SIZE_MAX);
+   std::vector<bool> vTaken(countVariables, false);
+   std::vector<bool> vImplied(vTables_[right.idxPredicate].table.size(), false);
+   std::vector<size_t> vArgs;
+
+   std::function<void(size_t, size_t)> bind = [&](size_t iPred_, size_t iArg_)
+      {
+         if (iPred_ == cond.left.size())
+         {
+            vArgs.resize(right.arguments.size());
+            for (size_t iArg = 0; iArg < vArgs.size(); ++iArg)
+               vArgs[iArg] = vValues[right.arguments[iArg]];
+
+            vImplied[GetIndex(countVariables, vArgs)] = true;
+            return;
+         }
+
+         const SPredicateTemplate& predTempl = cond.left[iPred_];
+
+         if (iArg_ == predTempl.arguments.size())
+         {
+            vArgs.resize(predTempl.arguments.size());
+            for (size_t iArg = 0; iArg < vArgs.size(); ++iArg)
+               vArgs[iArg] = vValues[predTempl.arguments[iArg]];
+
+            if (vTables_[predTempl.idxPredicate].table[GetIndex(countVariables, vArgs)])
+               bind(iPred_ + 1, 0);
+
+            return;
+         }
+
+         size_t& value = vValues[predTempl.arguments[iArg_]];
+         if (value != SIZE_MAX)
+         {
+            bind(iPred_, iArg_ + 1);
+            return;
+         }
+
+         for (size_t iVar = 0; iVar < countVariables; ++iVar)
+         {
+            if (vTaken[iVar])
+               continue;
+
+            value = iVar;
+            vTaken[iVar] = true;
+            bind(iPred_, iArg_ + 1);
+            vTaken[iVar] = false;
+         }
+
+         value = SIZE_MAX;
+      };
+
+   bind(0, 0);
+
+   std::vector<bool>& table = vTables_[right.idxPredicate].table;
+   for (size_t index = 0; index < vImplied.size(); ++index)
+   {
+      if (!vImplied[index])
+         continue;
+
+      ++planted_.countImplied;
+
+      if (uniform() < m_settings.violationRate)
+      {
+         table[index] = false;
+         ++planted_.countViolated;
+      }
+      else
+         table[index] = true;
+   }
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <vector>
+
+#include <QString>
+
+#include "predicate.h"
+#include "parser_template_predicates.h"
+#include "random.h"
+
+class QIODevice;
+
+// Параметры генерации набора данных.
+struct SGeneratorSettings
+{
+   size_t countConstants = 100;  // количество переменных (констант)
+   size_t countRelations = 10;   // количество предикатов (отношений)
+   size_t minArity = 1;          // наименьшее количество аргументов предиката
+   size_t maxArity = 2;          // наибольшее количество аргументов предиката
+   double density = 0.05;        // ожидаемая доля истинных значений в таблице истинности
+   double skew = 0;              // показатель распределения Ципфа значений в столбцах (0 - равномерное)
+
+   size_t countConstraints = 1;       // количество заложенных условий целостности
+   size_t countLeftPredicates = 2;    // количество предикатов в левой части условия
+   size_t countTemplateVariables = 3; // количество переменных шаблона в условии
+   double violationRate = 0;          // доля нарушенных следствий заложенных условий [0; 1]
+
+   quint32 seed = 1;
+};
+
+// Сведения о заложенном условии.
+struct SPlantedCondition
+{
+   SCondition condition;
+   size_t countImplied = 0;  // количество значений правой части, следующих из левой
+   size_t countViolated = 0; // из них сделано ложными
+};
+
+// Генератор синтетических наборов данных для замеров на больших объемах.
+// Таблицы истинности заполняются случайно с заданной плотностью, значения в столбцах
+// распределены по Ципфу (у каждого столбца своя перестановка частых значений).
+// Заложенные условия имеют вид P(..) Q(..) -> R(..), где R - предикат, не встречающийся
+// в предыдущих условиях. Для каждого значения R, следующего из левой части, значение
+// делается ложным с вероятностью violationRate, иначе истинным.
+// Результат определяется параметрами и зерном.
+class CDatasetGenerator
+{
+   SGeneratorSettings m_settings;
+   CRandom m_rand;
+
+   CPredicatesStorage m_storage;
+   std::vector<SPlantedCondition> m_vPlanted;
+
+public:
+
+   explicit CDatasetGenerator(const SGeneratorSettings& settings_);
+
+   // Генерирует набор данных.
+   // !> exception при некорректных параметрах.
+   void Generate();
+
+   const CPredicatesStorage& GetStorage() const;
+   const std::vector<SPlantedCondition>& GetPlanted() const;
+
+   // Возвращает текст раздела условий целостности.
+   QString StringConditions() const;
+
+   // Возвращает краткий отчет о сгенерированных данных.
+   QString StringReport() const;
+
+   // Записывает набор данных в текстовом формате ('$' между разделами).
+   // !> exception при ошибке записи.
+   void WriteText(QIODevice* device_) const;
+
+   // Записывает набор данных в двоичном формате (dataset_binary.h).
+   // !> exception при ошибке записи.
+   void WriteBinary(QIODevice* device_) const;
+
+private:
+
+   // Проверяет параметры генерации.
+   // !> exception при некорректных параметрах.
+   void checkSettings() const;
+
+   // Возвращает случайное число из [0; 1).
+   double uniform();
+
+   // Возвращает таблицу истинности предиката с arity_ аргументами.
+   SPredicate generateTable(size_t arity_);
+
+   // Возвращает условие с предикатами vLeft_ в левой части и предикатом idxRight_ в правой.
+   // vArity_ - количества аргументов предикатов. Правая часть использует только переменные левой.
+   SCondition generateCondition(const std::vector<size_t>& vLeft_, size_t idxRight_, const std::vector<size_t>& vArity_);
+
+   // Делает условие planted_ истинным на таблицах vTables_ (кроме доли violationRate следствий).
+   void plantCondition(SPlantedCondition& planted_, std::vector<SPredicate>& vTables_);
+};
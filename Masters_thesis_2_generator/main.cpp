@@ -0,0 +1,124 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QTextStream>
+
+#include <limits>
+
+#include "dataset_generator.h"
+#include "exception.h"
+
+// Возвращает целое значение параметра name_.
+// !> exception при некорректном значении.
+static size_t readSize(const QCommandLineParser& parser_, const QString& name_)
+{
+   bool bOk = false;
+   const size_t value = parser_.value(name_).toULongLong(&bOk);
+   if (!bOk)
+      throw CException("Некорректное значение параметра --" + name_ + ": " + parser_.value(name_), "Ошибка аргументов", "readSize");
+
+   return value;
+}
+
+// Возвращает зерно генератора из параметра name_.
+// !> exception при значении вне диапазона quint32 (иначе разные зерна дали бы один набор).
+static quint32 readSeed(const QCommandLineParser& parser_, const QString& name_)
+{
+   const size_t value = readSize(parser_, name_);
+   if (value > std::numeric_limits<quint32>::max())
+      throw CException("Некорректное значение параметра --" + name_ + ": " + parser_.value(name_), "Ошибка аргументов", "readSeed");
+
+   return static_cast<quint32>(value);
+}
+
+// Возвращает вещественное значение параметра name_.
+// !> exception при некорректном значении.
+static double readDouble(const QCommandLineParser& parser_, const QString& name_)
+{
+   bool bOk = false;
+   const double value = parser_.value(name_).toDouble(&bOk);
+   if (!bOk)
+      throw CException("Некорректное значение параметра --" + name_ + ": " + parser_.value(name_), "Ошибка аргументов", "readDouble");
+
+   return value;
+}
+
+int main(int argc, char* argv[])
+{
+   QCoreApplication a(argc, argv);
+   QCoreApplication::setApplicationName("Masters_thesis_2_generator");
+
+   const SGeneratorSettings defaults;
+
+   QCommandLineParser parser;
+   parser.setApplicationDescription("Генерация синтетических наборов данных (переменные $ предикаты $ условия целостности).");
+   parser.addHelpOption();
+   parser.addOptions({
+      { { "o", "output" }, "Файл для записи набора данных.", "file" },
+      { "binary", "Записать в двоичном формате." },
+      { "constants", "Количество переменных (констант).", "count", QString::number(defaults.countConstants) },
+      { "relations", "Количество предикатов.", "count", QString::number(defaults.countRelations) },
+      { "min-arity", "Наименьшее количество аргументов предиката.", "count", QString::number(defaults.minArity) },
+      { "max-arity", "Наибольшее количество аргументов предиката.", "count", QString::number(defaults.maxArity) },
+      { "density", "Доля истинных значений в таблицах истинности [0; 1].", "ratio", QString::number(defaults.density) },
+      { "skew", "Показатель распределения Ципфа значений в столбцах (0 - равномерное).", "s", QString::number(defaults.skew) },
+      { "constraints", "Количество заложенных условий целостности.", "count", QString::number(defaults.countConstraints) },
+      { "left-predicates", "Количество предикатов в левой части условия.", "count", QString::number(defaults.countLeftPredicates) },
+      { "template-variables", "Количество переменных шаблона в условии.", "count", QString::number(defaults.countTemplateVariables) },
+      { "violation-rate", "Доля нарушенных следствий заложенных условий [0; 1].", "ratio", QString::number(defaults.violationRate) },
+      { { "s", "seed" }, "Зерно генератора случайных чисел.", "seed", QString::number(defaults.seed) },
+   });
+   parser.process(a);
+
+   if (!parser.isSet("output"))
+   {
+      QTextStream(stderr) << "Не задан файл для записи (--output)." << Qt::endl;
+      return 2;
+   }
+
+   SGeneratorSettings settings;
+
+   try
+   {
+      settings.countConstants = readSize(parser, "constants");
+      settings.countRelations = readSize(parser, "relations");
+      settings.minArity = readSize(parser, "min-arity");
+      settings.maxArity = readSize(parser, "max-arity");
+      settings.density = readDouble(parser, "density");
+      settings.skew = readDouble(parser, "skew");
+      settings.countConstraints = readSize(parser, "constraints");
+      settings.countLeftPredicates = readSize(parser, "left-predicates");
+      settings.countTemplateVariables = readSize(parser, "template-variables");
+      settings.violationRate = readDouble(parser, "violation-rate");
+      settings.seed = readSeed(parser, "seed");
+   }
+   catch (const CException& error)
+   {
+      QTextStream(stderr) << error.title() << ": " << error.what() << Qt::endl;
+      return 2;
+   }
+
+   try
+   {
+      CDatasetGenerator generator(settings);
+      generator.Generate();
+
+      QFile file(parser.value("output"));
+      if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+         throw CException("Не удалось открыть файл: " + parser.value("output"), "Ошибка сохранения данных", "main");
+
+      if (parser.isSet("binary"))
+         generator.WriteBinary(&file);
+      else
+         generator.WriteText(&file);
+
+      QTextStream(stdout) << generator.StringReport();
+   }
+   catch (const CException& error)
+   {
+      QTextStream(stderr) << error.title() << ": " << error.what() << Qt::endl;
+      return 1;
+   }
+
+   return 0;
+}